@@ -0,0 +1,258 @@
+// Times parts of the bot that can be measured without a game, on a made up game held in a
+// GameData of our own instead of one shared with StarCraft or the replay server. Each
+// benchmark prints what it computed along with the time it took, so that a change in
+// speed can be checked against a change in results.
+//
+// Usage: benchmark
+
+#include "BuildPlanner.h"
+#include "CombatSimulator.h"
+#include "Tools.h"
+
+#include <BWAPI/Client.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// A game with an empty map and two players, our Protoss and a Terran enemy, into which
+// units can be placed before the match starts.
+class FakeGame {
+private:
+    std::unique_ptr<bw::GameData> m_data;
+    std::unique_ptr<bw::GameImpl> m_game;
+
+public:
+    static constexpr int MAP_SIZE = 128;
+
+    FakeGame() :
+            m_data(std::make_unique<bw::GameData>()) {
+        bw::GameData& data = *m_data;
+        std::memset(static_cast<void*>(&data), 0, sizeof(data));
+
+        data.mapWidth = MAP_SIZE;
+        data.mapHeight = MAP_SIZE;
+        data.playerCount = 3;
+        data.self = 0;
+        data.enemy = 1;
+        data.neutral = 2;
+        data.players[0].type = bw::Races::Protoss;
+        data.players[1].type = bw::Races::Terran;
+        data.players[2].isNeutral = true;
+    }
+
+    // Adds a complete unit with full health, returning its ID.
+    int addUnit(bw::UnitType type, int x, int y, int player) {
+        bw::GameData& data = *m_data;
+        int id = data.initialUnitCount++;
+
+        bw::UnitData& unit = data.units[id];
+        unit.id = id;
+        unit.exists = true;
+        unit.type = type;
+        unit.player = player;
+        unit.isCompleted = true;
+        unit.positionX = x;
+        unit.positionY = y;
+        unit.hitPoints = type.maxHitPoints();
+        unit.shields = type.maxShields();
+        // Carriers and reavers start with as many interceptors and scarabs as they can hold
+        // without upgrades.
+        unit.interceptorCount = type == bw::UnitTypes::Protoss_Carrier ? 4 : 0;
+        unit.scarabCount = type == bw::UnitTypes::Protoss_Reaver ? 5 : 0;
+        unit.transport = unit.carrier = unit.hatchery = unit.addon = unit.buildUnit = -1;
+        unit.target = unit.orderTarget = unit.rallyUnit = unit.nydusExit = unit.powerUp = -1;
+        return id;
+    }
+
+    // Starts the match, after which the units can be looked up.
+    void start() {
+        bw::BWAPIClient.data = m_data.get();
+        m_game = std::make_unique<bw::GameImpl>(m_data.get());
+        bw::BroodwarPtr = m_game.get();
+        m_game->onMatchStart();
+        g_self = m_game->self();
+    }
+
+    bw::Unit getUnit(int id) const {
+        return m_game->getUnit(id);
+    }
+};
+
+// Runs a function as many times as fit in about a second, returning the average time in
+// microseconds.
+static double timeRuns(const std::function<void()>& run) {
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0;
+
+    while (elapsed < 1e6 || runs < 3) {
+        run();
+        runs++;
+        elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    return elapsed / runs;
+}
+
+static void benchmarkSimulator() {
+    std::printf("Combat simulator\n");
+
+    struct Army {
+        bw::UnitType type;
+        int count;
+        int side;
+    };
+    struct Fight {
+        const char* name;
+        std::vector<Army> armies;
+    };
+
+    const Fight fights[] = {
+        { "10 zealots vs 10 marines", {
+            { bw::UnitTypes::Protoss_Zealot, 10, 0 },
+            { bw::UnitTypes::Terran_Marine, 10, 1 } } },
+        { "40 dragoons vs 40 marines", {
+            { bw::UnitTypes::Protoss_Dragoon, 40, 0 },
+            { bw::UnitTypes::Terran_Marine, 40, 1 } } },
+        { "4 reavers vs 30 marines", {
+            { bw::UnitTypes::Protoss_Reaver, 4, 0 },
+            { bw::UnitTypes::Terran_Marine, 30, 1 } } },
+        { "6 carriers vs 4 bunkers", {
+            { bw::UnitTypes::Protoss_Carrier, 6, 0 },
+            { bw::UnitTypes::Terran_Bunker, 4, 1 } } },
+    };
+
+    for (const Fight& fight : fights) {
+        // The sides start a few hundred pixels apart, each side in a block of its own.
+        FakeGame game;
+        std::vector<std::pair<int, int>> ids;
+        for (const Army& army : fight.armies) {
+            int y = army.side == 0 ? 1000 : 1400;
+            for (int i = 0; i < army.count; i++) {
+                int id = game.addUnit(army.type, 1000 + i % 10 * 40, y + i / 10 * 40, army.side);
+                ids.push_back({ id, army.side });
+            }
+        }
+        game.start();
+
+        CombatSimulator simulator;
+        for (auto [id, side] : ids) {
+            simulator.addUnit(game.getUnit(id), side);
+        }
+
+        CombatSimulator::Result result;
+        double time = timeRuns([&]() { result = simulator.simulate(24 * 60); });
+
+        std::printf("  %-28s %4d frames, survivors %2d vs %2d, value %5d/%5d vs %5d/%5d, %8.1f us\n",
+            fight.name, result.frames, result.survivors[0], result.survivors[1],
+            result.endValue[0], result.startValue[0], result.endValue[1], result.startValue[1], time);
+    }
+}
+
+// The state of the game at the start of a match, with a depot and some workers gathering
+// from eight mineral patches.
+static BuildPlanner::Snapshot startingSnapshot(bw::Race race, int workers) {
+    BuildPlanner::Snapshot snapshot;
+    snapshot.minerals = 50;
+    snapshot.supplyUsed = workers * 2;
+    snapshot.supplyTotal = 18;
+    snapshot.patches = 8;
+    snapshot.mineralWorkers = workers;
+
+    snapshot.units.push_back({ race.getResourceDepot(), 0, 0 });
+    for (int i = 0; i < workers; i++) {
+        snapshot.units.push_back({ race.getWorker(), 0, 0 });
+    }
+    if (race == bw::Races::Zerg) {
+        snapshot.units.push_back({ bw::UnitTypes::Zerg_Overlord, 0, 0 });
+    }
+
+    return snapshot;
+}
+
+static void benchmarkPlanner() {
+    std::printf("Build planner\n");
+
+    struct Case {
+        const char* name;
+        BuildPlanner::Snapshot snapshot;
+        BuildPlanner::Goal goal;
+    };
+
+    // A game a few minutes in, with a gateway and a zealot out already.
+    BuildPlanner::Snapshot midGame = startingSnapshot(bw::Races::Protoss, 14);
+    midGame.frame = 4000;
+    midGame.minerals = 200;
+    midGame.supplyUsed += 4;
+    midGame.supplyTotal = 34;
+    midGame.units.push_back({ bw::UnitTypes::Protoss_Pylon, 0, 0 });
+    midGame.units.push_back({ bw::UnitTypes::Protoss_Gateway, 0, 0 });
+    midGame.units.push_back({ bw::UnitTypes::Protoss_Zealot, 0, 0 });
+
+    // The goals that the Protoss strategy sets as the game goes on: a gateway once there
+    // are 11 workers, and then a second gateway and a dragoon once zealots are out.
+    BuildPlanner::Snapshot firstGateway = startingSnapshot(bw::Races::Protoss, 11);
+    firstGateway.frame = 2000;
+    firstGateway.minerals = 100;
+    firstGateway.supplyTotal = 34;
+    firstGateway.units.push_back({ bw::UnitTypes::Protoss_Pylon, 0, 0 });
+
+    BuildPlanner::Snapshot firstDragoon = startingSnapshot(bw::Races::Protoss, 14);
+    firstDragoon.frame = 4500;
+    firstDragoon.minerals = 150;
+    firstDragoon.supplyUsed += 4 * 4;
+    firstDragoon.supplyTotal = 50;
+    firstDragoon.units.push_back({ bw::UnitTypes::Protoss_Pylon, 0, 0 });
+    firstDragoon.units.push_back({ bw::UnitTypes::Protoss_Pylon, 0, 0 });
+    firstDragoon.units.push_back({ bw::UnitTypes::Protoss_Gateway, 0, 0 });
+    for (int i = 0; i < 4; i++) {
+        firstDragoon.units.push_back({ bw::UnitTypes::Protoss_Zealot, 0, 0 });
+    }
+
+    const Case cases[] = {
+        { "1 gateway at 11 workers", firstGateway, {
+            { bw::UnitTypes::Protoss_Gateway, 1 } } },
+        { "2 gateways 1 dragoon after zealots", firstDragoon, {
+            { bw::UnitTypes::Protoss_Gateway, 2 },
+            { bw::UnitTypes::Protoss_Dragoon, 1 } } },
+        { "2 gateways 4 zealots", startingSnapshot(bw::Races::Protoss, 4), {
+            { bw::UnitTypes::Protoss_Gateway, 2 },
+            { bw::UnitTypes::Protoss_Zealot, 4 } } },
+        { "3 gateways 4 dragoons 4 zealots", startingSnapshot(bw::Races::Protoss, 4), {
+            { bw::UnitTypes::Protoss_Gateway, 3 },
+            { bw::UnitTypes::Protoss_Dragoon, 4 },
+            { bw::UnitTypes::Protoss_Zealot, 4 } } },
+        { "2 dragoons from mid game", midGame, {
+            { bw::UnitTypes::Protoss_Dragoon, 2 } } },
+        { "2 barracks 6 marines", startingSnapshot(bw::Races::Terran, 4), {
+            { bw::UnitTypes::Terran_Barracks, 2 },
+            { bw::UnitTypes::Terran_Marine, 6 } } },
+        { "2 siege tanks", startingSnapshot(bw::Races::Terran, 4), {
+            { bw::UnitTypes::Terran_Siege_Tank_Tank_Mode, 2 } } },
+        { "4 mutalisks", startingSnapshot(bw::Races::Zerg, 4), {
+            { bw::UnitTypes::Zerg_Mutalisk, 4 } } },
+    };
+
+    // The planner keeps its memory between plans, as it does in the bot.
+    BuildPlanner planner;
+    for (const Case& test : cases) {
+        BuildPlanner::Plan plan;
+        double time = timeRuns([&]() { plan = planner.plan(test.snapshot, test.goal); });
+
+        std::printf("  %-34s finish %5d, %2d steps, %4d nodes, %8.1f us\n",
+            test.name, plan.finishFrame, (int)plan.steps.size(), plan.nodes, time);
+    }
+}
+
+int main() {
+    benchmarkSimulator();
+    benchmarkPlanner();
+    return 0;
+}
@@ -1,5 +1,7 @@
+#ifdef _WIN32
 #include <BWAPI/Client/Client.h>
 #include <windows.h>
+#include <cstdlib>
 #include <sstream>
 #include <iostream>
 #include <cassert>
@@ -141,6 +143,13 @@ namespace BWAPI
       }
     }
     
+    // If requested, keep a copy of every frame so the game can be replayed natively.
+    if ( const char* recordPath = std::getenv("BWAPI_RECORD_FRAMES") )
+    {
+      if ( recorder.open(recordPath) )
+        recorder.recordFrame(*data);
+    }
+
     std::cout << "Connection successful" << std::endl;
     assert( BWAPI::BroodwarPtr != nullptr);
 
@@ -163,6 +172,8 @@ namespace BWAPI
       CloseHandle(mapFileHandle);
     mapFileHandle = INVALID_HANDLE_VALUE;
 
+    recorder.close();
+
     this->connected = false;
     std::cout << "Disconnected" << std::endl;
 
@@ -190,6 +201,7 @@ namespace BWAPI
       }
     }
     //std::cout << "about to enter event loop" << std::endl;
+    recorder.recordFrame(*data);
 
     for(int i = 0; i < data->eventCount; ++i)
     {
@@ -204,3 +216,4 @@ namespace BWAPI
       static_cast<GameImpl*>(BWAPI::BroodwarPtr)->onMatchEnd();
   }
 }
+#endif
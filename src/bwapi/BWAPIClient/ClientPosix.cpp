@@ -0,0 +1,228 @@
+#ifndef _WIN32
+#include <BWAPI/Client/Client.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The POSIX transport mirrors the Windows one object for object: the game table and the
+// GameData block are POSIX shared memory objects named after their Windows mappings, and
+// the named pipe is replaced by a FrameSync block that both processes sleep on.
+namespace BWAPI
+{
+  namespace
+  {
+    // How long to sleep on the frame handshake before checking that the server is alive.
+    const int SERVER_TIMEOUT_MS = 2000;
+
+    template <typename T>
+    T* mapSharedObject(const std::string& name)
+    {
+      int fd = shm_open(name.c_str(), O_RDWR, 0);
+      if ( fd == -1 )
+        return nullptr;
+
+      void* view = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      return view == MAP_FAILED ? nullptr : static_cast<T*>(view);
+    }
+
+    template <typename T>
+    void unmapSharedObject(T*& view)
+    {
+      if ( view )
+        munmap(view, sizeof(T));
+      view = nullptr;
+    }
+
+    bool isProcessAlive(int procID)
+    {
+      return kill(procID, 0) == 0 || errno == EPERM;
+    }
+  }
+
+  Client BWAPIClient;
+  Client::Client()
+  {}
+  Client::~Client()
+  {
+    this->disconnect();
+  }
+  bool Client::isConnected() const
+  {
+    return this->connected;
+  }
+  bool Client::connect()
+  {
+    if ( this->connected )
+    {
+      std::cout << "Already connected." << std::endl;
+      return true;
+    }
+
+    serverProcID   = -1;
+    gameTableIndex = -1;
+
+    this->gameTable = mapSharedObject<GameTable>("/bwapi_shared_memory_game_list");
+    if ( !this->gameTable )
+    {
+      std::cerr << "Game table mapping not found." << std::endl;
+      return false;
+    }
+
+    //Find row with most recent keep alive that isn't connected
+    unsigned int latest = 0;
+    for(int i = 0; i < GameTable::MAX_GAME_INSTANCES; i++)
+    {
+      std::cout << i << " | " << gameTable->gameInstances[i].serverProcessID << " | " << gameTable->gameInstances[i].isConnected << " | " << gameTable->gameInstances[i].lastKeepAliveTime << std::endl;
+      if (gameTable->gameInstances[i].serverProcessID != 0 && !gameTable->gameInstances[i].isConnected)
+      {
+        if ( gameTableIndex == -1 || latest == 0 || gameTable->gameInstances[i].lastKeepAliveTime < latest )
+        {
+          latest = gameTable->gameInstances[i].lastKeepAliveTime;
+          gameTableIndex = i;
+        }
+      }
+    }
+
+    if (gameTableIndex != -1)
+      serverProcID = gameTable->gameInstances[gameTableIndex].serverProcessID;
+
+    if (serverProcID == -1 || !isProcessAlive(serverProcID))
+    {
+      std::cerr << "No server proc ID" << std::endl;
+      unmapSharedObject(gameTable);
+      return false;
+    }
+
+    std::stringstream sharedMemoryName;
+    sharedMemoryName << "/bwapi_shared_memory_";
+    sharedMemoryName << serverProcID;
+
+    std::stringstream communicationPipe;
+    communicationPipe << "/bwapi_pipe_";
+    communicationPipe << serverProcID;
+
+    frameSync = mapSharedObject<FrameSync>(communicationPipe.str());
+    if ( !frameSync )
+    {
+      std::cerr << "Unable to open communications pipe: " << communicationPipe.str() << std::endl;
+      unmapSharedObject(gameTable);
+      return false;
+    }
+
+    std::cout << "Connected" << std::endl;
+    data = mapSharedObject<GameData>(sharedMemoryName.str());
+    if ( data == nullptr )
+    {
+      std::cerr << "Unable to open shared memory mapping: " << sharedMemoryName.str() << std::endl;
+      unmapSharedObject(frameSync);
+      unmapSharedObject(gameTable);
+      return false;
+    }
+
+    // Create new instance of Game/Broodwar
+    if ( BWAPI::BroodwarPtr )
+      delete static_cast<GameImpl*>(BWAPI::BroodwarPtr);
+    BWAPI::BroodwarPtr = new GameImpl(data);
+    assert( BWAPI::BroodwarPtr != nullptr );
+
+    // From here on disconnect() is responsible for releasing the mappings.
+    this->connected = true;
+    gameTable->gameInstances[gameTableIndex].isConnected = true;
+
+    if (BWAPI::CLIENT_VERSION != BWAPI::Broodwar->getClientVersion())
+    {
+      //error
+      std::cerr << "Error: Client and Server are not compatible!" << std::endl;
+      std::cerr << "Client version: " << BWAPI::CLIENT_VERSION << std::endl;
+      std::cerr << "Server version: " << BWAPI::Broodwar->getClientVersion() << std::endl;
+      disconnect();
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 2000 });
+      return false;
+    }
+    //wait for permission from server before we resume execution
+    frameSync->clientProcessID = getpid();
+    signalFrameSync(frameSync, FrameSync::CLIENT_READY);
+    int code = FrameSync::CLIENT_READY;
+    while ( code != FrameSync::SERVER_READY )
+    {
+      code = waitFrameSync(frameSync, FrameSync::CLIENT_READY, SERVER_TIMEOUT_MS);
+      if ( code == FrameSync::SERVER_CLOSED || (code == FrameSync::CLIENT_READY && !isProcessAlive(serverProcID)) )
+      {
+        disconnect();
+        std::cerr << "Unable to read pipe object." << std::endl;
+        return false;
+      }
+    }
+
+    // If requested, keep a copy of every frame so the game can be replayed natively.
+    if ( const char* recordPath = std::getenv("BWAPI_RECORD_FRAMES") )
+    {
+      if ( recorder.open(recordPath) )
+        recorder.recordFrame(*data);
+    }
+
+    std::cout << "Connection successful" << std::endl;
+    assert( BWAPI::BroodwarPtr != nullptr);
+    return true;
+  }
+  void Client::disconnect()
+  {
+    if ( !this->connected ) return;
+
+    if ( gameTable && gameTableIndex != -1 )
+      gameTable->gameInstances[gameTableIndex].isConnected = false;
+    unmapSharedObject(gameTable);
+    unmapSharedObject(frameSync);
+    unmapSharedObject(data);
+
+    recorder.close();
+
+    this->connected = false;
+    std::cout << "Disconnected" << std::endl;
+
+    if ( BWAPI::BroodwarPtr )
+      delete static_cast<GameImpl*>(BWAPI::BroodwarPtr);
+    BWAPI::BroodwarPtr = nullptr;
+  }
+  void Client::update()
+  {
+    signalFrameSync(frameSync, FrameSync::CLIENT_READY);
+
+    int code = FrameSync::CLIENT_READY;
+    while (code != FrameSync::SERVER_READY)
+    {
+      code = waitFrameSync(frameSync, FrameSync::CLIENT_READY, SERVER_TIMEOUT_MS);
+      if ( code == FrameSync::SERVER_CLOSED || (code == FrameSync::CLIENT_READY && !isProcessAlive(serverProcID)) )
+      {
+        std::cout << (code == FrameSync::SERVER_CLOSED ? "server closed, disconnecting" : "failed, disconnecting") << std::endl;
+        disconnect();
+        return;
+      }
+    }
+    recorder.recordFrame(*data);
+
+    for(int i = 0; i < data->eventCount; ++i)
+    {
+      EventType::Enum type(data->events[i].type);
+
+      if ( type == EventType::MatchStart )
+        static_cast<GameImpl*>(BWAPI::BroodwarPtr)->onMatchStart();
+      if ( type == EventType::MatchFrame || type == EventType::MenuFrame )
+        static_cast<GameImpl*>(BWAPI::BroodwarPtr)->onMatchFrame();
+    }
+    if ( BWAPI::BroodwarPtr != nullptr && static_cast<GameImpl*>(BWAPI::BroodwarPtr)->inGame && !Broodwar->isInGame() )
+      static_cast<GameImpl*>(BWAPI::BroodwarPtr)->onMatchEnd();
+  }
+}
+#endif
@@ -0,0 +1,169 @@
+#include <BWAPI/Client/CommandQueue.h>
+
+namespace BWAPI
+{
+  namespace
+  {
+    // Whether a command replaces the unit's current order outright, so that an earlier
+    // command in the same frame has no effect once it is followed by this one.
+    bool replacesOrder(UnitCommandType type, int extra)
+    {
+      switch ( type )
+      {
+      case UnitCommandTypes::Enum::Attack_Move:
+      case UnitCommandTypes::Enum::Attack_Unit:
+      case UnitCommandTypes::Enum::Move:
+      case UnitCommandTypes::Enum::Patrol:
+      case UnitCommandTypes::Enum::Hold_Position:
+      case UnitCommandTypes::Enum::Stop:
+      case UnitCommandTypes::Enum::Follow:
+      case UnitCommandTypes::Enum::Right_Click_Position:
+      case UnitCommandTypes::Enum::Right_Click_Unit:
+        // For these types, 'extra' holds whether the command is queued.
+        return extra == 0;
+      default:
+        return false;
+      }
+    }
+
+    // The order that a unit carries out after being given a command, for the commands
+    // whose repetition is safe to drop while that order lasts.
+    Order orderOf(UnitCommandType type)
+    {
+      switch ( type )
+      {
+      case UnitCommandTypes::Enum::Attack_Move:
+        return Orders::AttackMove;
+      case UnitCommandTypes::Enum::Attack_Unit:
+        return Orders::AttackUnit;
+      case UnitCommandTypes::Enum::Move:
+        return Orders::Move;
+      case UnitCommandTypes::Enum::Patrol:
+        return Orders::Patrol;
+      case UnitCommandTypes::Enum::Hold_Position:
+        return Orders::HoldPosition;
+      case UnitCommandTypes::Enum::Follow:
+        return Orders::Follow;
+      default:
+        return Orders::None;
+      }
+    }
+  }
+  int CommandQueue::Counters::dropped() const
+  {
+    return duplicates + overBudget;
+  }
+  //------------------------------------------------ SETTINGS ------------------------------------------------
+  CommandQueue::CommandQueue(const GameData *data)
+    : data(data)
+  {
+  }
+  void CommandQueue::setEnabled(bool enabled)
+  {
+    this->enabled = enabled;
+  }
+  bool CommandQueue::isEnabled() const
+  {
+    return enabled;
+  }
+  void CommandQueue::setFrameBudget(int budget)
+  {
+    frameBudget = budget;
+  }
+  int CommandQueue::getFrameBudget() const
+  {
+    return frameBudget;
+  }
+  //------------------------------------------------ COUNTERS ------------------------------------------------
+  const CommandQueue::Counters& CommandQueue::getFrameCounters() const
+  {
+    return frameCounters;
+  }
+  const CommandQueue::Counters& CommandQueue::getTotalCounters() const
+  {
+    return totalCounters;
+  }
+  void CommandQueue::clear()
+  {
+    frame = -1;
+    frameCounters = Counters();
+    totalCounters = Counters();
+    slots.clear();
+    slotFrames.clear();
+  }
+  void CommandQueue::updateFrame()
+  {
+    if ( frame != data->frameCount )
+    {
+      frame = data->frameCount;
+      frameCounters = Counters();
+    }
+  }
+  //------------------------------------------------ FILTERING -----------------------------------------------
+  bool CommandQueue::isDuplicate(Unit unit, const UnitCommand &command)
+  {
+    updateFrame();
+
+    // Comparing the order makes sure that the unit hasn't finished the command or been
+    // distracted from it, such as by a move that ended or a target that died.
+    Order order = orderOf(command.type);
+    if ( order == Orders::None || command.isQueued() )
+      return false;
+    if ( unit->getOrder() != order || unit->getLastCommand() != command )
+      return false;
+
+    ++frameCounters.duplicates;
+    ++totalCounters.duplicates;
+    return true;
+  }
+  int CommandQueue::findSlot(Unit unit, const UnitCommand &command)
+  {
+    int id = unit->getID();
+    if ( static_cast<unsigned>(id) >= slots.size() || slotFrames[id] != frame )
+      return -1;
+    if ( !replacesOrder(command.type, command.extra) )
+      return -1;
+
+    // Make sure that the entry is still the unit's, in case the buffer has been emptied.
+    int slot = slots[id];
+    if ( slot >= data->unitCommandCount )
+      return -1;
+    const BWAPIC::UnitCommand &c = data->unitCommands[slot];
+    if ( c.unitIndex != id || !replacesOrder(c.type, c.extra) )
+      return -1;
+    return slot;
+  }
+  bool CommandQueue::reserve()
+  {
+    bool full = data->unitCommandCount >= GameData::MAX_UNIT_COMMANDS;
+    if ( !full && (frameBudget <= 0 || frameCounters.issued < frameBudget) )
+      return true;
+
+    ++frameCounters.overBudget;
+    ++totalCounters.overBudget;
+    return false;
+  }
+  void CommandQueue::onIssued(int unitIndex, int slot, bool coalesced)
+  {
+    if ( coalesced )
+    {
+      ++frameCounters.coalesced;
+      ++totalCounters.coalesced;
+    }
+    else
+    {
+      ++frameCounters.issued;
+      ++totalCounters.issued;
+    }
+
+    if ( unitIndex < 0 )
+      return;
+    if ( static_cast<unsigned>(unitIndex) >= slots.size() )
+    {
+      slots.resize(unitIndex + 1, -1);
+      slotFrames.resize(unitIndex + 1, -1);
+    }
+    slots[unitIndex] = slot;
+    slotFrames[unitIndex] = frame;
+  }
+}
@@ -0,0 +1,179 @@
+#include <BWAPI/Client/FrameRecording.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace BWAPI
+{
+  namespace
+  {
+    const char RECORDING_MAGIC[8] = { 'B', 'W', 'A', 'P', 'I', 'R', 'E', 'C' };
+
+    // The first and one-past-last page that hold nothing but client-to-server data.
+    size_t clientPagesBegin()
+    {
+      return (offsetof(GameData, stringCount) + FrameRecordingHeader::PAGE_SIZE - 1) / FrameRecordingHeader::PAGE_SIZE;
+    }
+    size_t clientPagesEnd()
+    {
+      return offsetof(GameData, unitSearchSize) / FrameRecordingHeader::PAGE_SIZE;
+    }
+    size_t pageCount()
+    {
+      return (sizeof(GameData) + FrameRecordingHeader::PAGE_SIZE - 1) / FrameRecordingHeader::PAGE_SIZE;
+    }
+    size_t pageLength(size_t page)
+    {
+      size_t offset = page * FrameRecordingHeader::PAGE_SIZE;
+      return std::min<size_t>(FrameRecordingHeader::PAGE_SIZE, sizeof(GameData) - offset);
+    }
+  }
+  //------------------------------------------------ RECORDER ------------------------------------------------
+  bool FrameRecorder::open(const char* path)
+  {
+    this->close();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if ( !file )
+    {
+      std::cerr << "Unable to open frame recording: " << path << std::endl;
+      return false;
+    }
+
+    // Diffing against zeroes means the first frame only stores the pages that are used.
+    previous.assign(sizeof(GameData), 0);
+    frameCount = 0;
+    return true;
+  }
+  void FrameRecorder::close()
+  {
+    if ( file.is_open() )
+      file.close();
+    previous.clear();
+    previous.shrink_to_fit();
+  }
+  bool FrameRecorder::isOpen() const
+  {
+    return file.is_open();
+  }
+  void FrameRecorder::recordFrame(const GameData& data)
+  {
+    if ( !file.is_open() )
+      return;
+
+    if ( frameCount == 0 )
+    {
+      FrameRecordingHeader header{};
+      memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+      header.version       = FrameRecordingHeader::VERSION;
+      header.pageSize      = FrameRecordingHeader::PAGE_SIZE;
+      header.dataSize      = sizeof(GameData);
+      header.clientVersion = data.client_version;
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    const char* current = reinterpret_cast<const char*>(&data);
+
+    // Collect the changed pages first, since the frame starts with the page count.
+    std::vector<unsigned> changed;
+    for ( size_t page = 0; page < pageCount(); ++page )
+    {
+      if ( page >= clientPagesBegin() && page < clientPagesEnd() )
+        continue;
+
+      size_t offset = page * FrameRecordingHeader::PAGE_SIZE;
+      if ( memcmp(current + offset, &previous[offset], pageLength(page)) != 0 )
+        changed.push_back(static_cast<unsigned>(page));
+    }
+
+    unsigned count = static_cast<unsigned>(changed.size());
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for ( unsigned page : changed )
+    {
+      size_t offset = page * FrameRecordingHeader::PAGE_SIZE;
+      file.write(reinterpret_cast<const char*>(&page), sizeof(page));
+      file.write(current + offset, pageLength(page));
+      memcpy(&previous[offset], current + offset, pageLength(page));
+    }
+
+    ++frameCount;
+  }
+  int FrameRecorder::getFrameCount() const
+  {
+    return frameCount;
+  }
+  //------------------------------------------------- READER -------------------------------------------------
+  bool FrameReader::open(const char* path)
+  {
+    this->close();
+
+    file.open(path, std::ios::binary);
+    if ( !file )
+    {
+      std::cerr << "Unable to open frame recording: " << path << std::endl;
+      return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if ( !file || memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 )
+    {
+      std::cerr << "Not a frame recording: " << path << std::endl;
+      this->close();
+      return false;
+    }
+    if ( header.version != FrameRecordingHeader::VERSION ||
+         header.pageSize != FrameRecordingHeader::PAGE_SIZE ||
+         header.dataSize != sizeof(GameData) )
+    {
+      std::cerr << "Frame recording was made with an incompatible GameData layout: " << path << std::endl;
+      this->close();
+      return false;
+    }
+
+    frameCount = 0;
+    return true;
+  }
+  void FrameReader::close()
+  {
+    if ( file.is_open() )
+      file.close();
+  }
+  bool FrameReader::isOpen() const
+  {
+    return file.is_open();
+  }
+  bool FrameReader::readFrame(GameData& data)
+  {
+    if ( !file.is_open() )
+      return false;
+
+    unsigned count = 0;
+    if ( !file.read(reinterpret_cast<char*>(&count), sizeof(count)) )
+      return false;
+
+    char* current = reinterpret_cast<char*>(&data);
+    for ( unsigned i = 0; i < count; ++i )
+    {
+      unsigned page = 0;
+      if ( !file.read(reinterpret_cast<char*>(&page), sizeof(page)) || page >= pageCount() ||
+           !file.read(current + page * FrameRecordingHeader::PAGE_SIZE, pageLength(page)) )
+      {
+        std::cerr << "Frame recording is truncated after frame " << frameCount << std::endl;
+        return false;
+      }
+    }
+
+    ++frameCount;
+    return true;
+  }
+  int FrameReader::getFrameCount() const
+  {
+    return frameCount;
+  }
+  int FrameReader::getClientVersion() const
+  {
+    return header.clientVersion;
+  }
+}
@@ -11,6 +11,7 @@
 #include "Convenience.h"
 #include <string>
 #include <cassert>
+#include <cstring>
 #include <fstream>
 
 #include <BWAPI/Unitset.h>
@@ -19,6 +20,7 @@ namespace BWAPI
 {
   GameImpl::GameImpl(GameData* _data)
     : data(_data)
+    , commandQueue(_data)
   {
     this->clearAll();
     for(int i = 0; i < 5; ++i)
@@ -28,6 +30,7 @@ namespace BWAPI
     // @TODO: Possible to exceed 10000 here
     for(int i = 0; i < 10000; ++i)
       unitVector.push_back(UnitImpl(i));
+    unitDataCache.resize(unitVector.size());
     for(int i = 0; i < 100; ++i)
       bulletVector.push_back(BulletImpl(i));
     
@@ -60,8 +63,16 @@ namespace BWAPI
   {
     assert(data->unitCommandCount < GameData::MAX_UNIT_COMMANDS);
     data->unitCommands[data->unitCommandCount] = c;
+    // the unit's last command changes on our side, so report it as changed next frame
+    if ( static_cast<unsigned>(c.unitIndex) < unitVector.size() )
+      commandedUnits.insert(&unitVector[c.unitIndex]);
     return data->unitCommandCount++;
   }
+  void GameImpl::replaceUnitCommand(int index, BWAPIC::UnitCommand& c)
+  {
+    assert(index < data->unitCommandCount);
+    data->unitCommands[index] = c;
+  }
   Unit GameImpl::_unitFromIndex(int index)
   {
     return this->getUnit(index);
@@ -113,7 +124,7 @@ namespace BWAPI
     staticNeutralUnits.clear();
     selectedUnits.clear();
     pylons.clear();
-    events.clear();
+    clearEvents();
     thePlayer  = nullptr;
     theEnemy   = nullptr;
     theNeutral = nullptr;
@@ -133,6 +144,16 @@ namespace BWAPI
       delete static_cast<RegionImpl*>(r);
     regionsList.clear();
     regionArray.fill(nullptr);
+
+    unitGrid.clear();
+    regionGraph.clear();
+    placementCache.clear();
+    commandQueue.clear();
+    changedUnits.clear();
+    commandedUnits.clear();
+    // zeroed data never matches a unit that exists, so every unit is changed on its first frame
+    if ( !unitDataCache.empty() )
+      memset(unitDataCache.data(), 0, unitDataCache.size() * sizeof(UnitData));
   }
 
   //------------------------------------------- INTERFACE EVENT UPDATE ---------------------------------------
@@ -195,6 +216,7 @@ namespace BWAPI
     }
     for ( int i = 0; i < data->regionCount; ++i )
       this->regionArray[i]->setNeighbors();
+    regionGraph.build(data);
 
     thePlayer  = getPlayer(data->self);
     theEnemy   = getPlayer(data->enemy);
@@ -236,7 +258,7 @@ namespace BWAPI
   //------------------------------------------------- ON MATCH FRAME -----------------------------------------
   void GameImpl::onMatchFrame()
   {
-    events.clear();
+    clearEvents();
     bullets.clear();
     for(int i = 0; i < 100; ++i)
     {
@@ -249,7 +271,7 @@ namespace BWAPI
 
     for(int e = 0; e < data->eventCount; ++e)
     {
-      events.push_back(this->makeEvent(data->events[e]));
+      addEvent(data->events[e]);
       int id = data->events[e].v1;
       if (data->events[e].type == EventType::UnitDiscover)
       {
@@ -289,6 +311,15 @@ namespace BWAPI
             pylons.erase(u);
         }
       }
+      else if (data->events[e].type == EventType::UnitCreate ||
+               data->events[e].type == EventType::UnitDestroy ||
+               data->events[e].type == EventType::UnitComplete)
+      {
+        // Pylons and creep sources change where buildings can go without moving any
+        // footprint, so the remembered build locations may no longer be the best
+        if ( unitVector[id].getType().isBuilding() )
+          placementCache.invalidate();
+      }
       else if (data->events[e].type==EventType::UnitRenegade)
       {
         Unit u = &unitVector[id];
@@ -299,6 +330,8 @@ namespace BWAPI
       else if (data->events[e].type == EventType::UnitMorph)
       {
         Unit u = &unitVector[id];
+        if ( u->getType().isBuilding() )
+          placementCache.invalidate();
         if (u->getType() == UnitTypes::Resource_Vespene_Geyser)
         {
           geysers.insert(u);
@@ -356,6 +389,12 @@ namespace BWAPI
           _observers.insert(p);
       }
     }
+    updateChangedUnits();
+    // rebuild the stat tables of players whose upgrades changed since the last frame
+    for ( Player p : playerSet )
+      p->updateStats();
+    // bucket every accessible unit for this frame's spatial queries
+    unitGrid.rebuild(accessibleUnits, data->mapWidth, data->mapHeight);
     this->processInterfaceEvents(); // Note sure if this should go here?
   }
   //----------------------------------------------- GET FORCE ------------------------------------------------
@@ -476,16 +515,10 @@ namespace BWAPI
   {
     Unitset unitFinderResults;
 
-    // Have the unit finder do its stuff
-    Templates::iterateUnitFinder<unitFinder>(data->xUnitSearch,
-                                             data->yUnitSearch,
-                                             data->unitSearchSize,
-                                             left,
-                                             top,
-                                             right,
-                                             bottom,
-                                             [&](Unit u){ if ( !pred.isValid() || pred(u) )
-                                                             unitFinderResults.insert(u); });
+    // Have the unit grid do its stuff
+    unitGrid.forEachInRectangle(left, top, right, bottom,
+                                [&](Unit u){ if ( !pred.isValid() || pred(u) )
+                                               unitFinderResults.insert(u); });
     // Return results
     return unitFinderResults;
   }
@@ -495,22 +528,16 @@ namespace BWAPI
     int bestDistance = 99999999;
     Unit pBestUnit = nullptr;
 
-    Templates::iterateUnitFinder<unitFinder>(data->xUnitSearch,
-                                             data->yUnitSearch,
-                                             data->unitSearchSize,
-                                             left,
-                                             top,
-                                             right,
-                                             bottom,
-                                             [&](Unit u){ if ( !pred.isValid() || pred(u) )
-                                                           {
-                                                              int newDistance = u->getDistance(center);
-                                                              if ( newDistance < bestDistance )
-                                                              {
-                                                                pBestUnit = u;
-                                                                bestDistance = newDistance;
-                                                              }
-                                                           } } );
+    unitGrid.forEachInRectangle(left, top, right, bottom,
+                                [&](Unit u){ if ( !pred.isValid() || pred(u) )
+                                             {
+                                               int newDistance = u->getDistance(center);
+                                               if ( newDistance < bestDistance )
+                                               {
+                                                 pBestUnit = u;
+                                                 bestDistance = newDistance;
+                                               }
+                                             } } );
     return pBestUnit;
   }
   Unit GameImpl::getBestUnit(const BestUnitFilter &best, const UnitFilter &pred, Position center, int radius) const
@@ -524,23 +551,122 @@ namespace BWAPI
     topLeft.makeValid();
     botRight.makeValid();
 
-    Templates::iterateUnitFinder<unitFinder>(data->xUnitSearch,
-                                             data->yUnitSearch,
-                                             data->unitSearchSize,
-                                             topLeft.x,
-                                             topLeft.y,
-                                             botRight.x,
-                                             botRight.y,
-                                             [&](Unit u){ if ( !pred.isValid() || pred(u) )
-                                                           {
-                                                             if ( pBestUnit == nullptr )
-                                                               pBestUnit = u;
-                                                             else
-                                                               pBestUnit = best(pBestUnit,u); 
-                                                           } } );
+    unitGrid.forEachInRectangle(topLeft.x, topLeft.y, botRight.x, botRight.y,
+                                [&](Unit u){ if ( !pred.isValid() || pred(u) )
+                                             {
+                                               if ( pBestUnit == nullptr )
+                                                 pBestUnit = u;
+                                               else
+                                                 pBestUnit = best(pBestUnit,u); 
+                                             } } );
 
     return pBestUnit;
   }
+  const UnitGrid& GameImpl::getUnitGrid() const
+  {
+    return unitGrid;
+  }
+  const RegionGraph& GameImpl::getRegionGraph() const
+  {
+    return regionGraph;
+  }
+  PlacementCache& GameImpl::getPlacementCache() const
+  {
+    return placementCache;
+  }
+  CommandQueue& GameImpl::getCommandQueue()
+  {
+    return commandQueue;
+  }
+  //------------------------------------------------ EVENT BUFFER --------------------------------------------
+  std::span< const Event > GameImpl::getEventBuffer() const
+  {
+    return eventBuffer;
+  }
+  std::span< const Unit > GameImpl::getUnitEvents(EventType::Enum type) const
+  {
+    if ( type < 0 || type >= EventType::None )
+      return {};
+    return unitEvents[type];
+  }
+  std::span< const GameImpl::TextEvent > GameImpl::getTextEvents(EventType::Enum type) const
+  {
+    if ( type < 0 || type >= EventType::None )
+      return {};
+    return textEvents[type];
+  }
+  void GameImpl::clearEvents()
+  {
+    // clear() keeps the capacity, which is what lets the buffers be reused
+    eventBuffer.clear();
+    for ( auto &units : unitEvents )
+      units.clear();
+    for ( auto &texts : textEvents )
+      texts.clear();
+    events.clear();
+    isEventListValid = false;
+  }
+  void GameImpl::addEvent(const BWAPIC::Event &e)
+  {
+    eventBuffer.push_back(this->makeEvent(e));
+
+    const Event &event = eventBuffer.back();
+    if ( event.getUnit() )
+      unitEvents[e.type].push_back(event.getUnit());
+    if ( e.type == EventType::SaveGame || e.type == EventType::SendText )
+      textEvents[e.type].push_back({ nullptr, data->eventStrings[e.v1] });
+    else if ( e.type == EventType::ReceiveText )
+      textEvents[e.type].push_back({ event.getPlayer(), data->eventStrings[e.v2] });
+  }
+  //----------------------------------------------- CHANGED UNITS --------------------------------------------
+  const Unitset& GameImpl::getChangedUnits() const
+  {
+    return changedUnits;
+  }
+  void GameImpl::markChanged(int unitIndex)
+  {
+    if ( static_cast<unsigned>(unitIndex) < unitVector.size() )
+      changedUnits.insert(&unitVector[unitIndex]);
+  }
+  void GameImpl::updateChangedUnits()
+  {
+    changedUnits.clear();
+    for ( Unit u : commandedUnits )
+      changedUnits.insert(u);
+    commandedUnits.clear();
+
+    auto compare = [this](int id)
+    {
+      if ( static_cast<unsigned>(id) >= unitVector.size() )
+        return;
+      UnitData &last = unitDataCache[id];
+      const UnitData *current = unitVector[id].self;
+      if ( memcmp(&last, current, sizeof(UnitData)) == 0 )
+        return;
+
+      // larva, interceptor and loaded unit sets are derived from the other end of the link
+      markChanged(last.hatchery);
+      markChanged(last.carrier);
+      markChanged(last.transport);
+      markChanged(current->hatchery);
+      markChanged(current->carrier);
+      markChanged(current->transport);
+
+      // memcpy rather than assignment so padding compares equal on the next frame
+      memcpy(&last, current, sizeof(UnitData));
+      markChanged(id);
+    };
+
+    for ( Unit u : accessibleUnits )
+      compare(u->getID());
+
+    // units that left accessibleUnits this frame still need their final state compared
+    for ( int e = 0; e < data->eventCount; ++e )
+    {
+      if ( data->events[e].type == EventType::UnitEvade || data->events[e].type == EventType::UnitDestroy )
+        compare(data->events[e].v1);
+    }
+  }
   //----------------------------------------------- MAP WIDTH ------------------------------------------------
   int GameImpl::mapWidth() const
   {
@@ -922,7 +1048,7 @@ namespace BWAPI
       const int minitilePosX = (x&0x1F)/8;
       const int minitilePosY = (y&0x1F)/8;
       const int minitileShift = minitilePosX + minitilePosY * 4;
-      const int index = idx & 0x1FFF;
+      const unsigned index = idx & 0x1FFF;
       if (index >= std::extent<decltype(data->mapSplitTilesMiniTileMask)>::value)
         return nullptr;
       
@@ -944,6 +1070,12 @@ namespace BWAPI
     }
     return this->getRegion(idx);
   }
+  //----------------------------------------------- GET GROUND DISTANCE --------------------------------------
+  int GameImpl::getGroundDistance(Position source, Position destination) const
+  {
+    // The last error is left alone, since getBuildLocation calls this for every candidate.
+    return regionGraph.getGroundDistance(source, destination);
+  }
   int GameImpl::getLastEventTime() const
   {
     return 0;
@@ -0,0 +1,276 @@
+#include <BWAPI/Client/RegionGraph.h>
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace BWAPI
+{
+  //------------------------------------------------ BUILD ---------------------------------------------------
+  void RegionGraph::build(const GameData *gameData)
+  {
+    clear();
+    data = gameData;
+
+    // Number the accessible regions. The others can't be walked on and get no node.
+    nodeOfRegion.assign(data->regionCount, -1);
+    for ( int i = 0; i < data->regionCount; ++i )
+    {
+      if ( data->regions[i].isAccessible )
+      {
+        nodeOfRegion[i] = nodeCount++;
+        regionOfNode.push_back(i);
+      }
+    }
+
+    // Look up the region of every walkable mini-tile once, since each is visited twice.
+    int walkWidth = data->mapWidth * 4, walkHeight = data->mapHeight * 4;
+    std::vector<int> walkRegions(walkWidth * walkHeight, -1);
+    for ( int y = 0; y < walkHeight; ++y )
+    {
+      for ( int x = 0; x < walkWidth; ++x )
+      {
+        if ( data->isWalkable[x][y] )
+          walkRegions[y * walkWidth + x] = getRegionID(Position(x * 8 + 4, y * 8 + 4));
+      }
+    }
+
+    // Collect the points along the border of every pair of regions in the same group,
+    // halfway between each pair of neighboring walkable mini-tiles in different regions.
+    std::unordered_map<unsigned, int> chokepointOfPair;
+    std::vector<std::vector<Position>> borders;
+    auto addBorder = [&](int a, int b, Position point)
+    {
+      if ( a == b || a < 0 || b < 0 || nodeOfRegion[a] < 0 || nodeOfRegion[b] < 0 )
+        return;
+      if ( data->regions[a].islandID != data->regions[b].islandID )
+        return;
+      if ( a > b )
+        std::swap(a, b);
+
+      auto it = chokepointOfPair.emplace((unsigned)a << 16 | (unsigned)b, (int)chokepoints.size());
+      if ( it.second )
+      {
+        chokepoints.push_back({ Positions::None, 0, { a, b } });
+        borders.emplace_back();
+      }
+      borders[it.first->second].push_back(point);
+    };
+    for ( int y = 0; y < walkHeight; ++y )
+    {
+      for ( int x = 0; x < walkWidth; ++x )
+      {
+        int region = walkRegions[y * walkWidth + x];
+        if ( region < 0 )
+          continue;
+        if ( x + 1 < walkWidth )
+          addBorder(region, walkRegions[y * walkWidth + x + 1], Position(x * 8 + 8, y * 8 + 4));
+        if ( y + 1 < walkHeight )
+          addBorder(region, walkRegions[(y + 1) * walkWidth + x], Position(x * 8 + 4, y * 8 + 8));
+      }
+    }
+
+    // Place each chokepoint on its border, at the point closest to the border's average, so
+    // that it is walkable even if the border is curved or in several pieces.
+    edges.assign(nodeCount, {});
+    for ( size_t c = 0; c < chokepoints.size(); ++c )
+    {
+      Chokepoint &choke = chokepoints[c];
+      const std::vector<Position> &border = borders[c];
+
+      Position sum(0, 0), topLeft = border.front(), bottomRight = border.front();
+      for ( Position p : border )
+      {
+        sum += p;
+        topLeft = Position(std::min(topLeft.x, p.x), std::min(topLeft.y, p.y));
+        bottomRight = Position(std::max(bottomRight.x, p.x), std::max(bottomRight.y, p.y));
+      }
+      Position average = sum / (int)border.size();
+
+      choke.center = border.front();
+      for ( Position p : border )
+      {
+        if ( p.getApproxDistance(average) < choke.center.getApproxDistance(average) )
+          choke.center = p;
+      }
+      choke.width = topLeft.getApproxDistance(bottomRight) + 8;
+
+      // Connect the two regions through the chokepoint.
+      const RegionData &a = data->regions[choke.regions[0]];
+      const RegionData &b = data->regions[choke.regions[1]];
+      int weight = choke.center.getApproxDistance(Position(a.center_x, a.center_y)) +
+                   choke.center.getApproxDistance(Position(b.center_x, b.center_y));
+      int nodeA = nodeOfRegion[choke.regions[0]], nodeB = nodeOfRegion[choke.regions[1]];
+      edges[nodeA].push_back({ nodeB, (int)c, weight });
+      edges[nodeB].push_back({ nodeA, (int)c, weight });
+    }
+
+    rowOfNode.assign(nodeCount, -1);
+    maxRows = std::max(MAX_ENTRIES / std::max(nodeCount, 1), 1);
+  }
+  void RegionGraph::clear()
+  {
+    data = nullptr;
+    chokepoints.clear();
+    nodeOfRegion.clear();
+    regionOfNode.clear();
+    nodeCount = 0;
+    edges.clear();
+
+    std::lock_guard<std::mutex> lock(rowMutex);
+    rows.clear();
+    rowOfNode.clear();
+    rowCount = 0;
+    maxRows = 0;
+  }
+  //------------------------------------------------ GET ROW -------------------------------------------------
+  const RegionGraph::Row& RegionGraph::getRow(int from) const
+  {
+    if ( rowOfNode[from] >= 0 )
+      return rows[rowOfNode[from]];
+
+    if ( rowCount == maxRows )
+    {
+      std::fill(rowOfNode.begin(), rowOfNode.end(), -1);
+      rowCount = 0;
+    }
+    if ( rowCount == (int)rows.size() )
+      rows.emplace_back();
+
+    rowOfNode[from] = rowCount;
+    Row &row = rows[rowCount++];
+    row.distances.assign(nodeCount, -1);
+    row.firstChokepoint.assign(nodeCount, 0xFFFF);
+    row.lastChokepoint.assign(nodeCount, 0xFFFF);
+
+    // Run Dijkstra's algorithm from the node, remembering the first and last chokepoints on
+    // the way to each other node so that paths can be walked one region at a time.
+    using QueueEntry = std::pair<int, int>; // Distance, node
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    row.distances[from] = 0;
+    queue.push({ 0, from });
+    while ( !queue.empty() )
+    {
+      QueueEntry top = queue.top();
+      queue.pop();
+      if ( top.first > row.distances[top.second] )
+        continue;
+
+      for ( const Edge &e : edges[top.second] )
+      {
+        int distance = top.first + e.weight;
+        if ( row.distances[e.to] >= 0 && row.distances[e.to] <= distance )
+          continue;
+
+        row.distances[e.to] = distance;
+        row.firstChokepoint[e.to] = top.second == from ? (unsigned short)e.chokepoint : row.firstChokepoint[top.second];
+        row.lastChokepoint[e.to] = (unsigned short)e.chokepoint;
+        queue.push({ distance, e.to });
+      }
+    }
+    return row;
+  }
+  //------------------------------------------------ GET REGION ID -------------------------------------------
+  int RegionGraph::getRegionID(Position position) const
+  {
+    if ( !data || position.x < 0 || position.y < 0 || position.x >= data->mapWidth * 32 || position.y >= data->mapHeight * 32 )
+      return -1;
+
+    // Same lookup as GameImpl::getRegionAt.
+    unsigned short idx = data->mapTileRegionId[position.x / 32][position.y / 32];
+    if ( idx & 0x2000 )
+    {
+      int index = idx & 0x1FFF;
+      if ( index >= 5000 )
+        return -1;
+
+      int minitileShift = (position.x & 0x1F) / 8 + (position.y & 0x1F) / 8 * 4;
+      if ( (data->mapSplitTilesMiniTileMask[index] >> minitileShift) & 1 )
+        return data->mapSplitTilesRegion2[index];
+      return data->mapSplitTilesRegion1[index];
+    }
+    return idx;
+  }
+  int RegionGraph::nodeAt(Position position) const
+  {
+    int region = getRegionID(position);
+    if ( region < 0 || region >= (int)nodeOfRegion.size() )
+      return -1;
+    return nodeOfRegion[region];
+  }
+  //------------------------------------------------ DISTANCES -----------------------------------------------
+  int RegionGraph::getRegionDistance(int sourceRegion, int destinationRegion) const
+  {
+    if ( sourceRegion < 0 || sourceRegion >= (int)nodeOfRegion.size() ||
+         destinationRegion < 0 || destinationRegion >= (int)nodeOfRegion.size() )
+      return -1;
+
+    int from = nodeOfRegion[sourceRegion], to = nodeOfRegion[destinationRegion];
+    if ( from < 0 || to < 0 )
+      return -1;
+
+    std::lock_guard<std::mutex> lock(rowMutex);
+    return getRow(from).distances[to];
+  }
+  int RegionGraph::getGroundDistance(Position source, Position destination) const
+  {
+    int from = nodeAt(source), to = nodeAt(destination);
+    if ( from < 0 || to < 0 )
+      return -1;
+    if ( from == to )
+      return source.getApproxDistance(destination);
+
+    std::lock_guard<std::mutex> lock(rowMutex);
+    const Row &row = getRow(from);
+    int centers = row.distances[to];
+    if ( centers < 0 )
+      return -1;
+
+    // The row holds the distance between the region centers. Swap the first and last legs
+    // of that path, from each center to its region's chokepoint on the path, for the legs
+    // from the actual positions.
+    const RegionData &a = data->regions[regionOfNode[from]];
+    const RegionData &b = data->regions[regionOfNode[to]];
+    Position first = chokepoints[row.firstChokepoint[to]].center;
+    Position last = chokepoints[row.lastChokepoint[to]].center;
+
+    int between = centers - first.getApproxDistance(Position(a.center_x, a.center_y))
+                          - last.getApproxDistance(Position(b.center_x, b.center_y));
+    return source.getApproxDistance(first) + std::max(between, 0) + last.getApproxDistance(destination);
+  }
+  //------------------------------------------------ GET PATH ------------------------------------------------
+  bool RegionGraph::getPath(Position source, Position destination, std::vector<Position> &path) const
+  {
+    int from = nodeAt(source), to = nodeAt(destination);
+    if ( from < 0 || to < 0 )
+      return false;
+
+    std::lock_guard<std::mutex> lock(rowMutex);
+    const Row &row = getRow(from);
+    if ( row.distances[to] < 0 )
+      return false;
+
+    // Walk back from the destination through the last chokepoint on the way to each
+    // region, which only needs the source's row, then put the chokepoints in order.
+    size_t start = path.size();
+    for ( int node = to; node != from; )
+    {
+      const Chokepoint &choke = chokepoints[row.lastChokepoint[node]];
+      path.push_back(choke.center);
+
+      int previous = choke.regions[0] == regionOfNode[node] ? choke.regions[1] : choke.regions[0];
+      node = nodeOfRegion[previous];
+    }
+    std::reverse(path.begin() + start, path.end());
+    path.push_back(destination);
+    return true;
+  }
+  const std::vector<RegionGraph::Chokepoint>& RegionGraph::getChokepoints() const
+  {
+    return chokepoints;
+  }
+}
@@ -0,0 +1,117 @@
+#include <BWAPI/Client/UnitGrid.h>
+
+#include <algorithm>
+
+namespace BWAPI
+{
+  //------------------------------------------------ REBUILD -------------------------------------------------
+  void UnitGrid::rebuild(const Unitset& units, int mapWidth, int mapHeight)
+  {
+    cellsX = std::max(1, (mapWidth  * 32 + CELL_SIZE - 1) / CELL_SIZE);
+    cellsY = std::max(1, (mapHeight * 32 + CELL_SIZE - 1) / CELL_SIZE);
+
+    // Gather the bounding boxes once, since they are needed by both passes below.
+    pending.clear();
+    for ( Unit u : units )
+    {
+      if ( !u->exists() || !u->getPosition().isValid() )
+        continue;
+      pending.push_back({ u->getLeft(), u->getTop(), u->getRight(), u->getBottom(), u });
+    }
+
+    // Counting sort: first count the entries per cell, then turn the counts into offsets.
+    cellStart.assign(cellsX * cellsY + 1, 0);
+    for ( const Entry &e : pending )
+    {
+      for ( int cy = cellY(e.top); cy <= cellY(e.bottom); ++cy )
+        for ( int cx = cellX(e.left); cx <= cellX(e.right); ++cx )
+          ++cellStart[cy * cellsX + cx + 1];
+    }
+    for ( size_t c = 1; c < cellStart.size(); ++c )
+      cellStart[c] += cellStart[c - 1];
+
+    // Then place every entry, using the start offsets as insertion cursors and shifting
+    // them back into place afterwards.
+    entries.resize(cellStart.back());
+    for ( const Entry &e : pending )
+    {
+      for ( int cy = cellY(e.top); cy <= cellY(e.bottom); ++cy )
+        for ( int cx = cellX(e.left); cx <= cellX(e.right); ++cx )
+          entries[cellStart[cy * cellsX + cx]++] = e;
+    }
+    for ( size_t c = cellStart.size() - 1; c > 0; --c )
+      cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+  }
+  void UnitGrid::clear()
+  {
+    cellsX = cellsY = 0;
+    cellStart.clear();
+    entries.clear();
+    pending.clear();
+  }
+  //------------------------------------------------ FIND NEAREST --------------------------------------------
+  int UnitGrid::findNearest(Position center, Neighbor* results, int count, const UnitFilter &pred, int radius) const
+  {
+    if ( entries.empty() || count <= 0 || radius < 0 )
+      return 0;
+
+    int found = 0;
+    int cx = cellX(center.x), cy = cellY(center.y);
+
+    // Search outwards in square rings of cells around the center cell. Every unit that
+    // has not been seen after finishing ring r lies entirely in ring r + 1 or beyond, so
+    // it is more than r cells' worth of pixels away and the search can stop once the
+    // result list is full with closer units.
+    int maxRing = std::max({ cx, cy, cellsX - 1 - cx, cellsY - 1 - cy });
+    maxRing = std::min(maxRing, radius / CELL_SIZE + 1);
+
+    for ( int ring = 0; ring <= maxRing; ++ring )
+    {
+      for ( int y = cy - ring; y <= cy + ring; ++y )
+      {
+        if ( y < 0 || y >= cellsY )
+          continue;
+
+        // Rows in the middle of the ring only contribute their two end cells.
+        int step = (y == cy - ring || y == cy + ring) ? 1 : std::max(1, 2 * ring);
+        for ( int x = cx - ring; x <= cx + ring; x += step )
+        {
+          if ( x < 0 || x >= cellsX )
+            continue;
+
+          int cell = y * cellsX + x;
+          for ( int i = cellStart[cell]; i < cellStart[cell + 1]; ++i )
+          {
+            const Entry &e = entries[i];
+            int distance = getDistance(e, center);
+            if ( distance > radius || (found == count && distance >= results[found - 1].distance) )
+              continue;
+
+            // Units spanning several cells are seen more than once.
+            bool duplicate = false;
+            for ( int j = 0; j < found && !duplicate; ++j )
+              duplicate = results[j].unit == e.unit;
+            if ( duplicate || (pred.isValid() && !pred(e.unit)) )
+              continue;
+
+            // Insertion sort into the fixed size result list, dropping the farthest unit
+            // if it is already full.
+            int pos = found < count ? found++ : count - 1;
+            while ( pos > 0 && results[pos - 1].distance > distance )
+            {
+              results[pos] = results[pos - 1];
+              --pos;
+            }
+            results[pos] = { e.unit, distance };
+          }
+        }
+      }
+
+      // Leave a little slack for the approximate distance before trusting the bound.
+      if ( found == count && results[found - 1].distance + DISTANCE_SLACK <= ring * CELL_SIZE )
+        break;
+    }
+    return found;
+  }
+}
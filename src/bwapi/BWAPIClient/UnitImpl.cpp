@@ -20,6 +20,20 @@ namespace BWAPI
   //--------------------------------------------- ISSUE COMMAND ----------------------------------------------
   bool UnitImpl::issueCommand(UnitCommand command)
   {
+    GameImpl *game = static_cast<GameImpl*>(BroodwarPtr);
+    CommandQueue &queue = game->getCommandQueue();
+
+    // Filter the command before the more expensive checks below
+    int slot = -1;
+    if ( queue.isEnabled() )
+    {
+      if ( queue.isDuplicate(this, command) )
+        return true;
+      slot = queue.findSlot(this, command);
+      if ( slot < 0 && !queue.reserve() )
+        return Broodwar->setLastError(Errors::Unit_Busy);
+    }
+
     if ( !canIssueCommand(command) )
       return false;
 
@@ -31,8 +45,7 @@ namespace BWAPI
           command.type == UnitCommandTypes::Morph) &&
          getType().producesLarva() && command.getUnitType().whatBuilds().first == UnitTypes::Zerg_Larva )
     {
-      Unitset larvae( this->getLarva() );
-      for (Unit larva : larvae)
+      for (Unit larva : this->getLarvaView())
       {
         if ( !larva->isConstructing() && larva->isCompleted() && larva->canCommand() )
         {
@@ -56,7 +69,13 @@ namespace BWAPI
     c.y     = command.y;
     c.extra = command.extra;
     Command{ command }.execute();
-    static_cast<GameImpl*>(BroodwarPtr)->addUnitCommand(c);
+    bool coalesced = slot >= 0;
+    if ( coalesced )
+      game->replaceUnitCommand(slot, c);
+    else
+      slot = game->addUnitCommand(c);
+    if ( queue.isEnabled() )
+      queue.onIssued(c.unitIndex, slot, coalesced);
     lastCommandFrame = Broodwar->getFrameCount();
     lastCommand      = command;
     return true;
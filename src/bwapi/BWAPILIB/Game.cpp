@@ -7,13 +7,17 @@
 #include <BWAPI/Region.h>
 #include <BWAPI/Filters.h>
 #include <BWAPI/Player.h>
+#include <BWAPI/PlacementCache.h>
 
 #include <BWAPI/UnitSizeType.h>
 #include <BWAPI/DamageType.h>
 #include <BWAPI/ExplosionType.h>
 #include <BWAPI/WeaponType.h>
 
+#include <algorithm>
 #include <cstdarg>
+#include <string>
+#include <vector>
 
 // Needed by other compilers.
 #include <cstring>
@@ -55,7 +59,7 @@ namespace BWAPI
 
 
   //------------------------------------ DAMAGE CALCULATION ------------------------------------------
-  int damageRatio[DamageTypes::Enum::MAX][UnitSizeTypes::Enum::MAX] =
+  const int damageRatio[DamageTypes::Enum::MAX][UnitSizeTypes::Enum::MAX] =
   {
   // Ind, Sml, Med, Lrg, Non, Unk
     {  0,   0,   0,   0,   0,   0 }, // Independent
@@ -100,13 +104,26 @@ namespace BWAPI
   }
   //-------------------------------------- BUILD LOCATION --------------------------------------------
   const int MAX_RANGE = 64;
+
+  // The full canBuildHere check, including the space for an addon
+  bool isFullyBuildable(TilePosition position, UnitType type)
+  {
+    return Broodwar->canBuildHere(position, type) &&
+           (!type.canBuildAddon() || Broodwar->canBuildHere(position + TilePosition(4,1), UnitTypes::Terran_Missile_Turret));
+  }
+
   class PlacementReserve
   {
   public:
-    PlacementReserve(int maxRange) : maxSearch( std::min(std::max(0,maxRange),MAX_RANGE) )
+    PlacementReserve(int maxRange, const PlacementCache &cache, UnitType type, TilePosition desiredPosition)
+      : maxSearch( std::min(std::max(0,maxRange),MAX_RANGE) )
+      , cache(cache)
+      , type(type)
+      , start(desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2)
     {
       this->reset();
       this->backup();
+      memset(checked,UNCHECKED,sizeof(checked));
     };
 
     void reset()
@@ -114,6 +131,16 @@ namespace BWAPI
       memset(data,0,sizeof(data));
     };
 
+    // Locations are given 1 when they pass a test that canBuildHere implies, and the full
+    // check is only made where a location is looked at. The result is remembered, so each
+    // location is checked at most once.
+    bool isFullyBuildable(int x, int y)
+    {
+      if ( checked[y][x] == UNCHECKED )
+        checked[y][x] = BWAPI::isFullyBuildable(start + TilePosition(x,y), type) ? 1 : 0;
+      return checked[y][x] == 1;
+    };
+
     // Checks if the given x/y value is valid for the Placement position
     static bool isValidPos(int x, int y)
     {
@@ -168,17 +195,24 @@ namespace BWAPI
           proc(this, x, y);
     };
 
-    bool hasValidSpace() const
+    // Whether any location with a 1 passes the full check. Locations that the cache shows to
+    // be clear of buildings are tried first, since they usually pass.
+    bool hasValidSpace()
     {
       // Get min/max distances
       int min = MAX_RANGE/2 - maxSearch/2;
       int max = min + maxSearch;
-      for ( int y = min; y < max; ++y )
+      for ( int pass = 0; pass < 2; ++pass )
       {
-        for ( int x = min; x < max; ++x )
+        for ( int y = min; y < max; ++y )
         {
-          if ( this->getValue(x,y) == 1 )
-            return true;
+          for ( int x = min; x < max; ++x )
+          {
+            if ( this->getValue(x,y) != 1 || (pass == 0) != isLikelyBuildable(x,y) )
+              continue;
+            if ( this->isFullyBuildable(x,y) )
+              return true;
+          }
         }
       }
       return false;
@@ -205,37 +239,62 @@ namespace BWAPI
       return this->maxSearch;
     };
   private:
+    static const signed char UNCHECKED = -1;
+
+    bool isLikelyBuildable(int x, int y) const
+    {
+      TilePosition p = start + TilePosition(x,y);
+      return cache.isFree(p, type.tileSize()) &&
+             (!type.canBuildAddon() || cache.isFree(p + TilePosition(4,1), TilePosition(2,2)));
+    };
+
     unsigned char data[MAX_RANGE][MAX_RANGE];
     unsigned char save[MAX_RANGE][MAX_RANGE];
+    signed char checked[MAX_RANGE][MAX_RANGE];
     int maxSearch;
+    const PlacementCache &cache;
+    UnitType type;
+    TilePosition start;
   };
 
-  void AssignBuildableLocations(PlacementReserve &reserve, UnitType type, TilePosition desiredPosition)
+  void AssignBuildableLocations(PlacementReserve &reserve, const PlacementCache &cache, UnitType type, TilePosition desiredPosition)
   {
     TilePosition start = desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2;
     
     // Reserve space for the addon as well
     bool hasAddon = type.canBuildAddon();
     
-    // Assign 1 to all buildable locations
+    // Assign 1 to all locations on buildable terrain, which canBuildHere requires. The
+    // reserve makes the full check where it matters. Refineries go on geysers, whose terrain
+    // is not buildable, so they are checked in full here.
     reserve.iterate( [&](PlacementReserve *pr, int x, int y)
                       { 
-                        if ( (!hasAddon || Broodwar->canBuildHere(start+TilePosition(x+4,y+1), UnitTypes::Terran_Missile_Turret) ) &&
-                          Broodwar->canBuildHere(start+TilePosition(x,y), type) )
+                        bool clear;
+                        if ( type.isRefinery() )
+                          clear = pr->isFullyBuildable(x, y);
+                        else
                         {
-                          pr->setValue(x, y, 1);
+                          TilePosition p = start + TilePosition(x,y);
+                          clear = cache.isBuildable(p, type.tileSize()) &&
+                                  (!hasAddon || cache.isBuildable(p + TilePosition(4,1), TilePosition(2,2)));
                         }
+                        if ( clear )
+                          pr->setValue(x, y, 1);
                       });
   }
 
-  void RemoveDisconnected(PlacementReserve &reserve, TilePosition desiredPosition)
+  void RemoveDisconnected(PlacementReserve &reserve, const PlacementCache &cache, TilePosition desiredPosition)
   {
     TilePosition start = desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2;
 
+    // Same test as Game::hasPath, using the region groups cached per tile
+    int desiredGroup = cache.getRegionGroup(desiredPosition);
+
     // Assign 0 to all locations that aren't connected
     reserve.iterate( [&](PlacementReserve *pr, int x, int y)
                       { 
-                        if ( !Broodwar->hasPath(Position(desiredPosition), Position(start + TilePosition(x,y)) ) )
+                        int group = cache.getRegionGroup(start + TilePosition(x,y));
+                        if ( desiredGroup < 0 || group != desiredGroup )
                           pr->setValue(x, y, 0);
                       });
   }
@@ -272,16 +331,16 @@ namespace BWAPI
     reserve.restoreIfInvalid(__FUNCTION__);
   }*/
 
-  void ReserveGroundHeight(PlacementReserve &reserve, TilePosition desiredPosition)
+  void ReserveGroundHeight(PlacementReserve &reserve, const PlacementCache &cache, TilePosition desiredPosition)
   {
     TilePosition start = desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2;
 
     // Exclude locations with a different ground height, but restore a backup in case there are no more build locations
     reserve.backup();
-    int targetHeight = Broodwar->getGroundHeight(desiredPosition);
+    int targetHeight = cache.getGroundHeight(desiredPosition);
     reserve.iterate( [&](PlacementReserve *pr, int x, int y)
                       { 
-                        if ( Broodwar->getGroundHeight( start + TilePosition(x,y) ) != targetHeight )
+                        if ( cache.getGroundHeight( start + TilePosition(x,y) ) != targetHeight )
                           pr->setValue(x, y, 0);
                       });
 
@@ -402,13 +461,13 @@ namespace BWAPI
     reserve.restoreIfInvalid(__FUNCTION__);
   }
 
-  void ReservePlacement(PlacementReserve &reserve, UnitType type, TilePosition desiredPosition, bool /*creep*/)
+  void ReservePlacement(PlacementReserve &reserve, const PlacementCache &cache, UnitType type, TilePosition desiredPosition, bool /*creep*/)
   {
     // Reset the array
     reserve.reset();
 
-    AssignBuildableLocations(reserve, type, desiredPosition);
-    RemoveDisconnected(reserve, desiredPosition);
+    AssignBuildableLocations(reserve, cache, type, desiredPosition);
+    RemoveDisconnected(reserve, cache, desiredPosition);
     
     // @TODO: Assign 0 to all locations that have a ground distance > maxRange
 
@@ -424,7 +483,7 @@ namespace BWAPI
     if ( !reserve.hasValidSpace() )
       return;
     
-    ReserveGroundHeight(reserve, desiredPosition);
+    ReserveGroundHeight(reserve, cache, desiredPosition);
     //ReserveUnbuildable(reserve, type, desiredPosition); // NOTE: canBuildHere already includes this!
 
     if ( !type.isResourceDepot() )
@@ -500,6 +559,57 @@ namespace BWAPI
     reserve.restoreIfInvalid(__FUNCTION__);
   }
 
+  // The closest location left in the reserve that passes the full check, using the walking
+  // distance where there is a path. Walking is never shorter than the straight line, so the
+  // locations are visited by straight line distance and the walking distance is only looked
+  // up for the ones that could still win. Ties go to the first location row by row.
+  TilePosition FindClosestLocation(PlacementReserve &reserve, TilePosition desiredPosition)
+  {
+    TilePosition centerPosition = desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2;
+
+    // The straight line distance and the row by row index of each location
+    std::vector<std::pair<int, int>> candidates;
+    for ( int y = 0; y < MAX_RANGE; ++y )
+      for ( int x = 0; x < MAX_RANGE; ++x )
+      {
+        // Ignore if space is reserved
+        if ( reserve.getValue(x,y) == 0 )
+          continue;
+        TilePosition currentPosition(TilePosition(x,y) + centerPosition);
+        candidates.push_back({ desiredPosition.getApproxDistance(currentPosition), y * MAX_RANGE + x });
+      }
+    std::sort(candidates.begin(), candidates.end());
+
+    int bestDistance = 999999, bestIndex = 0;
+    TilePosition bestPosition = TilePositions::None;
+    for ( auto &c : candidates )
+    {
+      if ( c.first > bestDistance )
+        break;
+      if ( c.first == bestDistance && c.second > bestIndex )
+        continue;
+
+      // Most locations that get this far are the winner, so the full check comes before the
+      // walking distance
+      int x = c.second % MAX_RANGE, y = c.second / MAX_RANGE;
+      if ( !reserve.isFullyBuildable(x, y) )
+        continue;
+
+      TilePosition currentPosition(TilePosition(x,y) + centerPosition);
+      int currentDistance = c.first;
+      int groundDistance = Broodwar->getGroundDistance(Position(desiredPosition), Position(currentPosition));
+      if ( groundDistance >= 0 )
+        currentDistance = std::max(currentDistance, groundDistance / 32);
+
+      if ( currentDistance > bestDistance || (currentDistance == bestDistance && c.second > bestIndex) )
+        continue;
+      bestDistance = currentDistance;
+      bestIndex = c.second;
+      bestPosition = currentPosition;
+    }
+    return bestPosition;
+  }
+
   // ----- GET BUILD LOCATION
   // @TODO: If self() is nullptr, this will crash
   TilePosition Game::getBuildLocation(UnitType type, TilePosition desiredPosition, int maxRange, bool creep) const
@@ -516,7 +626,6 @@ namespace BWAPI
 
     // Do type-specific checks
     bool trimPlacement = true;
-    Region pTargRegion = nullptr;
     Unit pSpecialUnitTarget = nullptr;
     switch ( type )
     {
@@ -541,63 +650,25 @@ namespace BWAPI
       break;
     }
     
-    PlacementReserve reserve(maxRange);
-    ReservePlacement(reserve, type, desiredPosition, creep);
-
+    // Reuse the answer to the same question while no unit has changed, as long as the
+    // location can still be built on
+    PlacementCache &cache = this->getPlacementCache();
+    cache.refresh(*this);
+    TilePosition bestPosition = cache.findLocation(type, desiredPosition, maxRange, creep,
+                                                   [&](TilePosition p) { return isFullyBuildable(p, type); });
+    if ( bestPosition != TilePositions::None )
+      return bestPosition;
+
+    // The closest location that passes the full check wins. If it is beyond maxRange, then
+    // no location within range passed, so it is the fallback.
+    PlacementReserve reserve(maxRange, cache, type, desiredPosition);
+    ReservePlacement(reserve, cache, type, desiredPosition, creep);
     if ( trimPlacement )
       reserveTemplateSpacing(reserve);
+    bestPosition = FindClosestLocation(reserve, desiredPosition);
 
-    TilePosition centerPosition = desiredPosition - TilePosition(MAX_RANGE,MAX_RANGE)/2;
-    if ( pTargRegion != nullptr )
-      desiredPosition = TilePosition(pTargRegion->getCenter());
-    
-    // Find the best position
-    int bestDistance, fallbackDistance;
-    TilePosition bestPosition, fallbackPosition;
-
-    bestDistance = fallbackDistance = 999999;
-    bestPosition = fallbackPosition = TilePositions::None;
-    for ( int passCount = 0; passCount < (pTargRegion ? 2 : 1); ++passCount )
-    {
-      for ( int y = 0; y < MAX_RANGE; ++y )
-        for ( int x = 0; x < MAX_RANGE; ++x )
-        {
-          // Ignore if space is reserved
-          if ( reserve.getValue(x,y) == 0 )
-            continue;
-
-          TilePosition currentPosition(TilePosition(x,y) + centerPosition);
-          int currentDistance = desiredPosition.getApproxDistance(currentPosition);//Broodwar->getGroundDistance( desiredPosition, currentPosition );
-          if ( currentDistance < bestDistance )
-          {
-            if ( currentDistance <= maxRange )
-            {
-              bestDistance = currentDistance;
-              bestPosition = currentPosition;
-            }
-            else if ( currentDistance < fallbackDistance )
-            {
-              fallbackDistance = currentDistance;
-              fallbackPosition = currentPosition;
-            }
-          }
-        }
-      // Break pass if position is found
-      if ( bestPosition != TilePositions::None )
-        break;
-
-      // Break if an alternative position was found
-      if ( fallbackPosition != TilePositions::None )
-      {
-        bestPosition = fallbackPosition;
-        break;
-      }
-
-      // If we were really targetting a region, and couldn't find a position above
-      if ( pTargRegion != nullptr ) // Then fallback to the default build position
-        desiredPosition = centerPosition;
-    }
-
+    if ( bestPosition != TilePositions::None )
+      cache.addLocation(type, desiredPosition, maxRange, creep, bestPosition);
     return bestPosition;
   }
   //------------------------------------------ ACTIONS -----------------------------------------------
@@ -0,0 +1,142 @@
+#include <BWAPI/PlacementCache.h>
+#include <BWAPI/Game.h>
+#include <BWAPI/Region.h>
+#include <BWAPI/Unit.h>
+#include <BWAPI/Unitset.h>
+
+#include <algorithm>
+
+namespace BWAPI
+{
+  //------------------------------------------------- CLEAR --------------------------------------------------
+  void PlacementCache::clear()
+  {
+    initialized = false;
+    lastFrame = -1;
+    footprints.clear();
+    locations.clear();
+  }
+  void PlacementCache::invalidate()
+  {
+    locations.clear();
+  }
+  //------------------------------------------------ REFRESH -------------------------------------------------
+  void PlacementCache::refresh(const Game &game)
+  {
+    int frame = game.getFrameCount();
+    if ( initialized && frame == lastFrame )
+      return;
+
+    bool isNewMatch = !initialized;
+    if ( isNewMatch )
+    {
+      readTerrain(game);
+      initialized = true;
+    }
+    lastFrame = frame;
+
+    // Gather the footprints of everything that blocks construction, in unit ID order so
+    // that they can be compared with the previous frame's
+    current.clear();
+    for ( Unit u : game.getAllUnits() )
+    {
+      UnitType t = u->getType();
+      if ( !(t.isBuilding() && !u->isLifted()) && !t.isResourceContainer() )
+        continue;
+      TilePosition tp = u->getTilePosition();
+      current.push_back({ u->getID(), tp.x, tp.y, t.tileWidth(), t.tileHeight() });
+    }
+    std::sort(current.begin(), current.end(), [](const Footprint &a, const Footprint &b) { return a.id < b.id; });
+
+    if ( isNewMatch || current != footprints )
+    {
+      footprints.swap(current);
+      rebuildBlocked();
+      locations.clear();
+    }
+  }
+  //------------------------------------------------ QUERIES -------------------------------------------------
+  bool PlacementCache::isBuildable(TilePosition lt, TilePosition size) const
+  {
+    return countInside(unbuildableSums, lt, size) == 0;
+  }
+  bool PlacementCache::isFree(TilePosition lt, TilePosition size) const
+  {
+    return countInside(blockedSums, lt, size) == 0;
+  }
+  int PlacementCache::getGroundHeight(TilePosition p) const
+  {
+    return isOnMap(p) ? heights[p.y * width + p.x] : 0;
+  }
+  int PlacementCache::getRegionGroup(TilePosition p) const
+  {
+    return isOnMap(p) ? groups[p.y * width + p.x] : -1;
+  }
+  void PlacementCache::addLocation(UnitType type, TilePosition desiredPosition, int maxRange, bool creep, TilePosition location)
+  {
+    if ( locations.size() >= MAX_LOCATIONS )
+      locations.clear();
+    locations.push_back({ type, desiredPosition, maxRange, creep, location });
+  }
+  //---------------------------------------------- READ TERRAIN ----------------------------------------------
+  void PlacementCache::readTerrain(const Game &game)
+  {
+    width = game.mapWidth();
+    height = game.mapHeight();
+
+    buildable.assign(width * height, 0);
+    heights.assign(width * height, 0);
+    groups.assign(width * height, -1);
+    for ( int y = 0; y < height; ++y )
+    {
+      for ( int x = 0; x < width; ++x )
+      {
+        buildable[y * width + x] = game.isBuildable(x, y);
+        heights[y * width + x] = game.getGroundHeight(x, y);
+        Region rgn = game.getRegionAt(Position(TilePosition(x, y)));
+        groups[y * width + x] = rgn ? rgn->getRegionGroupID() : -1;
+      }
+    }
+
+    std::vector<char> unbuildable(width * height);
+    for ( int i = 0; i < width * height; ++i )
+      unbuildable[i] = !buildable[i];
+    buildTable(unbuildable, unbuildableSums);
+  }
+  //--------------------------------------------- REBUILD BLOCKED --------------------------------------------
+  void PlacementCache::rebuildBlocked()
+  {
+    std::vector<char> blocked(width * height);
+    for ( int i = 0; i < width * height; ++i )
+      blocked[i] = !buildable[i];
+    for ( const Footprint &f : footprints )
+    {
+      for ( int y = std::max(f.y, 0); y < std::min(f.y + f.h, height); ++y )
+        for ( int x = std::max(f.x, 0); x < std::min(f.x + f.w, width); ++x )
+          blocked[y * width + x] = 1;
+    }
+    buildTable(blocked, blockedSums);
+  }
+  //---------------------------------------------- SUMMED AREA -----------------------------------------------
+  int PlacementCache::countInside(const std::vector<int> &table, TilePosition lt, TilePosition size) const
+  {
+    if ( lt.x < 0 || lt.y < 0 || lt.x + size.x > width || lt.y + size.y > height )
+      return -1;
+    int right = lt.x + size.x, bottom = lt.y + size.y;
+    auto at = [&](int x, int y) { return table[y * (width + 1) + x]; };
+    return at(right, bottom) - at(lt.x, bottom) - at(right, lt.y) + at(lt.x, lt.y);
+  }
+  void PlacementCache::buildTable(const std::vector<char> &counted, std::vector<int> &table) const
+  {
+    table.assign((width + 1) * (height + 1), 0);
+    for ( int y = 0; y < height; ++y )
+    {
+      int row = 0;
+      for ( int x = 0; x < width; ++x )
+      {
+        row += counted[y * width + x];
+        table[(y + 1) * (width + 1) + x + 1] = table[y * (width + 1) + x + 1] + row;
+      }
+    }
+  }
+}
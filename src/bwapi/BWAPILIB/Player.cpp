@@ -13,6 +13,12 @@ int PlayerInterface::incompleteUnitCount(UnitType unit) const
 }
 //--------------------------------------------- MAX ENERGY -------------------------------------------------
 int PlayerInterface::maxEnergy(UnitType unit) const
+{
+  if ( hasUnitStats(unit) )
+    return unitStats[unit].maxEnergy;
+  return computeMaxEnergy(unit);
+}
+int PlayerInterface::computeMaxEnergy(UnitType unit) const
 {
   int energy = unit.maxEnergy();
   if ((unit == UnitTypes::Protoss_Arbiter       && getUpgradeLevel(UpgradeTypes::Khaydarin_Core)    > 0) ||
@@ -31,6 +37,12 @@ int PlayerInterface::maxEnergy(UnitType unit) const
 }
 //--------------------------------------------- TOP SPEED --------------------------------------------------
 double PlayerInterface::topSpeed(UnitType unit) const
+{
+  if ( hasUnitStats(unit) )
+    return unitStats[unit].topSpeed;
+  return computeTopSpeed(unit);
+}
+double PlayerInterface::computeTopSpeed(UnitType unit) const
 {
   double speed = unit.topSpeed();
   if ((unit == UnitTypes::Terran_Vulture   && getUpgradeLevel(UpgradeTypes::Ion_Thrusters)        > 0) ||
@@ -56,6 +68,12 @@ double PlayerInterface::topSpeed(UnitType unit) const
 }
 //----------------------------------------------- WEAPON MAX RANGE -----------------------------------------
 int PlayerInterface::weaponMaxRange(WeaponType weapon) const
+{
+  if ( hasWeaponStats(weapon) )
+    return weaponStats[weapon].maxRange;
+  return computeWeaponMaxRange(weapon);
+}
+int PlayerInterface::computeWeaponMaxRange(WeaponType weapon) const
 {
   int range = weapon.maxRange();
   if ( (weapon == WeaponTypes::Gauss_Rifle   && getUpgradeLevel(UpgradeTypes::U_238_Shells)   > 0) ||
@@ -69,6 +87,12 @@ int PlayerInterface::weaponMaxRange(WeaponType weapon) const
 }
 //--------------------------------------------- SIGHT RANGE ------------------------------------------------
 int PlayerInterface::sightRange(UnitType unit) const
+{
+  if ( hasUnitStats(unit) )
+    return unitStats[unit].sightRange;
+  return computeSightRange(unit);
+}
+int PlayerInterface::computeSightRange(UnitType unit) const
 {
   int range = unit.sightRange();
   if ((unit == UnitTypes::Terran_Ghost     && getUpgradeLevel(UpgradeTypes::Ocular_Implants) > 0) ||
@@ -80,6 +104,12 @@ int PlayerInterface::sightRange(UnitType unit) const
 }
 //--------------------------------------------- GROUND WEAPON DAMAGE COOLDOWN ------------------------------
 int PlayerInterface::weaponDamageCooldown(UnitType unit) const
+{
+  if ( hasUnitStats(unit) )
+    return unitStats[unit].weaponDamageCooldown;
+  return computeWeaponDamageCooldown(unit);
+}
+int PlayerInterface::computeWeaponDamageCooldown(UnitType unit) const
 {
   int cooldown = unit.groundWeapon().damageCooldown();
   if (unit == UnitTypes::Zerg_Zergling && getUpgradeLevel(UpgradeTypes::Adrenal_Glands) > 0)
@@ -93,6 +123,12 @@ int PlayerInterface::weaponDamageCooldown(UnitType unit) const
 }
 //--------------------------------------------- ARMOR ------------------------------------------------------
 int PlayerInterface::armor(UnitType unit) const
+{
+  if ( hasUnitStats(unit) )
+    return unitStats[unit].armor;
+  return computeArmor(unit);
+}
+int PlayerInterface::computeArmor(UnitType unit) const
 {
   int armor = unit.armor();
   armor += getUpgradeLevel(unit.armorUpgrade());
@@ -104,12 +140,66 @@ int PlayerInterface::armor(UnitType unit) const
 }
 //-------------------------------------------- DAMAGE ------------------------------------------------------
 int PlayerInterface::damage(WeaponType wpn) const
+{
+  if ( hasWeaponStats(wpn) )
+    return weaponStats[wpn].damage;
+  return computeDamage(wpn);
+}
+int PlayerInterface::computeDamage(WeaponType wpn) const
 {
   int dmg = wpn.damageAmount();
   dmg += getUpgradeLevel(wpn.upgradeType()) * wpn.damageBonus();
   dmg *= wpn.damageFactor();
   return dmg;
 }
+//-------------------------------------------- UPDATE STATS ------------------------------------------------
+bool PlayerInterface::updateStats()
+{
+  // Every stat depends on nothing but the upgrade levels, so those are all we compare
+  bool isChanged = statUpgradeLevels.size() != UpgradeTypes::Enum::MAX;
+  statUpgradeLevels.resize(UpgradeTypes::Enum::MAX);
+  for ( int i = 0; i < UpgradeTypes::Enum::MAX; ++i )
+  {
+    int level = getUpgradeLevel(UpgradeType(i));
+    if ( statUpgradeLevels[i] != level )
+    {
+      statUpgradeLevels[i] = level;
+      isChanged = true;
+    }
+  }
+  if ( !isChanged )
+    return false;
+
+  // Clear the tables first so that the compute functions are used while filling them
+  unitStats.clear();
+  weaponStats.clear();
+
+  std::vector<UnitStats> units(UnitTypes::Enum::MAX);
+  for ( int i = 0; i < UnitTypes::Enum::MAX; ++i )
+  {
+    UnitType unit(i);
+    units[i] = { computeMaxEnergy(unit), computeTopSpeed(unit), computeSightRange(unit),
+                 computeWeaponDamageCooldown(unit), computeArmor(unit) };
+  }
+  std::vector<WeaponStats> weapons(WeaponTypes::Enum::MAX);
+  for ( int i = 0; i < WeaponTypes::Enum::MAX; ++i )
+  {
+    WeaponType weapon(i);
+    weapons[i] = { computeDamage(weapon), computeWeaponMaxRange(weapon) };
+  }
+
+  unitStats = std::move(units);
+  weaponStats = std::move(weapons);
+  return true;
+}
+bool PlayerInterface::hasUnitStats(UnitType unit) const
+{
+  return static_cast<unsigned>(unit.getID()) < unitStats.size();
+}
+bool PlayerInterface::hasWeaponStats(WeaponType weapon) const
+{
+  return static_cast<unsigned>(weapon.getID()) < weaponStats.size();
+}
 //-------------------------------------------- TEXT COLOR --------------------------------------------------
 char PlayerInterface::getTextColor() const
 {
@@ -1,6 +1,7 @@
 #include <BWAPI/Playerset.h>
 
 #include <BWAPI/Unitset.h>
+#include <BWAPI/Unit.h>
 #include <BWAPI/Player.h>
 
 #include <BWAPI/Filters.h>
@@ -1,6 +1,7 @@
 #include <BWAPI/Regionset.h>
 #include <BWAPI/Region.h>
 #include <BWAPI/Unitset.h>
+#include <BWAPI/Unit.h>
 
 #include <utility>
 
@@ -32,7 +32,7 @@ namespace BWAPI
     template <typename _T>
     inline BestFilter<_PARAM> operator &&(const _T &other) const
     {
-      return [=](_PARAM p1, _PARAM p2)->_PARAM{ return other( (*this)(p1, p2) ); };
+      return [self = *this, other](_PARAM p1, _PARAM p2)->_PARAM{ return other( self(p1, p2) ); };
     };
 
     // call
@@ -5,8 +5,13 @@
 #include "PlayerImpl.h"
 #include "UnitImpl.h"
 #include "GameTable.h"
+#include "FrameRecording.h"
 
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include "FrameSync.h"
+#endif
 
 
 namespace BWAPI
@@ -24,11 +29,23 @@ namespace BWAPI
 
     GameData* data = nullptr;
   private:
+#ifdef _WIN32
     HANDLE      pipeObjectHandle;
     HANDLE      mapFileHandle;
     HANDLE      gameTableFileHandle;
+#else
+    // On POSIX hosts the shared memory objects are mapped and their descriptors closed
+    // right away, so only the mappings themselves and the server's identity are kept.
+    FrameSync*  frameSync = nullptr;
+    int         serverProcID = -1;
+    int         gameTableIndex = -1;
+#endif
     GameTable*  gameTable = nullptr;
 
+    // Writes every frame received from the server to disk when BWAPI_RECORD_FRAMES is
+    // set, so that the game can later be replayed by the replay server.
+    FrameRecorder recorder;
+
     bool connected = false;
   };
   extern Client BWAPIClient;
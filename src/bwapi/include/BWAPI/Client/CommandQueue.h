@@ -0,0 +1,84 @@
+#pragma once
+#include <BWAPI.h>
+
+#include "GameData.h"
+
+#include <vector>
+
+namespace BWAPI
+{
+  // Sits in front of the unit command buffer in shared memory, filtering the commands that
+  // UnitImpl::issueCommand is about to send. It is disabled by default, in which case every
+  // command goes through unchanged. When enabled:
+  //  - A command that is identical to the unit's last command, while the unit is still
+  //    carrying out the order that command gave it, is dropped before any checks are made,
+  //    and issueCommand reports success.
+  //  - A command that replaces the unit's order overwrites the entry of an earlier command
+  //    to the same unit in the same frame instead of adding another entry, since only the
+  //    last of them would have had any effect.
+  //  - Once the frame budget of new entries is used up, further commands are dropped and
+  //    issueCommand fails with Errors::Unit_Busy. Coalesced commands don't count against
+  //    the budget.
+  class CommandQueue
+  {
+  public:
+    struct Counters
+    {
+      // Commands that were added to the buffer as new entries.
+      int issued = 0;
+      // Commands dropped because the unit was already carrying them out.
+      int duplicates = 0;
+      // Commands that overwrote an earlier entry for the same unit.
+      int coalesced = 0;
+      // Commands dropped because the frame budget was used up.
+      int overBudget = 0;
+
+      int dropped() const;
+    };
+
+    CommandQueue(const GameData *data);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Sets the maximum number of new entries in the command buffer per frame. A budget of
+    // zero or less means that there is no limit.
+    void setFrameBudget(int budget);
+    int getFrameBudget() const;
+
+    // The counters of the current frame, and the totals since the match started.
+    const Counters& getFrameCounters() const;
+    const Counters& getTotalCounters() const;
+
+    // Forgets the entries and counters of the previous match. The settings are kept.
+    void clear();
+
+    // Used by UnitImpl::issueCommand before checking whether the command can be issued.
+    // Returns true if the command is redundant, counting it as a duplicate.
+    bool isDuplicate(Unit unit, const UnitCommand &command);
+    // Gets the entry that the command should overwrite, or -1 if it needs a new entry.
+    int findSlot(Unit unit, const UnitCommand &command);
+    // Returns false and counts the command as over budget if it can't have a new entry.
+    bool reserve();
+
+    // Records that the command of a unit was written to the given entry.
+    void onIssued(int unitIndex, int slot, bool coalesced);
+
+  private:
+    // Resets the frame counters when a new frame has started.
+    void updateFrame();
+
+    const GameData *data;
+    bool enabled = false;
+    int frameBudget = 0;
+
+    int frame = -1;
+    Counters frameCounters;
+    Counters totalCounters;
+
+    // The entry of each unit's last command in the buffer, valid while slotFrames holds the
+    // current frame.
+    std::vector<int> slots;
+    std::vector<int> slotFrames;
+  };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "GameData.h"
+
+#include <fstream>
+#include <vector>
+
+namespace BWAPI
+{
+  // Recordings store the GameData the server publishes at the start of every frame, so
+  // that a game can be played back to a client without StarCraft running. GameData is
+  // tens of megabytes, so every frame only stores the pages that changed since the
+  // previous one. Pages that lie entirely in the client-to-server area (strings, shapes
+  // and commands) are never stored, since the server resets those every frame anyway.
+  struct FrameRecordingHeader
+  {
+    static const unsigned VERSION   = 1;
+    static const unsigned PAGE_SIZE = 4096;
+
+    char magic[8];
+    unsigned version;
+    unsigned pageSize;
+    unsigned long long dataSize;
+    int clientVersion;
+  };
+
+  class FrameRecorder
+  {
+  public:
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+
+    // Appends the pages of 'data' that differ from the previously recorded frame.
+    void recordFrame(const GameData& data);
+
+    int getFrameCount() const;
+  private:
+    std::ofstream file;
+    std::vector<char> previous;
+    int frameCount = 0;
+  };
+
+  class FrameReader
+  {
+  public:
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+
+    // Copies the pages recorded for the next frame over 'data', which must hold the
+    // result of every earlier readFrame() call. Returns false once the recording has
+    // run out of frames.
+    bool readFrame(GameData& data);
+
+    int getFrameCount() const;
+    int getClientVersion() const;
+  private:
+    std::ifstream file;
+    FrameRecordingHeader header{};
+    int frameCount = 0;
+  };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace BWAPI
+{
+  // The frame handshake used by the POSIX transport in place of the Windows named pipe.
+  // The block lives in its own shared memory object next to GameData and carries the
+  // same codes the pipe does: the client publishes CLIENT_READY when it is done with a
+  // frame and the server answers with SERVER_READY once the next frame has been written.
+  // Both sides sleep on the code with a futex, so a frame costs two wakeups instead of
+  // two pipe round trips through the kernel. Futexes are Linux only, so this transport is
+  // too, even though the shared memory objects themselves are plain POSIX.
+  struct FrameSync
+  {
+    static const int NONE         =  0;
+    static const int CLIENT_READY =  1;
+    static const int SERVER_READY =  2;
+    // Written by the server when it has no more frames to send.
+    static const int SERVER_CLOSED = -1;
+
+    std::atomic<int> code;
+    int clientProcessID;
+  };
+
+  static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free,
+    "FrameSync::code must be usable as a futex word");
+
+  // Publishes a new code and wakes whoever is sleeping on the other side.
+  inline void signalFrameSync(FrameSync* sync, int code)
+  {
+    sync->code.store(code, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<int*>(&sync->code), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  // Sleeps while the code is still equal to 'current', for at most timeoutMs
+  // milliseconds. Returns the code that was observed last, which is 'current' itself if
+  // the wait timed out.
+  inline int waitFrameSync(FrameSync* sync, int current, int timeoutMs)
+  {
+    timespec timeout;
+    timeout.tv_sec  = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    int code = sync->code.load(std::memory_order_acquire);
+    if ( code == current )
+    {
+      // A spurious wakeup or EAGAIN just means we should look at the word again.
+      syscall(SYS_futex, reinterpret_cast<int*>(&sync->code), FUTEX_WAIT, current, &timeout, nullptr, 0);
+      code = sync->code.load(std::memory_order_acquire);
+    }
+    return code;
+  }
+}
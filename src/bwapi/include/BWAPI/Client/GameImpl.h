@@ -1,5 +1,6 @@
 #pragma once
 #include <BWAPI.h>
+#include <BWAPI/PlacementCache.h>
 
 #include "GameData.h"
 #include "Client.h"
@@ -11,10 +12,15 @@
 #include "RegionImpl.h"
 #include "UnitImpl.h"
 #include "BulletImpl.h"
+#include "UnitGrid.h"
+#include "RegionGraph.h"
+#include "CommandQueue.h"
 
 #include <list>
 #include <vector>
 #include <array>
+#include <span>
+#include <string_view>
 
 namespace BWAPI
 {
@@ -25,13 +31,26 @@ namespace BWAPI
 
   class GameImpl : public Game
   {
+    public :
+      // A text event of the current frame. The text points into the shared memory, so it
+      // is only valid until the next call to Client::update().
+      struct TextEvent
+      {
+        Player player;
+        std::string_view text;
+      };
+
     private :
       int addShape(const BWAPIC::Shape &s);
       int addString(const char* text);
       int addText(BWAPIC::Shape &s, const char* text);
       int addCommand(const BWAPIC::Command &c);
       void processInterfaceEvents();
+      void updateChangedUnits();
+      void markChanged(int unitIndex);
       void clearAll();
+      void clearEvents();
+      void addEvent(const BWAPIC::Event &e);
 
       GameData* data;
       std::vector<ForceImpl>  forceVector;
@@ -55,9 +74,25 @@ namespace BWAPI
       Unitset selectedUnits;
       Unitset pylons;
       Regionset regionsList;
+      UnitGrid unitGrid;
+      RegionGraph regionGraph;
+      mutable PlacementCache placementCache;
+      CommandQueue commandQueue;
+      Unitset changedUnits;
+      Unitset commandedUnits;
+      std::vector<UnitData> unitDataCache;
 
       TilePosition::list startLocations;
-      std::list< Event > events;
+
+      // The events of the current frame. The buffers keep their memory between frames, so
+      // once they have grown large enough the events are read without allocating.
+      std::vector< Event > eventBuffer;
+      std::array< std::vector< Unit >, EventType::None > unitEvents;
+      std::array< std::vector< TextEvent >, EventType::None > textEvents;
+
+      // getEvents() returns a list, which is only built from eventBuffer when asked for.
+      mutable std::list< Event > events;
+      mutable bool isEventListValid = false;
       Player thePlayer;
       Player theEnemy;
       Player theNeutral;
@@ -70,6 +105,7 @@ namespace BWAPI
     public :
       Event makeEvent(BWAPIC::Event e);
       int addUnitCommand(BWAPIC::UnitCommand& c);
+      void replaceUnitCommand(int index, BWAPIC::UnitCommand& c);
       bool inGame;
       GameImpl(GameData* data);
       void onMatchStart();
@@ -78,6 +114,37 @@ namespace BWAPI
       const GameData* getGameData() const;
       Unit _unitFromIndex(int index);
 
+      // The spatial index behind getUnitsInRectangle() and friends, rebuilt every frame.
+      // Its callback and buffer based queries can be used directly to avoid building a
+      // Unitset for every query.
+      const UnitGrid& getUnitGrid() const;
+
+      // The accessible units whose shared memory data changed since the previous frame,
+      // plus units that were given a command and units whose larva, interceptors or loaded
+      // units changed. A unit that is not in this set returns the same values as last frame.
+      const Unitset& getChangedUnits() const;
+
+      // The walkable region graph with its chokepoints and the distances between
+      // regions, built when the match starts. It answers getGroundDistance() and can give
+      // the chokepoints along a path.
+      const RegionGraph& getRegionGraph() const;
+
+      // The filter that UnitImpl::issueCommand passes commands through. It is disabled
+      // until it is enabled here, and its settings are kept between matches.
+      CommandQueue& getCommandQueue();
+
+      // The events of the current frame in order, like getEvents(), but in a buffer that is
+      // reused between frames instead of a list that is built for every frame.
+      std::span< const Event > getEventBuffer() const;
+
+      // The units of all events of a unit event type this frame, such as UnitCreate, in the
+      // order they happened. Other event types give nothing.
+      std::span< const Unit > getUnitEvents(EventType::Enum type) const;
+
+      // The texts of all events of a text event type this frame, which are SendText,
+      // ReceiveText and SaveGame. The player is only set for ReceiveText.
+      std::span< const TextEvent > getTextEvents(EventType::Enum type) const;
+
       virtual const Forceset& getForces() const override;
       virtual const Playerset& getPlayers() const override;
       virtual const Unitset& getAllUnits() const override;
@@ -195,8 +262,12 @@ namespace BWAPI
       virtual int  countdownTimer() const override;
       virtual const Regionset &getAllRegions() const override;
       virtual BWAPI::Region getRegionAt(int x, int y) const override;
+      virtual int getGroundDistance(Position source, Position destination) const override;
       virtual int getLastEventTime() const override;
       virtual bool setRevealAll(bool reveal = true) override;
       virtual unsigned getRandomSeed() const override;
+
+    protected :
+      virtual PlacementCache &getPlacementCache() const override;
   };
 }
@@ -0,0 +1,102 @@
+#pragma once
+#include <BWAPI.h>
+
+#include "GameData.h"
+
+#include <mutex>
+#include <vector>
+
+namespace BWAPI
+{
+  // A graph of the walkable regions of the map, built once in GameImpl::onMatchStart from
+  // the region data and walkability in shared memory. Two regions are adjacent when they
+  // share a walkable border, and each shared border is a chokepoint placed at the border
+  // mini-tile closest to the border's average position. The shortest paths from the center
+  // of a region to the centers of all others are computed the first time a query starts
+  // in that region, and kept for later queries, so most ground distance and path queries
+  // only look up a few table entries rather than searching. The rows kept at a time hold
+  // at most MAX_ENTRIES entries, which is enough for every region on most maps, while
+  // bounding the memory on maps with thousands of regions where a table for all pairs
+  // would take over a hundred megabytes. Queries lock the table, so they can be made from
+  // several threads.
+  class RegionGraph
+  {
+  public:
+    struct Chokepoint
+    {
+      Position center;
+      // The length of the shared border in pixels, measured across its bounding box.
+      int width;
+      int regions[2];
+    };
+
+    void build(const GameData *data);
+    void clear();
+
+    // The ground distance between two positions, following the shortest path between their
+    // regions through chokepoints. Positions in the same region are measured in a straight
+    // line. Returns -1 if either position is unwalkable or there is no path.
+    int getGroundDistance(Position source, Position destination) const;
+
+    // The length of the shortest path between the centers of two regions, or -1 if there
+    // is none.
+    int getRegionDistance(int sourceRegion, int destinationRegion) const;
+
+    // Appends the chokepoints on the shortest path from source to destination to 'path',
+    // followed by the destination itself. Returns false and leaves 'path' unchanged if
+    // there is no path.
+    bool getPath(Position source, Position destination, std::vector<Position> &path) const;
+
+    // The region ID at a position, resolving tiles that are split between two regions.
+    // Returns -1 if the position is outside the map.
+    int getRegionID(Position position) const;
+
+    const std::vector<Chokepoint>& getChokepoints() const;
+
+  private:
+    // At 8 bytes per entry, the rows take at most 16 MB.
+    static const int MAX_ENTRIES = 1 << 21;
+
+    struct Edge
+    {
+      int to;
+      int chokepoint;
+      int weight;
+    };
+
+    // The shortest paths from one node to every other node: the distance between their
+    // centers, which is -1 if there is no path, and the first and last chokepoints crossed
+    // on the way.
+    struct Row
+    {
+      std::vector<int> distances;
+      std::vector<unsigned short> firstChokepoint;
+      std::vector<unsigned short> lastChokepoint;
+    };
+
+    // Gets the index of the region in the graph, or -1 if it has none.
+    int nodeAt(Position position) const;
+
+    // Gets the paths from a node, computing them if they aren't kept. The row stays valid
+    // until the next call, and the caller must hold rowMutex.
+    const Row& getRow(int from) const;
+
+    const GameData *data = nullptr;
+
+    std::vector<Chokepoint> chokepoints;
+
+    // The nodes of the graph are the accessible regions, numbered densely in ID order.
+    std::vector<int> nodeOfRegion;
+    std::vector<int> regionOfNode;
+    int nodeCount = 0;
+    std::vector<std::vector<Edge>> edges;
+
+    // The rows that have been computed, with the index in 'rows' of each node's row or -1.
+    // Once maxRows are in use, all of them are dropped and their memory reused.
+    mutable std::mutex rowMutex;
+    mutable std::vector<Row> rows;
+    mutable std::vector<int> rowOfNode;
+    mutable int rowCount = 0;
+    int maxRows = 0;
+  };
+}
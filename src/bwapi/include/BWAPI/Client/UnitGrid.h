@@ -0,0 +1,172 @@
+#pragma once
+#include <BWAPI.h>
+
+#include <vector>
+
+namespace BWAPI
+{
+  // A uniform grid over the map in which every accessible unit is bucketed by its
+  // bounding box. GameImpl rebuilds it once per frame in onMatchFrame, after which the
+  // rectangle, radius, closest and best unit queries of Game are answered from it without
+  // touching the heap. Units that overlap several cells are stored in each of them, and
+  // rectangle queries report such a unit only from the cell holding the top left corner
+  // of its overlap with the query, so results never contain duplicates.
+  class UnitGrid
+  {
+  public:
+    // The side length of a cell in pixels, i.e. four build tiles.
+    static const int CELL_SIZE = 128;
+
+    // How much further than the query radius the cells searched around a point reach. The
+    // approximate distance never comes out below the larger axis distance, but the slack
+    // keeps the searches safe from being off by a pixel or two at a cell edge.
+    static const int DISTANCE_SLACK = 4;
+
+    struct Entry
+    {
+      int left;
+      int top;
+      int right;
+      int bottom;
+      Unit unit;
+    };
+
+    struct Neighbor
+    {
+      Unit unit;
+      int distance;
+    };
+
+    // Rebuilds the grid from every unit in 'units' that exists and is on the map. The map
+    // size is given in build tiles.
+    void rebuild(const Unitset& units, int mapWidth, int mapHeight);
+    void clear();
+
+    // Calls callback(Unit) for every unit whose bounding box intersects the given
+    // rectangle, including its edges.
+    template <typename _T>
+    void forEachInRectangle(int left, int top, int right, int bottom, const _T &callback) const;
+
+    // Calls callback(Unit, distance) for every unit within 'radius' of 'center', measured
+    // the same way as UnitInterface::getDistance(Position).
+    template <typename _T>
+    void forEachInRadius(Position center, int radius, const _T &callback) const;
+
+    // Finds up to 'count' units closest to 'center' that match 'pred' and are within
+    // 'radius', writing them to 'results' sorted by increasing distance. Returns the
+    // number of units written.
+    int findNearest(Position center, Neighbor* results, int count, const UnitFilter &pred = nullptr, int radius = 999999) const;
+
+    // The distance between a point and a unit's bounding box, as computed by
+    // UnitInterface::getDistance(Position).
+    static int getDistance(const Entry &entry, Position pos);
+
+  private:
+    int cellX(int x) const;
+    int cellY(int y) const;
+
+    int cellsX = 0;
+    int cellsY = 0;
+
+    // Cell 'c' owns entries [cellStart[c], cellStart[c + 1]). Cells are stored row by row.
+    std::vector<int>   cellStart;
+    std::vector<Entry> entries;
+
+    // The bounding box of each unit being inserted, kept between frames to avoid
+    // reallocating it.
+    std::vector<Entry> pending;
+  };
+
+  inline int UnitGrid::cellX(int x) const
+  {
+    return x < 0 ? 0 : std::min(x / CELL_SIZE, cellsX - 1);
+  }
+  inline int UnitGrid::cellY(int y) const
+  {
+    return y < 0 ? 0 : std::min(y / CELL_SIZE, cellsY - 1);
+  }
+  inline int UnitGrid::getDistance(const Entry &entry, Position pos)
+  {
+    int xDist = entry.left - pos.x;
+    if ( xDist < 0 )
+    {
+      xDist = pos.x - (entry.right + 1);
+      if ( xDist < 0 )
+        xDist = 0;
+    }
+
+    int yDist = entry.top - pos.y;
+    if ( yDist < 0 )
+    {
+      yDist = pos.y - (entry.bottom + 1);
+      if ( yDist < 0 )
+        yDist = 0;
+    }
+
+    return Positions::Origin.getApproxDistance(Position(xDist, yDist));
+  }
+  template <typename _T>
+  void UnitGrid::forEachInRectangle(int left, int top, int right, int bottom, const _T &callback) const
+  {
+    if ( entries.empty() || left > right || top > bottom )
+      return;
+
+    int firstX = cellX(left), lastX = cellX(right);
+    int firstY = cellY(top),  lastY = cellY(bottom);
+
+    for ( int cy = firstY; cy <= lastY; ++cy )
+    {
+      for ( int cx = firstX; cx <= lastX; ++cx )
+      {
+        int cell = cy * cellsX + cx;
+        for ( int i = cellStart[cell]; i < cellStart[cell + 1]; ++i )
+        {
+          const Entry &e = entries[i];
+          if ( e.left > right || e.right < left || e.top > bottom || e.bottom < top )
+            continue;
+
+          // Only report the unit from the cell that holds the top left corner of the
+          // intersection, which is visited exactly once.
+          if ( cellX(std::max(left, e.left)) != cx || cellY(std::max(top, e.top)) != cy )
+            continue;
+
+          callback(e.unit);
+        }
+      }
+    }
+  }
+  template <typename _T>
+  void UnitGrid::forEachInRadius(Position center, int radius, const _T &callback) const
+  {
+    if ( entries.empty() || radius < 0 )
+      return;
+
+    // Distances are measured to right+1/bottom+1, so a unit ending one pixel left of or
+    // above the box can still be in range, and the cells reach a little further still.
+    int reach = radius + DISTANCE_SLACK;
+    int reachX = center.x - reach - 1, reachY = center.y - reach - 1;
+    int firstX = cellX(reachX), lastX = cellX(center.x + reach);
+    int firstY = cellY(reachY), lastY = cellY(center.y + reach);
+
+    for ( int cy = firstY; cy <= lastY; ++cy )
+    {
+      for ( int cx = firstX; cx <= lastX; ++cx )
+      {
+        int cell = cy * cellsX + cx;
+        for ( int i = cellStart[cell]; i < cellStart[cell + 1]; ++i )
+        {
+          const Entry &e = entries[i];
+          int distance = getDistance(e, center);
+          if ( distance > radius )
+            continue;
+
+          // Same deduplication rule as forEachInRectangle(), using the query's bounding box.
+          if ( cellX(std::max(reachX, e.left)) != cx || cellY(std::max(reachY, e.top)) != cy )
+            continue;
+
+          callback(e.unit, distance);
+        }
+      }
+    }
+  }
+}
@@ -2,6 +2,8 @@
 #include <BWAPI.h>
 #include "UnitData.h"
 #include <string>
+#include <array>
+#include <span>
 
 namespace BWAPI
 {
@@ -22,9 +24,19 @@ namespace BWAPI
       UnitData* self;
       Unitset   connectedUnits;
       Unitset   loadedUnits;
+      mutable std::array< UnitType, 5 > trainingQueue;
       void      clear();
       void      saveInitialState();
 
+      // Views of the unit's collections that don't copy them, unlike getTrainingQueue(),
+      // getLoadedUnits(), getInterceptors() and getLarva(). They stay valid until the next
+      // frame, when GameImpl refreshes them. The training queue view is refilled from the
+      // unit's data on every call, since commands issued this frame change the queue.
+      std::span< const UnitType > getTrainingQueueView() const;
+      const Unitset& getLoadedUnitsView() const;
+      const Unitset& getInterceptorsView() const;
+      const Unitset& getLarvaView() const;
+
       UnitImpl(int _id);
 
       virtual int           getID() const override;
@@ -6,17 +6,21 @@
 
 #include <functional>
 #include <limits>
+#include <type_traits>
 
 #include "UnaryFilter.h"
 
-#define BWAPI_COMPARE_FILTER_OP(op) UnaryFilter<PType> operator op(const RType &cmp) const               \
-                                    {   return [=](PType v)->bool{ return (*this)(v) op cmp; };   }
+#define BWAPI_COMPARE_FILTER_OP(op) auto operator op(const RType &cmp) const                               \
+                                    {   auto expr = [lhs = pred, cmp](PType v)->bool{ return lhs(v) op cmp; };  \
+                                        return UnaryFilter<PType,decltype(expr)>(expr);   }
 
 #define BWAPI_ARITHMATIC_FILTER_OP(op) template <typename T>                                            \
-                                       CompareFilter<PType,RType,std::function<RType(PType)> > operator op(const T &other) const     \
-                                       {   return [=](PType v)->int{ return (*this)(v) op other(v); };   }    \
-                                       CompareFilter<PType,RType,std::function<RType(PType)> > operator op(RType other) const     \
-                                       {   return [=](PType v)->int{ return (*this)(v) op other; };   }
+                                       auto operator op(const T &other) const     \
+                                       {   auto expr = [lhs = pred, other](PType v)->int{ return lhs(v) op other(v); };    \
+                                           return CompareFilter<PType,RType,decltype(expr)>(expr);   }    \
+                                       auto operator op(RType other) const     \
+                                       {   auto expr = [lhs = pred, other](PType v)->int{ return lhs(v) op other; };    \
+                                           return CompareFilter<PType,RType,decltype(expr)>(expr);   }
 
 namespace BWAPI
 {
@@ -31,6 +35,7 @@ namespace BWAPI
   ///   The functor's return type. It is int by default.
   /// @tparam Container (optional)
   ///   Storage container for the function predicate. It is std::function<RType(PType)> by default.
+  ///   Filters built with the operators use the closure type of the composed expression instead.
   template < typename PType, typename RType=int, class Container = std::function<RType(PType)> >
   class CompareFilter
   {
@@ -61,20 +66,22 @@ namespace BWAPI
 
     // Division
     template <typename T>
-    CompareFilter<PType,RType,std::function<RType(PType)> > operator /(const T &other) const
+    auto operator /(const T &other) const
     {   
-      return [=](PType v)->int{ int rval = other(v);
-                                 return rval == 0 ? std::numeric_limits<int>::max() : (*this)(v) / rval;
-                               };
+      auto expr = [lhs = pred, other](PType v)->int{ int rval = other(v);
+                                                      return rval == 0 ? std::numeric_limits<int>::max() : lhs(v) / rval;
+                                                    };
+      return CompareFilter<PType,RType,decltype(expr)>(expr);
     };
 
     // Modulus
     template <typename T>
-    CompareFilter<PType,RType,std::function<RType(PType)> > operator %(const T &other) const
+    auto operator %(const T &other) const
     {   
-      return [=](PType v)->int{ int rval = other(v);
-                                 return rval == 0 ? 0 : (*this)(v) % rval;
-                               };
+      auto expr = [lhs = pred, other](PType v)->int{ int rval = other(v);
+                                                      return rval == 0 ? 0 : lhs(v) % rval;
+                                                    };
+      return CompareFilter<PType,RType,decltype(expr)>(expr);
     };
 
     // call
@@ -85,7 +92,10 @@ namespace BWAPI
     
     inline bool isValid() const
     {
-      return (bool)pred;
+      if constexpr ( std::is_constructible_v<bool, const Container&> )
+        return (bool)pred;
+      else
+        return true;
     };
   };
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <BWAPI/Type.h>
+#include <BWAPI/UnitSizeType.h>
 
 namespace BWAPI
 {
@@ -66,5 +67,10 @@ namespace BWAPI
     constexpr DamageType Unknown{Enum::Unknown};
   }
 
+  /// <summary>The fraction of damage, in 256ths, that each DamageType deals to each
+  /// UnitSizeType.</summary> This is the table that Game::getDamageFrom uses, indexed by the
+  /// damage type and then the size of the unit taking the damage.
+  extern const int damageRatio[DamageTypes::Enum::MAX][UnitSizeTypes::Enum::MAX];
+
   static_assert(sizeof(DamageType) == sizeof(int), "Expected type to resolve to primitive size.");
 }
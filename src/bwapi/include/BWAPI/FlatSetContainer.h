@@ -0,0 +1,408 @@
+#pragma once
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace BWAPI
+{
+  /// <summary>A set container for objects that are identified by a small integer key, such
+  /// as units by their ID. It can be used in place of SetContainer where the node allocations
+  /// and pointer chasing of std::unordered_set are too costly.</summary>
+  ///
+  /// Membership is kept in a dense bitset indexed by key, so insert, erase, and contains are
+  /// constant time, and the members themselves are kept in a compact list that is iterated
+  /// linearly. Erasing an element only clears its bit, leaving a stale entry in the list that
+  /// iteration skips; stale entries are reused if the same key is inserted again and are
+  /// compacted away by later insertions once they outnumber the members. Like
+  /// std::unordered_set, erasing never invalidates iterators to other elements, while
+  /// inserting may invalidate all of them. Copies only contain the members, and assigning
+  /// to an existing set reuses its storage.
+  ///
+  /// Finding the place of an element in the list, as find() and inserting an existing or
+  /// stale key do, is a scan of the list. A set with more than SCAN_LIMIT entries builds an
+  /// index of positions by key the first time an insertion needs one, which takes another
+  /// 2 * (MaxKeys + 1) bytes on the heap, and keeps it up to date as entries are added.
+  /// Anything that rearranges the list, such as compacting it or copying the set, drops the
+  /// index until an insertion needs it again, so copies never build one. find() uses the
+  /// index when there is one and scans otherwise. Const member functions never modify the
+  /// set, so any number of threads can look up elements in a set at once as long as none of
+  /// them changes it.
+  ///
+  /// The two bitsets take 2 * (MaxKeys + 1) bits inside every set, which is about 2.5 KB for
+  /// units.
+  ///
+  /// Since elements are identified by their key, two different objects with the same key
+  /// would be treated as the same element, so they must not be put in the same set, which
+  /// insertion asserts. Lookups can't tell them apart either: contains() is true for any
+  /// object with the key of a member.
+  ///
+  /// @tparam T
+  ///     Type that this set contains.
+  /// @tparam KeyT
+  ///     Function object mapping an element to its key in the range [0, MaxKeys), or to -1
+  ///     for a null element.
+  /// @tparam MaxKeys
+  ///     The number of distinct keys.
+  template <class T, class KeyT, int MaxKeys>
+  class FlatSetContainer
+  {
+    static_assert(MaxKeys < 65535, "positions are stored in 16 bits");
+
+    struct Entry
+    {
+      T value;
+      int key;
+    };
+
+  public:
+    using key_type = T;
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using const_reference = const T&;
+
+    /// <summary>A forward iterator over the members of the set, skipping stale entries. As
+    /// with std::unordered_set, elements can't be modified through an iterator.</summary>
+    class const_iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      const_iterator() = default;
+
+      reference operator*() const { return set->entries[index].value; }
+      pointer operator->() const { return &set->entries[index].value; }
+
+      const_iterator& operator++()
+      {
+        ++index;
+        skipStale();
+        return *this;
+      }
+      const_iterator operator++(int)
+      {
+        const_iterator copy = *this;
+        ++*this;
+        return copy;
+      }
+
+      bool operator==(const const_iterator &other) const { return index == other.index; }
+      bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+      friend class FlatSetContainer;
+
+      const_iterator(const FlatSetContainer *set, size_type index) : set(set), index(index)
+      {
+        skipStale();
+      }
+      void skipStale()
+      {
+        while (index < set->entries.size() && !set->present[set->slot(set->entries[index].key)])
+          ++index;
+      }
+
+      const FlatSetContainer *set = nullptr;
+      size_type index = 0;
+    };
+    using iterator = const_iterator;
+
+    FlatSetContainer() = default;
+    FlatSetContainer(std::initializer_list<T> list)
+    {
+      insert(list);
+    }
+    template <class InputIt>
+    FlatSetContainer(InputIt first, InputIt last)
+    {
+      insert(first, last);
+    }
+    FlatSetContainer(const FlatSetContainer &other)
+    {
+      *this = other;
+    }
+    FlatSetContainer(FlatSetContainer &&other) noexcept
+      : entries(std::move(other.entries))
+      , present(other.present)
+      , listed(other.listed)
+      , count_(other.count_)
+      , positions(std::move(other.positions))
+      , positionsValid(other.positionsValid)
+    {
+      other.entries.clear();
+      other.positionsValid = false;
+      other.present.reset();
+      other.listed.reset();
+      other.count_ = 0;
+    }
+
+    FlatSetContainer& operator=(const FlatSetContainer &other)
+    {
+      if (this == &other)
+        return *this;
+
+      // Copy only the members, so the copy starts out without stale entries.
+      clear();
+      entries.reserve(other.count_);
+      for (const Entry &e : other.entries)
+      {
+        if (other.present[slot(e.key)])
+          entries.push_back(e);
+      }
+      present = other.present;
+      listed = other.present;
+      count_ = other.count_;
+      return *this;
+    }
+    FlatSetContainer& operator=(FlatSetContainer &&other) noexcept
+    {
+      if (this != &other)
+      {
+        entries.swap(other.entries);
+        positions.swap(other.positions);
+        std::swap(positionsValid, other.positionsValid);
+        present = other.present;
+        listed = other.listed;
+        count_ = other.count_;
+        other.clear();
+      }
+      return *this;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, entries.size()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    size_type size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    void clear()
+    {
+      for (const Entry &e : entries)
+      {
+        present.reset(slot(e.key));
+        listed.reset(slot(e.key));
+      }
+      entries.clear();
+      count_ = 0;
+      positionsValid = false;
+    }
+
+    void reserve(size_type count)
+    {
+      entries.reserve(count);
+    }
+
+    std::pair<iterator, bool> insert(const T &value)
+    {
+      int key = KeyT()(value);
+      size_type s = slot(key);
+      if (present[s])
+      {
+        size_type index = locateIndexed(key);
+        assert(entries[index].value == value && "a different element with the same key is already in the set");
+        return { const_iterator(this, index), false };
+      }
+
+      present.set(s);
+      ++count_;
+
+      // A stale entry for the key comes back to life in its old place.
+      if (listed[s])
+      {
+        size_type index = locateIndexed(key);
+        entries[index].value = value;
+        return { const_iterator(this, index), true };
+      }
+
+      compactIfStale();
+      listed.set(s);
+      if (positionsValid)
+        positions[s] = static_cast<unsigned short>(entries.size());
+      entries.push_back({ value, key });
+      return { const_iterator(this, entries.size() - 1), true };
+    }
+    iterator insert(const_iterator, const T &value)
+    {
+      return insert(value).first;
+    }
+    template <class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+      for (; first != last; ++first)
+        insert(*first);
+    }
+    void insert(std::initializer_list<T> list)
+    {
+      insert(list.begin(), list.end());
+    }
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+      return insert(T(std::forward<Args>(args)...));
+    }
+
+    size_type erase(const T &value)
+    {
+      size_type s = slot(KeyT()(value));
+      if (!present[s])
+        return 0;
+
+      present.reset(s);
+      --count_;
+      return 1;
+    }
+    iterator erase(const_iterator pos)
+    {
+      erase(*pos);
+      return const_iterator(this, pos.index + 1);
+    }
+
+    /// <summary>Finds the element with the same key as a value.</summary>
+    const_iterator find(const T &value) const
+    {
+      int key = KeyT()(value);
+      if (!present[slot(key)])
+        return end();
+      return const_iterator(this, locate(key));
+    }
+
+    size_type count(const T &value) const
+    {
+      return contains(value) ? 1 : 0;
+    }
+
+    /// <summary>Checks if this set contains a specific value.</summary>
+    ///
+    /// <param name="value">
+    ///     Value to search for.
+    /// </param>
+    bool contains(const T &value) const
+    {
+      return present[slot(KeyT()(value))];
+    }
+
+    /// <summary>Iterates the set and erases each element x where pred(x) returns true.</summary>
+    ///
+    /// <param name="pred">
+    ///     Predicate for removing elements.
+    /// </param>
+    /// @see std::erase_if
+    template <class Pred>
+    void erase_if(const Pred &pred)
+    {
+      // Drop stale entries while we're going through the list anyway.
+      size_type out = 0;
+      for (size_type i = 0; i < entries.size(); ++i)
+      {
+        size_type s = slot(entries[i].key);
+        if (present[s] && !pred(entries[i].value))
+        {
+          entries[out++] = entries[i];
+          continue;
+        }
+        if (present[s])
+          --count_;
+        present.reset(s);
+        listed.reset(s);
+      }
+      entries.resize(out);
+      positionsValid = false;
+    }
+
+    void swap(FlatSetContainer &other)
+    {
+      std::swap(*this, other);
+    }
+
+    bool operator==(const FlatSetContainer &other) const
+    {
+      return count_ == other.count_ && present == other.present;
+    }
+    bool operator!=(const FlatSetContainer &other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    // The null element is kept in the extra slot at the end of the bitsets.
+    static size_type slot(int key)
+    {
+      return key < 0 ? MaxKeys : static_cast<size_type>(key);
+    }
+
+    // Sets with at most this many entries are always scanned rather than indexed.
+    static const size_type SCAN_LIMIT = 32;
+
+    // Gets the position in the list of the entry for a listed key, using the index if
+    // there is one.
+    size_type locate(int key) const
+    {
+      if (positionsValid)
+        return positions[slot(key)];
+
+      size_type i = 0;
+      while (entries[i].key != key)
+        ++i;
+      return i;
+    }
+
+    // Like locate(), but builds the index first if the list is too long to scan. The
+    // memory of the index is kept when it is dropped, so it's only allocated once.
+    size_type locateIndexed(int key)
+    {
+      if (!positionsValid && entries.size() > SCAN_LIMIT)
+      {
+        positions.resize(MaxKeys + 1);
+        for (size_type i = 0; i < entries.size(); ++i)
+          positions[slot(entries[i].key)] = static_cast<unsigned short>(i);
+        positionsValid = true;
+      }
+      return locate(key);
+    }
+
+    // Removes stale entries once they outnumber the members. Only done on insertion, which
+    // may invalidate iterators anyway.
+    void compactIfStale()
+    {
+      if (entries.size() - count_ <= count_ || entries.size() < 16)
+        return;
+
+      size_type out = 0;
+      for (size_type i = 0; i < entries.size(); ++i)
+      {
+        size_type s = slot(entries[i].key);
+        if (present[s])
+          entries[out++] = entries[i];
+        else
+          listed.reset(s);
+      }
+      entries.resize(out);
+      positionsValid = false;
+    }
+
+    std::vector<Entry> entries;
+
+    // 'present' holds the keys of the members, while 'listed' holds the keys that have an
+    // entry in the list, including stale ones.
+    std::bitset<MaxKeys + 1> present;
+    std::bitset<MaxKeys + 1> listed;
+
+    size_type count_ = 0;
+
+    // The position of each listed key's entry, which is built by locateIndexed() and only
+    // meaningful while positionsValid is set.
+    std::vector<unsigned short> positions;
+    bool positionsValid = false;
+  };
+}
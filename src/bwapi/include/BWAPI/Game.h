@@ -25,6 +25,7 @@ namespace BWAPI
   typedef ForceInterface *Force;
   class Forceset;
   class GameType;
+  class PlacementCache;
   class PlayerInterface;
   typedef PlayerInterface *Player;
   class Playerset;
@@ -51,6 +52,11 @@ namespace BWAPI
 
     Game& operator=(const Game& other) = delete;
     Game& operator=(Game&& other) = delete;
+
+    /// <summary>Retrieves the map data that getBuildLocation keeps between calls.</summary>
+    /// The implementation owns it so that it can be cleared between matches and invalidated
+    /// when buildings change.
+    virtual PlacementCache &getPlacementCache() const = 0;
   public :
     /// <summary>Retrieves the set of all teams/forces.</summary> Forces are commonly seen in @UMS
     /// game types and some others such as @TvB and the team versions of game types.
@@ -1458,6 +1464,26 @@ namespace BWAPI
     /// @see UnitInterface::hasPath
     bool hasPath(Position source, Position destination) const;
 
+    /// <summary>Retrieves the approximate distance a ground unit has to travel to get from
+    /// source to destination.</summary> The distance follows the shortest path between the
+    /// regions of the two positions through the borders between regions, which is computed
+    /// when the match starts. Like hasPath, this does not account for units or buildings
+    /// blocking the way.
+    ///
+    /// <param name="source">
+    ///   The source position.
+    /// </param>
+    /// <param name="destination">
+    ///   The destination position.
+    /// </param>
+    ///
+    /// @returns The ground distance in pixels, or -1 if there is no path between the two
+    /// positions. Unlike most functions, this does not change
+    /// BWAPI::Broodwar->getLastError(), so that it can be used by other functions without
+    /// overwriting their error.
+    /// @see hasPath
+    virtual int getGroundDistance(Position source, Position destination) const = 0;
+
     /// <summary>Sets the alliance state of the current player with the target player.</summary>
     ///
     /// <param name="player">
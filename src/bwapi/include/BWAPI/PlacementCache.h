@@ -0,0 +1,115 @@
+#pragma once
+#include <BWAPI/Position.h>
+#include <BWAPI/UnitType.h>
+
+#include <vector>
+
+namespace BWAPI
+{
+  class Game;
+
+  // Map data used by Game::getBuildLocation that only changes when buildings do, kept by
+  // GameImpl between calls. The terrain part (buildability, ground height and region group
+  // of each tile) is read once per match, and the tiles covered by buildings and resources
+  // are rescanned at most once per frame, when a build location is asked for. Summed-area
+  // tables over the unbuildable and the blocked tiles then tell in constant time whether a
+  // building footprint is on buildable terrain and whether it is clear, so that the full
+  // canBuildHere check is only needed for the few candidates that decide the result.
+  //
+  // The cache also remembers recent answers of getBuildLocation. They are dropped whenever
+  // the blocked tiles change, and whenever GameImpl calls invalidate() for a building that
+  // was created, destroyed, morphed or completed, since buildings give power and start
+  // creep. Remembered answers are checked in full before they are reused, so a reused answer
+  // is always buildable, but a closer location that opens up without a building changing,
+  // such as one a unit walked off or that creep spread to, is only found after the next
+  // building change.
+  class PlacementCache
+  {
+  public:
+    // Forgets everything, so that the next refresh reads the terrain of the new match.
+    void clear();
+
+    // Drops the remembered answers, for changes that the footprints don't show.
+    void invalidate();
+
+    // Brings the blocked tiles up to date with the game, at most once per frame.
+    void refresh(const Game &game);
+
+    // Checks that a footprint is on the map and on buildable terrain, which canBuildHere
+    // requires.
+    bool isBuildable(TilePosition lt, TilePosition size) const;
+    // Checks that a footprint is also not covered by a building or resource. canBuildHere
+    // tests unit bounds rather than tiles, so this is only a good guess.
+    bool isFree(TilePosition lt, TilePosition size) const;
+
+    int getGroundHeight(TilePosition p) const;
+    // The region group at the top left corner of a tile, or -1 if there is none.
+    int getRegionGroup(TilePosition p) const;
+
+    // The remembered answer to a query, or TilePositions::None if there is none. The answer
+    // is forgotten if it fails the given check, which should be the full canBuildHere check.
+    template < typename F >
+    TilePosition findLocation(UnitType type, TilePosition desiredPosition, int maxRange, bool creep, const F &isStillValid)
+    {
+      for ( auto it = locations.begin(); it != locations.end(); ++it )
+      {
+        if ( it->type != type || it->desiredPosition != desiredPosition || it->maxRange != maxRange || it->creep != creep )
+          continue;
+        if ( isStillValid(it->location) )
+          return it->location;
+        locations.erase(it);
+        break;
+      }
+      return TilePositions::None;
+    }
+    void addLocation(UnitType type, TilePosition desiredPosition, int maxRange, bool creep, TilePosition location);
+
+  private:
+    static const size_t MAX_LOCATIONS = 32;
+
+    struct Footprint
+    {
+      int id, x, y, w, h;
+      bool operator ==(const Footprint &other) const
+      {
+        return id == other.id && x == other.x && y == other.y && w == other.w && h == other.h;
+      }
+    };
+
+    struct Location
+    {
+      UnitType type;
+      TilePosition desiredPosition;
+      int maxRange;
+      bool creep;
+      TilePosition location;
+    };
+
+    bool isOnMap(TilePosition p) const
+    {
+      return p.x >= 0 && p.y >= 0 && p.x < width && p.y < height;
+    }
+    // The number of tiles counted in a summed-area table inside a footprint, or -1 if the
+    // footprint is not on the map
+    int countInside(const std::vector<int> &table, TilePosition lt, TilePosition size) const;
+    void buildTable(const std::vector<char> &counted, std::vector<int> &table) const;
+
+    void readTerrain(const Game &game);
+    void rebuildBlocked();
+
+    bool initialized = false;
+    int lastFrame = -1;
+
+    int width = 0, height = 0;
+    std::vector<char> buildable;
+    std::vector<int> heights;
+    std::vector<int> groups;
+
+    std::vector<int> unbuildableSums;
+
+    std::vector<Footprint> footprints, current;
+    std::vector<int> blockedSums;
+
+    std::vector<Location> locations;
+  };
+}
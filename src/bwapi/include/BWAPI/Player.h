@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 #include <BWAPI/Position.h>
 #include <BWAPI/Race.h>
@@ -549,6 +550,15 @@ namespace BWAPI
     /// @returns The amount of damage that the weapon deals with this player's upgrades.
     int damage(WeaponType wpn) const;
 
+    /// <summary>Builds tables of the values returned by maxEnergy, topSpeed, weaponMaxRange,
+    /// sightRange, weaponDamageCooldown, armor and damage for every unit and weapon type, which
+    /// those functions read from afterwards instead of checking upgrades on every call.</summary>
+    /// The tables are only rebuilt when the player's upgrade levels have changed since the last
+    /// call, so this is cheap to call every frame. The client calls it whenever a frame starts.
+    ///
+    /// @returns true if the tables were rebuilt, and false if they were already up to date.
+    bool updateStats();
+
     /// <summary>Retrieves the total unit score, as seen in the end-game score screen.</summary>
     ///
     /// @returns The player's unit score.
@@ -644,5 +654,38 @@ namespace BWAPI
     ///
     /// @since 4.1.2
     bool hasUnitTypeRequirement(UnitType unit, int amount = 1) const;
+
+  private :
+    struct UnitStats
+    {
+      int maxEnergy;
+      double topSpeed;
+      int sightRange;
+      int weaponDamageCooldown;
+      int armor;
+    };
+    struct WeaponStats
+    {
+      int damage;
+      int maxRange;
+    };
+
+    // The tables built by updateStats(), indexed by type, and the upgrade levels they were
+    // built with. They are empty until updateStats() is first called.
+    std::vector<UnitStats> unitStats;
+    std::vector<WeaponStats> weaponStats;
+    std::vector<int> statUpgradeLevels;
+
+    // The stats computed from the upgrade levels, which fill the tables.
+    int computeMaxEnergy(UnitType unit) const;
+    double computeTopSpeed(UnitType unit) const;
+    int computeWeaponMaxRange(WeaponType weapon) const;
+    int computeSightRange(UnitType unit) const;
+    int computeWeaponDamageCooldown(UnitType unit) const;
+    int computeArmor(UnitType unit) const;
+    int computeDamage(WeaponType wpn) const;
+
+    bool hasUnitStats(UnitType unit) const;
+    bool hasWeaponStats(WeaponType weapon) const;
   };
 };
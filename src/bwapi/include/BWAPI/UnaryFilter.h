@@ -1,5 +1,6 @@
 #pragma once
 #include <functional>
+#include <type_traits>
 
 namespace BWAPI
 {
@@ -19,11 +20,33 @@ namespace BWAPI
   ///   The type being passed into the predicate, which will be of type bool(PType).
   /// @tparam Container (optional)
   ///   Storage container for the function predicate. It is std::function<bool(PType)> by default.
+  ///   Filters built with the logical operators use the closure type of the composed
+  ///   expression instead, so they don't allocate.
   template <class PType, class Container = std::function<bool(PType)> >
   class UnaryFilter
   {
   private:
     Container pred;
+
+    // An empty predicate is no filter at all, which is what UnitManager takes it to mean,
+    // so it accepts everything, and so does its negation. Operands can be empty
+    // std::functions and function pointers as well as filters holding them, such as
+    // UnitFilter(nullptr), so composing with one doesn't throw std::bad_function_call.
+    template <typename T>
+    static inline bool isEmpty(const T &predicate)
+    {
+      if constexpr ( requires { predicate.isValid(); } )
+        return !predicate.isValid();
+      else if constexpr ( std::is_constructible_v<bool, const T&> )
+        return !(bool)predicate;
+      else
+        return false;
+    };
+    template <typename T>
+    static inline bool test(const T &predicate, PType v)
+    {
+      return isEmpty(predicate) || predicate(v);
+    };
   public:
     // ctor
     template < typename T >
@@ -32,23 +55,35 @@ namespace BWAPI
     // Default copy/move ctor/assign and dtor
     
     // logical operators
+    // These compose at compile time: the result stores copies of both operands in a
+    // closure whose type is the Container of the returned filter, so no std::function is
+    // created and the whole expression can be inlined. The result converts to a
+    // std::function based filter (such as UnitFilter) wherever one is expected.
     template <typename T>
-    inline UnaryFilter<PType,std::function<bool(PType)> > operator &&(const T& other) const
+    inline auto operator &&(const T& other) const
     {
-      return [=](PType v){ return (*this)(v) && other(v); };
+      auto expr = [lhs = pred, rhs = other](PType v){ return test(lhs, v) && test(rhs, v); };
+      return UnaryFilter<PType,decltype(expr)>(expr);
     };
 
     template <typename T>
-    inline UnaryFilter<PType,std::function<bool(PType)> > operator ||(const T& other) const
+    inline auto operator ||(const T& other) const
     {
-      return [=](PType v){ return (*this)(v) || other(v); };
+      auto expr = [lhs = pred, rhs = other](PType v){ return test(lhs, v) || test(rhs, v); };
+      return UnaryFilter<PType,decltype(expr)>(expr);
     };
 
-    inline UnaryFilter<PType,std::function<bool(PType)> > operator !() const
+    // The negation of an empty filter is empty itself, so it stays empty however many
+    // times it is negated.
+    inline auto operator !() const
     {
-      if ( !this->pred )
-        return nullptr;
-      return [=](PType v){ return !(*this)(v); };
+      struct Negation
+      {
+        Container inner;
+        bool isValid() const { return !isEmpty(inner); }
+        bool operator()(PType v) const { return !isValid() || !inner(v); }
+      };
+      return UnaryFilter<PType,Negation>(Negation{ pred });
     };
 
     // call
@@ -58,9 +93,11 @@ namespace BWAPI
     };
 
     // operator bool
+    // Only containers that can be empty (std::function and function pointers) and
+    // negations of empty filters are invalid; other composed expressions are always valid.
     inline bool isValid() const
     {
-      return (bool)pred;
+      return !isEmpty(pred);
     };
 
   };
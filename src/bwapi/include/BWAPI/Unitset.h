@@ -1,5 +1,6 @@
 #pragma once
 #include "SetContainer.h"
+#include "FlatSetContainer.h"
 #include <BWAPI/Position.h>
 #include <BWAPI/Filters.h>
 #include <iterator>
@@ -12,20 +13,50 @@ namespace BWAPI
   class UnitCommand;
   class TechType;
 
+  /// <summary>Maps a unit to its ID for use as a FlatSetContainer key.</summary>
+  struct UnitsetKey
+  {
+    template <class U>
+    int operator()(U *unit) const
+    {
+      return unit ? unit->getID() : -1;
+    }
+  };
+
+  /// <summary>The container that Unitset is built on.</summary> By default this is a hash set
+  /// of unit pointers. Defining BWAPI_FLAT_UNITSET replaces it with a FlatSetContainer keyed
+  /// by unit ID, which avoids allocating a node per unit and iterates a contiguous list. Since
+  /// a wrapper around a unit that reports the same ID, like the bot's shadow units, has the
+  /// same key as the unit it wraps, the two must not be mixed in one set.
+#ifdef BWAPI_FLAT_UNITSET
+  using UnitsetContainer = FlatSetContainer<BWAPI::Unit, UnitsetKey, 10000>;
+#else
+  using UnitsetContainer = SetContainer<BWAPI::Unit, std::hash<void*>>;
+#endif
+
   /// <summary>The Unitset is a container for a set of pointers to Unit objects. It is typically
   /// used for groups of units instead of having to manage each Unit individually.</summary>
   ///
   /// @see Unit
-  class Unitset : public SetContainer<BWAPI::Unit, std::hash<void*>>
+  class Unitset : public UnitsetContainer
   {
   public:
+    Unitset() = default;
+    Unitset(const Unitset& other) = default;
+    Unitset(Unitset&& other) = default;
+    Unitset& operator = (Unitset&& other) = default;
+
     /// <summary>A blank Unitset containing no elements.</summary> This is typically used as a
     /// return value for BWAPI interface functions that have encountered an error.
     static const Unitset none;
 
     Unitset& operator = (const Unitset& other) {
+#ifdef BWAPI_FLAT_UNITSET
+        UnitsetContainer::operator=(other);
+#else
         clear();
         std::copy(other.begin(), other.end(), std::inserter(*this, begin()));
+#endif
         return *this;
     }
 
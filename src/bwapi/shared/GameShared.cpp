@@ -62,6 +62,11 @@ namespace BWAPI
   //------------------------------------------------ GET EVENTS ----------------------------------------------
   const std::list< Event >& GameImpl::getEvents() const
   {
+    if ( !isEventListValid )
+    {
+      events.assign(eventBuffer.begin(), eventBuffer.end());
+      isEventListValid = true;
+    }
     return events;
   }
   //----------------------------------------------- GET LAST ERROR -------------------------------------------
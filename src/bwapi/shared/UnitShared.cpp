@@ -18,6 +18,8 @@ namespace BWAPI
     this->interfaceEvents.clear();
 
     connectedUnits.clear();
+    loadedUnits.clear();
+    trainingQueue.fill(UnitTypes::None);
   }
   //------------------------------------- INITIAL INFORMATION FUNCTIONS --------------------------------------
   void UnitImpl::saveInitialState()
@@ -239,6 +241,14 @@ namespace BWAPI
   {
     return UnitType::list(std::begin(self->trainingQueue), std::begin(self->trainingQueue) + self->trainingQueueCount);
   }
+  std::span< const UnitType > UnitImpl::getTrainingQueueView() const
+  {
+    // Read the count and the types together so the view can't mix two states of the queue
+    size_t count = std::min< size_t >(std::max(self->trainingQueueCount, 0), trainingQueue.size());
+    for ( size_t i = 0; i < count; ++i )
+      trainingQueue[i] = UnitType(self->trainingQueue[i]);
+    return std::span< const UnitType >(trainingQueue.data(), count);
+  }
   //--------------------------------------------- GET TECH ---------------------------------------------------
   TechType UnitImpl::getTech() const
   {
@@ -339,6 +349,10 @@ namespace BWAPI
   {
     return loadedUnits;
   }
+  const Unitset& UnitImpl::getLoadedUnitsView() const
+  {
+    return loadedUnits;
+  }
   //--------------------------------------------- GET CARRIER ------------------------------------------------
   Unit UnitImpl::getCarrier() const
   {
@@ -346,9 +360,13 @@ namespace BWAPI
   }
   //--------------------------------------------- GET INTERCEPTORS -------------------------------------------
   Unitset UnitImpl::getInterceptors() const
+  {
+    return getInterceptorsView();
+  }
+  const Unitset& UnitImpl::getInterceptorsView() const
   {
     if (getType() != UnitTypes::Protoss_Carrier && getType() != UnitTypes::Hero_Gantrithor)
-      return Unitset{};
+      return Unitset::none;
     return connectedUnits;
   }
   //--------------------------------------------- GET HATCHERY -----------------------------------------------
@@ -358,9 +376,13 @@ namespace BWAPI
   }
   //--------------------------------------------- GET LARVA --------------------------------------------------
   Unitset UnitImpl::getLarva() const
+  {
+    return getLarvaView();
+  }
+  const Unitset& UnitImpl::getLarvaView() const
   {
     if (!getType().producesLarva())
-      return Unitset{};
+      return Unitset::none;
     return connectedUnits;
   }
   //--------------------------------------------- EXISTS -----------------------------------------------------
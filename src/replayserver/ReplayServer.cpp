@@ -0,0 +1,211 @@
+// A stand-in for the BWAPI server that plays back a recording of GameData frames made by
+// a client with BWAPI_RECORD_FRAMES set. It speaks the shared memory transport from
+// ClientPosix.cpp, whose frame handshake is a Linux futex, so the bot can be run,
+// profiled and benchmarked natively on Linux without StarCraft or Wine. Frames are handed to the client as fast as it consumes
+// them, and the time the client spends on each frame is reported when playback ends.
+//
+// Usage: replayserver <recording>
+
+#include <BWAPI/Client/FrameRecording.h>
+#include <BWAPI/Client/FrameSync.h>
+#include <BWAPI/Client/GameData.h>
+#include <BWAPI/Client/GameTable.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// How long to sleep on the frame handshake before checking whether we were interrupted
+// or whether the client has died.
+constexpr int CLIENT_TIMEOUT_MS = 500;
+
+static volatile std::sig_atomic_t g_interrupted = 0;
+
+static void onInterrupt(int) {
+    g_interrupted = 1;
+}
+
+static bool isProcessAlive(int procID) {
+    return kill(procID, 0) == 0 || errno == EPERM;
+}
+
+// Creates (or opens, if it already exists) a shared memory object of the right size for
+// type T and maps it into memory. Freshly created objects are zero-filled by the kernel.
+template <typename T>
+static T* createSharedObject(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || (info.st_size < (off_t)sizeof(T) && ftruncate(fd, sizeof(T)) == -1)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* view = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return view == MAP_FAILED ? nullptr : static_cast<T*>(view);
+}
+
+// The statistics gathered while serving frames, which are printed at the end.
+struct ReplayStats {
+    int frames = 0;
+    int clientFrames = 0;
+    long long commands = 0;
+    long long unitCommands = 0;
+    long long shapes = 0;
+
+    Clock::duration clientTime = Clock::duration::zero();
+    Clock::duration maxClientTime = Clock::duration::zero();
+};
+
+static void printStats(const ReplayStats& stats, Clock::duration wallTime) {
+    auto toMs = [](Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    std::cout << "Frames served:       " << stats.frames << std::endl;
+    std::cout << "Wall time:           " << toMs(wallTime) << " ms" << std::endl;
+
+    if (stats.clientFrames > 0) {
+        std::cout << "Client time / frame: " << toMs(stats.clientTime) / stats.clientFrames
+            << " ms avg, " << toMs(stats.maxClientTime) << " ms max" << std::endl;
+        std::cout << "Frames per second:   " << stats.frames / (toMs(wallTime) / 1000.0) << std::endl;
+    }
+
+    std::cout << "Commands received:   " << stats.commands << " game, "
+        << stats.unitCommands << " unit, " << stats.shapes << " shapes" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <recording>" << std::endl;
+        return 1;
+    }
+
+    BWAPI::FrameReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+
+    std::signal(SIGINT, &onInterrupt);
+    std::signal(SIGTERM, &onInterrupt);
+
+    int procID = getpid();
+    std::string dataName = "/bwapi_shared_memory_" + std::to_string(procID);
+    std::string syncName = "/bwapi_pipe_" + std::to_string(procID);
+
+    // Create the objects the client looks for, using the same names as the real server.
+    BWAPI::GameTable* table = createSharedObject<BWAPI::GameTable>("/bwapi_shared_memory_game_list");
+    BWAPI::GameData* data = createSharedObject<BWAPI::GameData>(dataName);
+    BWAPI::FrameSync* sync = createSharedObject<BWAPI::FrameSync>(syncName);
+
+    if (table == nullptr || data == nullptr || sync == nullptr) {
+        std::cerr << "Unable to create shared memory: " << std::strerror(errno) << std::endl;
+        shm_unlink(dataName.c_str());
+        shm_unlink(syncName.c_str());
+        return 1;
+    }
+
+    // Claim a slot in the game table that is unused or belongs to a dead server.
+    int slot = -1;
+    for (int i = 0; i < BWAPI::GameTable::MAX_GAME_INSTANCES; i++) {
+        unsigned int owner = table->gameInstances[i].serverProcessID;
+
+        if (owner == 0 || !isProcessAlive(owner)) {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot == -1) {
+        std::cerr << "The game table is full." << std::endl;
+        shm_unlink(dataName.c_str());
+        shm_unlink(syncName.c_str());
+        return 1;
+    }
+
+    // The first recorded frame is what the client sees when it connects, including the
+    // client version it checks against.
+    if (!reader.readFrame(*data)) {
+        std::cerr << "The recording has no complete frame." << std::endl;
+        shm_unlink(dataName.c_str());
+        shm_unlink(syncName.c_str());
+        return 1;
+    }
+    sync->code.store(BWAPI::FrameSync::NONE);
+    sync->clientProcessID = 0;
+
+    table->gameInstances[slot] = BWAPI::GameInstance(procID, false, (unsigned int)std::time(nullptr));
+    std::cout << "Replaying " << argv[1] << " as server " << procID << ", waiting for client" << std::endl;
+
+    ReplayStats stats;
+    Clock::time_point startTime;
+    Clock::time_point frameStart;
+
+    int code = BWAPI::FrameSync::NONE;
+    while (!g_interrupted) {
+        // Wait for the client to hand the current frame back to us.
+        code = BWAPI::waitFrameSync(sync, code, CLIENT_TIMEOUT_MS);
+        if (code != BWAPI::FrameSync::CLIENT_READY) {
+            if (sync->clientProcessID != 0 && !isProcessAlive(sync->clientProcessID)) {
+                std::cerr << "Client exited" << std::endl;
+                break;
+            }
+            continue;
+        }
+
+        if (stats.frames == 0) {
+            // This is the client connecting, so hand it the frame that is already loaded.
+            startTime = Clock::now();
+        } else {
+            Clock::duration elapsed = Clock::now() - frameStart;
+            stats.clientFrames++;
+            stats.clientTime += elapsed;
+            stats.maxClientTime = std::max(stats.maxClientTime, elapsed);
+
+            // Like the real server, consume everything the client sent us this frame.
+            stats.commands += data->commandCount;
+            stats.unitCommands += data->unitCommandCount;
+            stats.shapes += data->shapeCount;
+
+            data->stringCount = 0;
+            data->shapeCount = 0;
+            data->commandCount = 0;
+            data->unitCommandCount = 0;
+
+            if (!reader.readFrame(*data)) {
+                break;
+            }
+        }
+
+        stats.frames++;
+        frameStart = Clock::now();
+        code = BWAPI::FrameSync::SERVER_READY;
+        BWAPI::signalFrameSync(sync, code);
+    }
+
+    // Tell the client that there is nothing left, then remove every trace of ourselves.
+    BWAPI::signalFrameSync(sync, BWAPI::FrameSync::SERVER_CLOSED);
+    table->gameInstances[slot] = BWAPI::GameInstance();
+
+    shm_unlink(dataName.c_str());
+    shm_unlink(syncName.c_str());
+
+    printStats(stats, stats.frames > 0 ? Clock::now() - startTime : Clock::duration::zero());
+    return 0;
+}
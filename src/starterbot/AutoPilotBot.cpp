@@ -1,14 +1,39 @@
 #include "AutoPilotBot.h"
 
+#include "DebugDraw.h"
+#include "Profiler.h"
+
 #include <BWAPI/Client.h>
 
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <chrono>
 
 // Chooses the frame time in milliseconds that the game should be run at.
 constexpr int LOCAL_SPEED = 10;
 
+// The most unit commands we send in a single frame, or zero for no limit. Repeated commands
+// to units that are already carrying them out don't count, since they are dropped before
+// being sent. Commands over the limit are dropped, which leaves the units without orders,
+// so each frame that drops any is logged.
+constexpr int COMMAND_BUDGET = 0;
+
+// Whether to measure the time taken by each event receiver and handler every frame,
+// which is written to a JSON file at the end of each game.
+constexpr bool PROFILE_FRAMES = false;
+// Frames that take longer than this many microseconds are counted as overruns by the
+// profiler. This is the limit that tournaments usually allow before counting a frame as
+// slow.
+constexpr int FRAME_BUDGET = 55000;
+
+// The frame at which the resources we have gathered so far are logged, so that the income
+// of different builds and worker assignments can be compared on the same map and opening.
+// The game runs 24 frames per second, so this is six minutes in.
+constexpr int INCOME_FRAME = 8640;
+constexpr int FRAMES_PER_MINUTE = 24 * 60;
+
 bw::Client& g_client = bw::BWAPIClient;
 
 void AutoPilotBot::runBot() {
@@ -32,10 +57,38 @@ void AutoPilotBot::onStart() {
 
     // For now, we enable complete map information in order to implement working combat.
     g_game->enableFlag(bw::Flag::CompleteMapInformation);
+
+    // The managers re-issue the same commands to their units every frame, so filter out
+    // the ones that would change nothing.
+    bw::CommandQueue& commands = static_cast<bw::GameImpl*>(bw::BroodwarPtr)->getCommandQueue();
+    commands.setEnabled(true);
+    commands.setFrameBudget(COMMAND_BUDGET);
 }
 
 void AutoPilotBot::onEnd(bool isWinner) {
     std::cout << "Game finished with " << (isWinner ? "win" : "loss") << std::endl;
+
+    const bw::CommandQueue::Counters& commands =
+        static_cast<bw::GameImpl*>(bw::BroodwarPtr)->getCommandQueue().getTotalCounters();
+    std::cout << "Sent " << commands.issued << " commands, coalesced " << commands.coalesced
+        << ", dropped " << commands.duplicates << " repeated and " << commands.overBudget
+        << " over budget" << std::endl;
+
+    logIncome();
+
+    if (g_profiler.isEnabled()) {
+        std::string fileName = "profile_" + std::to_string(m_gameCount) + ".json";
+        std::ofstream file(fileName);
+        g_profiler.write(file);
+
+        std::cout << "Wrote frame profile to " << fileName << std::endl;
+    }
+}
+
+void AutoPilotBot::onSendText(const std::string& text) {
+    // Debugging commands are typed into the chat, so the user can turn drawing on and off
+    // while watching the game.
+    g_debugDraw.handleCommand(text);
 }
 
 void AutoPilotBot::initLoop() {
@@ -73,12 +126,35 @@ void AutoPilotBot::playGame() {
     std::cout << "### Game started" << std::endl;
     g_self = g_game->self();
 
+    g_profiler.setEnabled(PROFILE_FRAMES);
+    g_profiler.setFrameBudget(FRAME_BUDGET);
+    g_profiler.reset();
+
     // Now we have the main bot loop: repeatedly handle any events that come our way and
     // update the client. Again, if we disconnect at any point, return.
     while (g_client.isConnected() && g_game->isInGame()) {
-        for (const bw::Event& event : g_game->getEvents()) {
+        // The event buffer is reused every frame, unlike the list from getEvents().
+        bw::GameImpl* game = static_cast<bw::GameImpl*>(bw::BroodwarPtr);
+        const bw::CommandQueue::Counters& commands = game->getCommandQueue().getTotalCounters();
+        int overBudget = commands.overBudget;
+
+        g_profiler.beginFrame();
+        g_debugDraw.beginFrame();
+        for (const bw::Event& event : game->getEventBuffer()) {
             notifyReceiver(event);
         }
+        g_debugDraw.endFrame();
+        g_profiler.endFrame();
+
+        if (commands.overBudget > overBudget) {
+            std::cout << "Frame " << g_game->getFrameCount() << ": dropped "
+                << commands.overBudget - overBudget << " commands over the budget of "
+                << COMMAND_BUDGET << std::endl;
+        }
+
+        if (g_game->getFrameCount() == INCOME_FRAME) {
+            logIncome();
+        }
 
         g_client.update();
     }
@@ -88,6 +164,15 @@ void AutoPilotBot::playGame() {
     m_gameCount++;
 }
 
+void AutoPilotBot::logIncome() {
+    int frame = g_game->getFrameCount();
+    int perMinute = frame > 0 ? g_self->gatheredMinerals() * FRAMES_PER_MINUTE / frame : 0;
+
+    std::cout << "Frame " << frame << ": gathered " << g_self->gatheredMinerals()
+        << " minerals and " << g_self->gatheredGas() << " gas, " << perMinute
+        << " minerals per minute" << std::endl;
+}
+
 int main() {
     AutoPilotBot::runBot();
     return 0;
@@ -21,6 +21,7 @@ protected:
 
 	virtual void onStart() override;
 	virtual void onEnd(bool isWinner) override;
+	virtual void onSendText(const std::string& text) override;
 
 private:
 	// We don't want people to construct AutoPilotBot except by calling runBot().
@@ -32,4 +33,7 @@ private:
 	// Waits for a game to start, and then takes every event from BWAPI as they come and
 	// dispatches them to notifyReceiver() until the game stops or the client disconnects.
 	void playGame();
+
+	// Prints the minerals and gas gathered so far and the average mineral income.
+	void logIncome();
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "BaseMap.h"
+
+#include "UnitTools.h"
+
+#include <algorithm>
+
+void BaseMap::reset(int width, int height) {
+    m_width = width;
+    m_height = height;
+
+    m_counts.clear();
+    m_stamps.clear();
+}
+
+void BaseMap::updateUnit(bw::Unit unit) {
+    // Lifted Terran buildings still count, since they can land again and are usually
+    // only moved short distances.
+    bool contributes = unit->getType().isBuilding() && unit->getPosition().isValid() &&
+        unit->getPlayer() != nullptr && !unit->getPlayer()->isNeutral();
+
+    auto it = m_stamps.find(unit);
+    if (!contributes) {
+        if (it != m_stamps.end()) {
+            addStamp(it->second, -1);
+            m_stamps.erase(it);
+        }
+        return;
+    }
+
+    Stamp stamp = { unit->getPlayer()->getID(), unit->getPosition() };
+    if (it != m_stamps.end()) {
+        // Most of the time nothing has changed, so there's nothing to do.
+        if (it->second.player == stamp.player && it->second.position == stamp.position) {
+            return;
+        }
+        addStamp(it->second, -1);
+        it->second = stamp;
+    } else {
+        m_stamps.emplace(unit, stamp);
+    }
+    addStamp(stamp, 1);
+}
+
+void BaseMap::removeUnit(bw::Unit unit) {
+    auto it = m_stamps.find(unit);
+    if (it != m_stamps.end()) {
+        addStamp(it->second, -1);
+        m_stamps.erase(it);
+    }
+}
+
+bool BaseMap::isInBase(bw::Player player, bw::Position pos) const {
+    if (player == nullptr || player->getID() < 0 || player->getID() >= (int)m_counts.size()) {
+        return false;
+    }
+
+    const std::vector<uint16_t>& counts = m_counts[player->getID()];
+    int x = pos.x / 32;
+    int y = pos.y / 32;
+    if (counts.empty() || pos.x < 0 || pos.y < 0 || x >= m_width || y >= m_height) {
+        return false;
+    }
+
+    return counts[y * m_width + x] > 0;
+}
+
+void BaseMap::addStamp(const Stamp& stamp, int delta) {
+    if (stamp.player >= (int)m_counts.size()) {
+        m_counts.resize(stamp.player + 1);
+    }
+
+    std::vector<uint16_t>& counts = m_counts[stamp.player];
+    if (counts.empty()) {
+        counts.resize(m_width * m_height, 0);
+    }
+
+    // Go through the tiles in the bounding box of the circle and add to those whose
+    // centers are inside it.
+    int left   = std::max((stamp.position.x - BASE_RADIUS) / 32, 0);
+    int top    = std::max((stamp.position.y - BASE_RADIUS) / 32, 0);
+    int right  = std::min((stamp.position.x + BASE_RADIUS) / 32, m_width - 1);
+    int bottom = std::min((stamp.position.y + BASE_RADIUS) / 32, m_height - 1);
+
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            bw::Position center(x * 32 + 16, y * 32 + 16);
+            if (isInRadius(center, stamp.position, BASE_RADIUS)) {
+                counts[y * m_width + x] += delta;
+            }
+        }
+    }
+}
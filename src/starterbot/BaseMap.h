@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Keeps track of which parts of the map belong to each player's bases, where a base is
+// everything within BASE_RADIUS of any of the player's buildings. For each player, every
+// build tile has a count of the buildings that cover it, so checking whether a position is
+// in a base is a single lookup. The counts are updated whenever a building appears,
+// disappears, moves, or changes owner, rather than being recomputed each frame.
+//
+// Positions are tested by the tile they're on, and a tile is covered by a building if the
+// center of the tile is within the radius, so the edges of a base are accurate to about
+// half a tile.
+class BaseMap {
+public:
+    // How large a radius around a player's buildings is considered to be part of a base.
+    static constexpr int BASE_RADIUS = 768;
+
+private:
+    // The player and position that each building was last added to the counts with.
+    struct Stamp {
+        int player;
+        bw::Position position;
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+
+    // The tile counts of each player by player ID, each allocated when the player's first
+    // building is added.
+    std::vector<std::vector<uint16_t>> m_counts;
+
+    std::unordered_map<bw::Unit, Stamp> m_stamps;
+
+public:
+    // Removes all buildings and sizes the map for a new game, in build tiles.
+    void reset(int width, int height);
+
+    // Adds, moves, or removes a unit's contribution to match its current state. Only
+    // buildings that aren't owned by the neutral player contribute.
+    void updateUnit(bw::Unit unit);
+    void removeUnit(bw::Unit unit);
+
+    // Checks whether a position is inside one of the bases of a player.
+    bool isInBase(bw::Player player, bw::Position pos) const;
+
+private:
+    void addStamp(const Stamp& stamp, int delta);
+};
@@ -0,0 +1,754 @@
+#include "BuildPlanner.h"
+
+#include <algorithm>
+#include <cmath>
+
+BuildPlanner::Plan BuildPlanner::plan(const Snapshot& snapshot, const Goal& goal) {
+    Plan plan;
+    if (goal.empty()) {
+        plan.finishFrame = snapshot.frame;
+        return plan;
+    }
+
+    m_types.clear();
+    m_goal.clear();
+
+    bw::Race race = goal[0].first.getRace();
+    m_worker = addType(race.getWorker());
+    m_refinery = addType(race.getRefinery());
+    m_supplyProvider = addType(race.getSupplyProvider());
+
+    for (const auto& item : goal) {
+        int type = addType(item.first);
+        if (type < 0) {
+            return plan;
+        }
+
+        m_goal.push_back({ type, item.second });
+        m_types[type].limit = std::max(m_types[type].limit, item.second);
+    }
+
+    // Types may have been added before the types they require, so whether they can be
+    // made is only worked out once every type is known.
+    m_needsGas = false;
+    for (int i = 0; i < (int)m_types.size(); i++) {
+        checkReachable(i);
+        m_needsGas |= m_types[i].gasPrice > 0;
+    }
+    for (const auto& item : m_goal) {
+        if (!m_types[item.first].isReachable) {
+            return plan;
+        }
+    }
+    if (m_needsGas && m_refinery >= 0) {
+        m_types[m_refinery].limit = std::max(m_types[m_refinery].limit, 1);
+    }
+
+    State state = makeState(snapshot);
+
+    m_nodes = 0;
+    m_bestFrame = NO_FRAME;
+    m_path.clear();
+    m_bestPath.clear();
+    m_children.resize(MAX_DEPTH);
+    m_orders.resize(MAX_DEPTH);
+
+    search(state, 0);
+
+    plan.nodes = m_nodes;
+    if (m_bestFrame != NO_FRAME) {
+        plan.steps = m_bestPath;
+        plan.finishFrame = m_bestFrame;
+    }
+    return plan;
+}
+
+int BuildPlanner::addType(bw::UnitType type) {
+    int index = findType(type);
+    if (index >= 0 || type == bw::UnitTypes::None) {
+        return index;
+    }
+    if (m_types.size() >= MAX_TYPES) {
+        return -1;
+    }
+
+    index = (int)m_types.size();
+    m_types.emplace_back();
+    m_types[index].type = type;
+
+    bw::UnitType builder = type.whatBuilds().first;
+    bw::Race race = type.getRace();
+
+    int producer = -1;
+    bool isFromWorker = builder.isWorker();
+    bool isFromLarva = builder == bw::UnitTypes::Zerg_Larva;
+
+    if (isFromLarva) {
+        producer = addType(bw::UnitTypes::Zerg_Hatchery);
+    } else if (!isFromWorker && builder != bw::UnitTypes::None) {
+        producer = addType(builder);
+    }
+
+    // Zerg morph into whatever they make, except for buildings morphing into other
+    // buildings, which keep counting as what they were.
+    bool consumesProducer = race == bw::Races::Zerg && !isFromLarva &&
+        !(type.isBuilding() && builder.isBuilding());
+
+    // Only Protoss workers are free to leave once a building is started.
+    int producerTime = type.buildTime();
+    if (consumesProducer || isFromLarva || (isFromWorker && race == bw::Races::Protoss)) {
+        producerTime = 0;
+    }
+
+    int supplyProvided = type.supplyProvided();
+    if (race == bw::Races::Zerg && type.isBuilding() && builder.isBuilding()) {
+        supplyProvided -= builder.supplyProvided();
+    }
+
+    std::vector<std::pair<int, int>> required;
+    for (const auto& [requiredType, count] : type.requiredUnits()) {
+        if (requiredType.isWorker() || requiredType == bw::UnitTypes::Zerg_Larva) {
+            continue;
+        }
+        required.push_back({ addType(requiredType), count });
+    }
+    if (type.requiresPsi()) {
+        required.push_back({ addType(bw::UnitTypes::Protoss_Pylon), 1 });
+    }
+
+    // The vector may have grown while adding the other types, so the entry is only filled
+    // in at the end.
+    TypeInfo& info = m_types[index];
+    info.producer = producer;
+    info.isFromWorker = isFromWorker;
+    info.isFromLarva = isFromLarva;
+    info.consumesProducer = consumesProducer;
+    info.producerTime = producerTime;
+    info.supplyProvided = supplyProvided;
+    info.supplyRequired = type.supplyRequired();
+    info.mineralPrice = type.mineralPrice();
+    info.gasPrice = type.gasPrice();
+    info.buildTime = type.buildTime();
+    info.isRefinery = type.isRefinery();
+    info.required = required;
+
+    // A unit that merges two units, like an archon, can't be planned for, which the
+    // producer being missing takes care of.
+    if ((producer < 0 && !isFromWorker) || type.whatBuilds().second > 1 ||
+            type.requiredTech() != bw::TechTypes::None) {
+        info.producer = -1;
+        info.isFromWorker = false;
+    }
+
+    for (const auto& [requiredType, count] : required) {
+        if (requiredType >= 0) {
+            m_types[requiredType].limit = std::max(m_types[requiredType].limit, count);
+        }
+    }
+
+    return index;
+}
+
+int BuildPlanner::findType(bw::UnitType type) const {
+    for (int i = 0; i < (int)m_types.size(); i++) {
+        if (m_types[i].type == type) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool BuildPlanner::checkReachable(int type) {
+    TypeInfo& info = m_types[type];
+    if (info.isReachable) {
+        return true;
+    }
+
+    // The tech tree has no cycles once workers are left out of it, so this always ends.
+    bool isReachable = info.isFromWorker || info.producer >= 0;
+    if (info.producer >= 0) {
+        isReachable &= checkReachable(info.producer);
+    }
+    for (const auto& [requiredType, count] : info.required) {
+        isReachable &= requiredType >= 0 && checkReachable(requiredType);
+    }
+
+    m_types[type].isReachable = isReachable;
+    return isReachable;
+}
+
+BuildPlanner::State BuildPlanner::makeState(const Snapshot& snapshot) const {
+    State state = {};
+    state.frame = snapshot.frame;
+    state.minerals = snapshot.minerals;
+    state.gas = snapshot.gas;
+    state.supplyUsed = snapshot.supplyUsed;
+    state.supplyTotal = snapshot.supplyTotal;
+    state.supplyPlanned = snapshot.supplyTotal;
+    state.patches = snapshot.patches;
+    state.mineralWorkers = snapshot.mineralWorkers;
+    state.gasWorkers = snapshot.gasWorkers;
+
+    for (const Snapshot::Unit& unit : snapshot.units) {
+        if (unit.type.isRefinery() && unit.remainingFrames == 0) {
+            state.refineries++;
+        }
+
+        // A lair counts as a hatchery and a hive as both, so walk back through what each
+        // building morphed from. A building that is still morphing is complete as far as
+        // what it morphed from goes.
+        bool isComplete = unit.remainingFrames == 0;
+        for (bw::UnitType type = unit.type; type != bw::UnitTypes::None;) {
+            int index = findType(type);
+            if (index >= 0) {
+                state.started[index]++;
+                if (isComplete) {
+                    state.completed[index]++;
+                } else {
+                    addItem(state.building, state.buildingCount, index,
+                        state.frame + unit.remainingFrames);
+                    state.supplyPlanned += m_types[index].supplyProvided;
+                    state.workersPlanned += index == m_worker;
+                }
+
+                if (unit.busyFrames > 0 && type == unit.type) {
+                    addItem(state.busy, state.busyCount, index, state.frame + unit.busyFrames);
+                }
+            }
+
+            bw::UnitType builder = type.whatBuilds().first;
+            if (type.getRace() != bw::Races::Zerg || !type.isBuilding() || !builder.isBuilding()) {
+                break;
+            }
+            type = builder;
+            isComplete = true;
+        }
+    }
+
+    return state;
+}
+
+void BuildPlanner::addItem(std::array<Item, MAX_ITEMS>& items, int& count,
+        int type, int frame) const {
+    // With more units in progress than fit, the rest are left out, which only makes the
+    // plan a bit pessimistic.
+    if (count < MAX_ITEMS) {
+        items[count++] = { (int8_t)type, frame };
+    }
+}
+
+void BuildPlanner::completeUnit(State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+
+    state.completed[type]++;
+    state.supplyTotal = std::min(state.supplyTotal + info.supplyProvided, MAX_SUPPLY);
+
+    if (type == m_worker) {
+        state.workersPlanned--;
+        addGatherer(state);
+    } else if (info.isRefinery) {
+        state.refineries++;
+        fillRefineries(state);
+    }
+}
+
+void BuildPlanner::addGatherer(State& state) const {
+    // As with the resource assigner, refineries are filled once every patch has a worker.
+    if (state.gasWorkers < state.refineries * REFINERY_WORKERS &&
+            state.mineralWorkers >= state.patches) {
+        state.gasWorkers++;
+    } else {
+        state.mineralWorkers++;
+    }
+}
+
+void BuildPlanner::removeGatherer(State& state) const {
+    if (state.mineralWorkers > 0) {
+        state.mineralWorkers--;
+    } else if (state.gasWorkers > 0) {
+        state.gasWorkers--;
+    }
+}
+
+void BuildPlanner::fillRefineries(State& state) const {
+    while (state.gasWorkers < state.refineries * REFINERY_WORKERS &&
+            state.mineralWorkers > state.patches) {
+        state.mineralWorkers--;
+        state.gasWorkers++;
+    }
+}
+
+double BuildPlanner::mineralRate(const State& state) const {
+    return mineralRate(state.mineralWorkers, state.patches);
+}
+
+double BuildPlanner::mineralRate(int workers, int patches) const {
+    int full = std::min(workers, patches * (PATCH_WORKERS - 1));
+    int third = std::clamp(workers - full, 0, patches);
+    return full * MINERALS_PER_WORKER + third * MINERALS_PER_THIRD_WORKER;
+}
+
+double BuildPlanner::gasRate(const State& state) const {
+    return std::min(state.gasWorkers, state.refineries * REFINERY_WORKERS) * GAS_PER_WORKER;
+}
+
+void BuildPlanner::advance(State& state, int frame) const {
+    // Income only changes when something finishes, so collect it in one go up to each
+    // event in turn.
+    for (int next = nextEvent(state); next <= frame; next = nextEvent(state)) {
+        collect(state, next);
+
+        for (int i = 0; i < state.buildingCount;) {
+            if (state.building[i].frame <= next) {
+                int type = state.building[i].type;
+                state.building[i] = state.building[--state.buildingCount];
+                completeUnit(state, type);
+            } else {
+                i++;
+            }
+        }
+
+        for (int i = 0; i < state.busyCount;) {
+            if (state.busy[i].frame <= next) {
+                int type = state.busy[i].type;
+                state.busy[i] = state.busy[--state.busyCount];
+
+                // A worker that finished constructing a building goes back to gathering.
+                if (type == m_worker) {
+                    addGatherer(state);
+                }
+            } else {
+                i++;
+            }
+        }
+    }
+
+    collect(state, frame);
+}
+
+void BuildPlanner::collect(State& state, int frame) const {
+    int frames = frame - state.frame;
+    state.minerals += mineralRate(state) * frames;
+    state.gas += gasRate(state) * frames;
+    state.frame = frame;
+}
+
+int BuildPlanner::nextEvent(const State& state) const {
+    int next = NO_FRAME;
+    for (int i = 0; i < state.buildingCount; i++) {
+        next = std::min(next, state.building[i].frame);
+    }
+    for (int i = 0; i < state.busyCount; i++) {
+        next = std::min(next, state.busy[i].frame);
+    }
+    return next;
+}
+
+int BuildPlanner::freeProducers(const State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+    if (info.isFromWorker) {
+        return state.mineralWorkers + state.gasWorkers;
+    }
+
+    int producers = state.completed[info.producer];
+    if (info.isFromLarva) {
+        producers *= LARVA_SLOTS;
+    }
+    for (int i = 0; i < state.busyCount; i++) {
+        if (state.busy[i].type == info.producer) {
+            producers--;
+        }
+    }
+    return producers;
+}
+
+bool BuildPlanner::canStart(const State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+    if (!info.isReachable) {
+        return false;
+    }
+
+    for (const auto& [requiredType, count] : info.required) {
+        if (state.started[requiredType] < count) {
+            return false;
+        }
+    }
+
+    if (info.isFromWorker) {
+        if (state.mineralWorkers + state.gasWorkers == 0) {
+            return false;
+        }
+    } else if (state.started[info.producer] == 0) {
+        return false;
+    }
+
+    // Supply that is on its way counts, since the action can wait for it.
+    int supply = info.supplyRequired;
+    if (supply > 0 && std::min(state.supplyPlanned, MAX_SUPPLY) - state.supplyUsed < supply) {
+        return false;
+    }
+
+    if (info.gasPrice > state.gas && state.refineries == 0 &&
+            (m_refinery < 0 || state.started[m_refinery] == 0)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool BuildPlanner::waitFor(State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+
+    while (true) {
+        bool isReady = freeProducers(state, type) > 0 &&
+            state.supplyTotal - state.supplyUsed >= info.supplyRequired;
+        for (const auto& [requiredType, count] : info.required) {
+            isReady &= state.completed[requiredType] >= count;
+        }
+
+        int next = nextEvent(state);
+        if (isReady) {
+            // Income stays the same until the next event, so we can tell exactly when
+            // there will be enough resources if it's before then.
+            double minerals = info.mineralPrice - state.minerals;
+            double gas = info.gasPrice - state.gas;
+            double mineralRate = this->mineralRate(state);
+            double gasRate = this->gasRate(state);
+
+            if ((minerals <= 0 || mineralRate > 0) && (gas <= 0 || gasRate > 0)) {
+                int wait = 0;
+                if (minerals > 0) {
+                    wait = std::max(wait, (int)std::ceil(minerals / mineralRate));
+                }
+                if (gas > 0) {
+                    wait = std::max(wait, (int)std::ceil(gas / gasRate));
+                }
+
+                if (state.frame + wait <= next) {
+                    advance(state, state.frame + wait);
+                    return true;
+                }
+            }
+        }
+
+        if (next == NO_FRAME) {
+            return false;
+        }
+        advance(state, next);
+    }
+}
+
+void BuildPlanner::start(State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+
+    state.minerals -= info.mineralPrice;
+    state.gas -= info.gasPrice;
+    state.supplyUsed += info.supplyRequired;
+
+    int producer = info.isFromWorker ? m_worker : info.producer;
+    if (info.consumesProducer) {
+        state.completed[producer]--;
+        state.started[producer]--;
+        state.supplyUsed -= m_types[producer].supplyRequired;
+
+        if (info.isFromWorker) {
+            removeGatherer(state);
+        }
+    } else if (info.isFromLarva) {
+        addItem(state.busy, state.busyCount, producer, state.frame + LARVA_TIME);
+    } else if (info.producerTime > 0) {
+        addItem(state.busy, state.busyCount, producer, state.frame + info.producerTime);
+
+        if (info.isFromWorker) {
+            removeGatherer(state);
+        }
+    }
+
+    state.started[type]++;
+    state.supplyPlanned += info.supplyProvided;
+    state.workersPlanned += type == m_worker;
+    addItem(state.building, state.buildingCount, type, state.frame + info.buildTime);
+}
+
+bool BuildPlanner::isGoalStarted(const State& state) const {
+    for (const auto& [type, count] : m_goal) {
+        if (state.started[type] < count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int BuildPlanner::getFinishFrame(const State& state) const {
+    int finish = state.frame;
+    for (int i = 0; i < state.buildingCount; i++) {
+        for (const auto& [type, count] : m_goal) {
+            if (state.building[i].type == type) {
+                finish = std::max(finish, state.building[i].frame);
+            }
+        }
+    }
+    return finish;
+}
+
+int BuildPlanner::getLowerBound(const State& state) const {
+    int bound = getFinishFrame(state);
+
+    // The goal can't finish before the slowest chain of requirements does, nor before
+    // there is enough income for all of it and for everything it requires that hasn't been
+    // started, which every plan has to pay for.
+    int lastBuildTime = NO_FRAME;
+    for (const auto& [type, count] : m_goal) {
+        if (state.started[type] < count) {
+            bound = std::max(bound, state.frame + getReadyTime(state, type));
+            lastBuildTime = std::min(lastBuildTime, m_types[type].buildTime);
+        }
+    }
+
+    if (lastBuildTime == NO_FRAME) {
+        return bound;
+    }
+
+    double minerals = -state.minerals;
+    double gas = -state.gas;
+    for (int type = 0; type < (int)m_types.size(); type++) {
+        int missing = m_types[type].limit - state.started[type];
+        if (missing > 0 && type != m_refinery) {
+            minerals += missing * m_types[type].mineralPrice;
+            gas += missing * m_types[type].gasPrice;
+        }
+    }
+
+    // The refinery is only needed if there isn't enough gas already.
+    if (gas > 0 && m_refinery >= 0 && state.started[m_refinery] == 0) {
+        minerals += m_types[m_refinery].mineralPrice;
+    }
+
+    int refineries = std::max<int>(state.refineries, m_refinery >= 0 ?
+        std::max<int>(state.started[m_refinery], m_types[m_refinery].limit) : 0);
+    double gasRate = refineries * REFINERY_WORKERS * GAS_PER_WORKER;
+
+    if (minerals > 0) {
+        int miningTime = getMiningTime(state, minerals);
+        if (miningTime >= 0) {
+            bound = std::max(bound, state.frame + miningTime + lastBuildTime);
+        }
+    }
+    if (gas > 0 && gasRate > 0) {
+        bound = std::max(bound, state.frame + (int)(gas / gasRate) + lastBuildTime);
+    }
+    return bound;
+}
+
+int BuildPlanner::getMiningTime(const State& state, double minerals) const {
+    // Every worker there will be counts as mining minerals, and every depot or hatchery
+    // larva that has been started makes a worker each time the last one is done, without
+    // waiting for supply. No plan gets workers out faster than that, but every worker has
+    // to be paid for, so each time a batch of workers is done, try stopping there and keep
+    // whichever number of workers mines everything soonest.
+    const TypeInfo& worker = m_types[m_worker];
+    int producers = worker.producer >= 0 ? state.started[worker.producer] : 0;
+    if (worker.isFromLarva) {
+        producers *= LARVA_SLOTS;
+    }
+
+    int workers = state.mineralWorkers + state.gasWorkers + state.workersPlanned;
+    for (int i = 0; i < state.busyCount; i++) {
+        workers += state.busy[i].type == m_worker;
+    }
+
+    int maxWorkers = state.patches * PATCH_WORKERS;
+    workers = std::min(workers, maxWorkers);
+
+    int best = -1;
+    int frames = 0;
+    int added = 0;
+    double mined = 0;
+
+    while (true) {
+        int batch = frames > 0 ? std::min(producers, maxWorkers - workers) : 0;
+        for (int extra = 0; extra <= batch; extra++) {
+            double remaining = minerals + (added + extra) * worker.mineralPrice - mined;
+            double rate = mineralRate(workers + extra, state.patches);
+            if (remaining > 0 && rate > 0) {
+                int time = frames + (int)(remaining / rate);
+                best = best < 0 ? time : std::min(best, time);
+            }
+        }
+
+        workers += batch;
+        added += batch;
+        if (producers == 0 || workers >= maxWorkers || (best >= 0 && frames >= best)) {
+            return best;
+        }
+
+        mined += mineralRate(workers, state.patches) * worker.buildTime;
+        frames += worker.buildTime;
+    }
+}
+
+int BuildPlanner::getReadyTime(const State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+
+    int wait = 0;
+    for (const auto& [requiredType, count] : info.required) {
+        if (state.completed[requiredType] >= count) {
+            continue;
+        }
+
+        if (state.started[requiredType] >= count) {
+            // The required unit is on its way, so wait for the first one to finish.
+            int finish = NO_FRAME;
+            for (int i = 0; i < state.buildingCount; i++) {
+                if (state.building[i].type == requiredType) {
+                    finish = std::min(finish, state.building[i].frame);
+                }
+            }
+            wait = std::max(wait, finish - state.frame);
+        } else {
+            wait = std::max(wait, getReadyTime(state, requiredType));
+        }
+    }
+
+    return wait + info.buildTime;
+}
+
+bool BuildPlanner::isUseful(const State& state, int type) const {
+    const TypeInfo& info = m_types[type];
+
+    if (type == m_worker) {
+        // Workers are only useful while there are patches and refineries to put them on.
+        int workers = state.mineralWorkers + state.gasWorkers + state.workersPlanned;
+        int refineries = m_refinery >= 0 ? state.started[m_refinery] : 0;
+        return workers < state.patches * (PATCH_WORKERS - 1) + refineries * REFINERY_WORKERS;
+    }
+
+    if (type == m_supplyProvider && state.started[type] >= info.limit) {
+        // Supply is only useful if the rest of the goal doesn't fit in what we'll have.
+        int supplyNeeded = state.supplyUsed + m_types[m_worker].supplyRequired;
+        for (const auto& [goalType, count] : m_goal) {
+            supplyNeeded += std::max(count - state.started[goalType], 0) *
+                m_types[goalType].supplyRequired;
+        }
+        if (state.supplyPlanned >= std::min(supplyNeeded, MAX_SUPPLY)) {
+            return false;
+        }
+    } else if (state.started[type] >= info.limit) {
+        // More of a type that makes units of the goal only help while there are more units
+        // left to make than there are types to make them.
+        int remaining = 0;
+        for (const auto& [goalType, count] : m_goal) {
+            if (m_types[goalType].producer == type) {
+                remaining += std::max(count - state.started[goalType], 0);
+            }
+        }
+        if (state.started[type] >= std::min(remaining, MAX_PRODUCERS)) {
+            return false;
+        }
+    }
+
+    if (info.isRefinery && !m_needsGas) {
+        return false;
+    }
+
+    return true;
+}
+
+bool BuildPlanner::isRedundant(int type, int startFrame) const {
+    // Actions that start on the same frame give the same plan in any order, so only the
+    // order of increasing type is searched.
+    if (!m_path.empty() && m_path.back().startFrame == startFrame &&
+            m_types[type].type < m_path.back().type) {
+        return true;
+    }
+
+    // A worker that can't gather back what it cost before the best plan so far finishes,
+    // even at the faster rate of gas, can't make the goal finish any sooner.
+    if (type == m_worker) {
+        const TypeInfo& info = m_types[type];
+        int payback = info.buildTime + (int)(info.mineralPrice / GAS_PER_WORKER);
+        return startFrame + payback >= m_bestFrame;
+    }
+
+    return false;
+}
+
+void BuildPlanner::search(const State& state, int depth) {
+    if (++m_nodes > MAX_NODES) {
+        return;
+    }
+
+    if (isGoalStarted(state)) {
+        int finish = getFinishFrame(state);
+        if (finish < m_bestFrame) {
+            m_bestFrame = finish;
+            m_bestPath = m_path;
+        }
+        return;
+    }
+
+    // The bound of the state was already checked before coming here.
+    if (depth >= MAX_DEPTH) {
+        return;
+    }
+
+    // Try the actions that look like they finish the goal soonest first, which finds a
+    // good plan early so more of the rest can be cut off. Children are started right away
+    // so that their bounds count the action itself.
+    std::vector<Child>& children = m_children[depth];
+    children.clear();
+
+    for (int type = 0; type < (int)m_types.size(); type++) {
+        if (!isUseful(state, type) || !canStart(state, type)) {
+            continue;
+        }
+
+        Child& child = children.emplace_back(Child{ type, 0, 0, state });
+        if (!waitFor(child.state, type)) {
+            children.pop_back();
+            continue;
+        }
+
+        child.startFrame = child.state.frame;
+        if (isRedundant(type, child.startFrame)) {
+            children.pop_back();
+            continue;
+        }
+
+        start(child.state, type);
+        child.bound = getLowerBound(child.state);
+        if (child.bound >= m_bestFrame) {
+            children.pop_back();
+        }
+    }
+
+    std::vector<int>& order = m_orders[depth];
+    order.resize(children.size());
+    for (int i = 0; i < (int)order.size(); i++) {
+        order[i] = i;
+    }
+
+    // The children are sorted through their indices since the states are large to move.
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const Child& first = children[a];
+        const Child& second = children[b];
+        return first.bound != second.bound ? first.bound < second.bound :
+            first.startFrame != second.startFrame ? first.startFrame < second.startFrame :
+            first.type < second.type;
+    });
+
+    for (int index : order) {
+        const Child& child = children[index];
+        if (child.bound >= m_bestFrame) {
+            continue;
+        }
+
+        m_path.push_back({ m_types[child.type].type, child.startFrame });
+        search(child.state, depth + 1);
+        m_path.pop_back();
+
+        if (m_nodes > MAX_NODES) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Searches for the fastest order in which to make a set of units from the current state of
+// the game. The planner simulates the game at the level of resources, supply, and units:
+// income is forecast from how the workers are split between minerals and gas, and every
+// action waits until its costs can be paid, its required units are complete, a unit that
+// makes it is free, and there is supply for it. Workers and supply providers, as well as the
+// buildings that the goal depends on, are added to the plan wherever they pay off.
+//
+// The search is a depth-first branch and bound. The children of each state are tried in
+// order of their lower bound on the finishing frame, so the first plan found is a good one,
+// and the rest of the search only looks at branches whose bound beats the best plan so far.
+// The bound counts the income that the workers could bring in, paying for every worker and
+// every unit the goal still needs. Actions that start on the same frame are only tried in
+// one order, and workers that can't pay for themselves before the best plan finishes are
+// left out.
+//
+// The search gives up after MAX_NODES states, keeping the best plan it has found. The goals
+// that the strategy sets during a game are searched completely in a few hundred states,
+// but larger goals from the very start of a game, like a handful of units from 4 workers,
+// stop at the limit. In the benchmark, a plan that reaches the limit takes 3 to 5 ms in the
+// unoptimized build and 0.5 to 0.8 ms with -O2, so plans can be redone every few frames.
+//
+// Zerg larva are modeled as each hatchery being able to start a larva unit every LARVA_TIME
+// frames, holding at most LARVA_SLOTS at a time.
+class BuildPlanner {
+public:
+    // Everything the planner needs to know about the game, which the production manager
+    // fills in. This keeps the planner independent of BWAPI's game state.
+    struct Snapshot {
+        struct Unit {
+            bw::UnitType type;
+
+            // The frames until the unit is complete, and the frames until it has finished
+            // making whatever it's making.
+            int remainingFrames = 0;
+            int busyFrames = 0;
+        };
+
+        int frame = 0;
+        int minerals = 0;
+        int gas = 0;
+        int supplyUsed = 0;
+        int supplyTotal = 0;
+
+        // The mineral patches of the bases and the workers gathering from them.
+        int patches = 0;
+        int mineralWorkers = 0;
+        int gasWorkers = 0;
+
+        // Our units, including the ones that haven't been started yet but whose costs have
+        // already been set aside, such as buildings that a worker is on its way to place.
+        std::vector<Unit> units;
+    };
+
+    // The number of units of each type that should exist, counting units in progress.
+    using Goal = std::vector<std::pair<bw::UnitType, int>>;
+
+    struct Step {
+        bw::UnitType type;
+        int startFrame;
+    };
+
+    struct Plan {
+        std::vector<Step> steps;
+
+        // The frame when the last unit of the goal is complete, or -1 if the goal can't be
+        // reached, such as when it requires a tech or a unit that nothing can make.
+        int finishFrame = -1;
+
+        // The number of states the search looked at.
+        int nodes = 0;
+    };
+
+private:
+    // The income of a single worker per frame. A third worker on a patch mostly waits for
+    // the other two, so it adds much less.
+    static constexpr double MINERALS_PER_WORKER = 0.045;
+    static constexpr double MINERALS_PER_THIRD_WORKER = 0.02;
+    static constexpr double GAS_PER_WORKER = 0.07;
+
+    static constexpr int PATCH_WORKERS = 3;
+    static constexpr int REFINERY_WORKERS = 3;
+
+    static constexpr int LARVA_TIME = 342;
+    static constexpr int LARVA_SLOTS = 3;
+
+    // The most units that are made of a type that the goal doesn't ask for directly but
+    // makes the goal faster, like extra gateways for a goal of many zealots.
+    static constexpr int MAX_PRODUCERS = 3;
+
+    static constexpr int MAX_SUPPLY = 400;
+    static constexpr int MAX_NODES = 1000;
+
+    // The most types and the most units in progress that the search keeps track of. The
+    // state is copied for every node, so these are fixed arrays.
+    static constexpr int MAX_TYPES = 24;
+    static constexpr int MAX_ITEMS = 24;
+
+    static constexpr int NO_FRAME = 1 << 30;
+
+    // The deepest the search goes, which is the most steps a plan can have.
+    static constexpr int MAX_DEPTH = 64;
+
+    // A type that the search knows about, which is every type in the goal, everything they
+    // require or are made from, and the worker, refinery, and supply provider of the race.
+    struct TypeInfo {
+        bw::UnitType type;
+
+        // The type that makes this one, or -1 if it's made by a worker. Units made from
+        // larva have the hatchery as their producer.
+        int producer = -1;
+        bool isFromWorker = false;
+        bool isFromLarva = false;
+
+        // Whether making this type uses up the unit that makes it, as with most Zerg, and
+        // otherwise, how long it keeps that unit busy.
+        bool consumesProducer = false;
+        int producerTime = 0;
+
+        // The supply the type adds, which for a building that morphed from another is only
+        // what it adds on top of that building.
+        int supplyProvided = 0;
+
+        // BWAPI's type functions aren't inlined, so the ones used by the search are copied
+        // here.
+        int supplyRequired = 0;
+        int mineralPrice = 0;
+        int gasPrice = 0;
+        int buildTime = 0;
+        bool isRefinery = false;
+
+        std::vector<std::pair<int, int>> required;
+
+        // Whether anything can make this type, which isn't the case for types that need a
+        // tech or that merge two units.
+        bool isReachable = false;
+
+        // The number of units of this type that the goal asks for or that something else
+        // requires.
+        int limit = 0;
+    };
+
+    struct Item {
+        int8_t type;
+        int frame;
+    };
+
+    struct State {
+        int frame;
+        double minerals;
+        double gas;
+        int supplyUsed;
+        int supplyTotal;
+
+        // The supply we'll have once the units in progress are complete, and the workers
+        // in progress.
+        int supplyPlanned;
+        int workersPlanned;
+
+        int patches;
+        int mineralWorkers;
+        int gasWorkers;
+        int refineries;
+
+        // Complete units of each type, counting units of the types that satisfy it, and
+        // units that are complete or in progress.
+        std::array<int16_t, MAX_TYPES> completed;
+        std::array<int16_t, MAX_TYPES> started;
+
+        // Units that are in progress, with the frame they complete, and units that are
+        // busy making something, with the frame they're free again.
+        std::array<Item, MAX_ITEMS> building;
+        std::array<Item, MAX_ITEMS> busy;
+        int buildingCount;
+        int busyCount;
+    };
+
+    std::vector<TypeInfo> m_types;
+    std::vector<std::pair<int, int>> m_goal;
+
+    int m_worker;
+    int m_refinery;
+    int m_supplyProvider;
+    bool m_needsGas;
+
+    int m_nodes;
+    int m_bestFrame;
+    std::vector<Step> m_path;
+    std::vector<Step> m_bestPath;
+
+    // The actions tried from a state, with the state right after starting them and the
+    // lower bound of that state.
+    struct Child {
+        int type;
+        int startFrame;
+        int bound;
+        State state;
+    };
+
+    // The children of the state at each depth of the search, which keep their memory
+    // between plans.
+    std::vector<std::vector<Child>> m_children;
+    std::vector<std::vector<int>> m_orders;
+
+public:
+    // Finds the fastest plan to reach a goal from a snapshot of the game.
+    Plan plan(const Snapshot& snapshot, const Goal& goal);
+
+private:
+    // Adds a type and everything it depends on to the types the search knows about,
+    // returning its index or -1 if there are too many types.
+    int addType(bw::UnitType type);
+    int findType(bw::UnitType type) const;
+    bool checkReachable(int type);
+
+    State makeState(const Snapshot& snapshot) const;
+    void addItem(std::array<Item, MAX_ITEMS>& items, int& count, int type, int frame) const;
+    void completeUnit(State& state, int type) const;
+
+    // Moves a worker onto or off of the resources, keeping the same order of filling the
+    // resources as the resource assigner.
+    void addGatherer(State& state) const;
+    void removeGatherer(State& state) const;
+    void fillRefineries(State& state) const;
+
+    double mineralRate(const State& state) const;
+    double mineralRate(int workers, int patches) const;
+    double gasRate(const State& state) const;
+
+    // Moves the state forward to a frame, collecting income and completing units on the
+    // way.
+    void advance(State& state, int frame) const;
+    void collect(State& state, int frame) const;
+    int nextEvent(const State& state) const;
+
+    int freeProducers(const State& state, int type) const;
+
+    // Whether an action could ever start from a state without making anything else first.
+    bool canStart(const State& state, int type) const;
+    // Moves the state forward to the first frame the action can start, returning false if
+    // that never happens.
+    bool waitFor(State& state, int type) const;
+    void start(State& state, int type) const;
+
+    bool isGoalStarted(const State& state) const;
+    int getFinishFrame(const State& state) const;
+    int getLowerBound(const State& state) const;
+
+    // The fewest frames in which some number of minerals could be mined, or -1 if they
+    // never will be.
+    int getMiningTime(const State& state, double minerals) const;
+
+    // The frames until a unit of a type could be complete if resources were no object.
+    int getReadyTime(const State& state, int type) const;
+
+    // Whether an action is worth trying from a state at all.
+    bool isUseful(const State& state, int type) const;
+    // Whether an action starting at a frame after the current path can be left out,
+    // because another branch gives the same plan or it can't beat the best plan so far.
+    bool isRedundant(int type, int startFrame) const;
+
+    void search(const State& state, int depth);
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+// Bunkers, carriers and reavers don't attack with their own weapons, but with the units
+// they hold or launch. The threat map and the combat simulator both treat those attacks as
+// the carrying unit's own, adjusted by these values.
+
+// Carriers and reavers launch the units that do their damage from up to this far away.
+constexpr int LAUNCH_RANGE = 8 * 32;
+// Reavers fire a scarab this often, in frames. A reaver is counted as always having a
+// scarab ready, since it builds more as it fires and we can't see the scarabs of enemy
+// reavers anyway.
+constexpr int REAVER_COOLDOWN = 60;
+// An interceptor's weapon has no real cooldown, since it only fires during its passes over
+// the target, so it is given roughly the time between passes instead.
+constexpr int INTERCEPTOR_COOLDOWN = 37;
+// A bunker holds up to four marines, which get an extra tile of range inside it.
+constexpr int BUNKER_MARINES = 4;
+constexpr int BUNKER_RANGE_BONUS = 32;
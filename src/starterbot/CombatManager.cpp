@@ -1,7 +1,29 @@
 #include "CombatManager.h"
 
-CombatManager::CombatManager(UnitManager& unitManager) :
-    m_unitManager(unitManager) {
+#include "DebugDraw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+CombatManager::CombatManager(UnitManager& unitManager, JobScheduler& jobScheduler) :
+    m_unitManager(unitManager),
+    m_jobScheduler(jobScheduler),
+    m_defenseClusters(IDEAL_CLUSTER, MAX_CLUSTER),
+    m_offenseClusters(IDEAL_CLUSTER, MAX_CLUSTER),
+    m_dangerClusters(IDEAL_CLUSTER, MAX_CLUSTER) {
+    // Targeting issues commands, so it comes before the simulation, and it works on the
+    // clusters, so they're brought up to date right before it when both are due. The
+    // costs are rough estimates in microseconds, which the scheduler corrects as it
+    // measures the jobs.
+    m_clusterJob = m_jobScheduler.addJob("clusters", 0, RETARGET_TIME, 100,
+        [this]() { updateClusters(); return true; });
+    m_defenseJob = m_jobScheduler.addJob("defenseTargets", 1, RETARGET_TIME, 200,
+        [this]() { updateActiveDefense(); return true; });
+    m_offenseJob = m_jobScheduler.addJob("offenseTargets", 1, RETARGET_TIME, 200,
+        [this]() { updateAttackOffense(); return true; });
+    m_simulationJob = m_jobScheduler.addJob("simulation", 2, SIMULATION_TIME, 500,
+        [this]() { return updateSimulation(); });
 }
 
 void CombatManager::startAttack() {
@@ -16,7 +38,7 @@ void CombatManager::startAttack() {
         m_defenseLeader = nullptr;
 
         // Since units have moved into a different set, we need to recluster everything.
-        m_clusterTimer = 0;
+        m_jobScheduler.runNow(m_clusterJob);
 
         // We want to get the army to the enemy base rather than attacking just yet.
         m_isWaiting = true;
@@ -25,14 +47,21 @@ void CombatManager::startAttack() {
     m_isAttacking = true;
 }
 
+const ThreatMap& CombatManager::getThreatMap() const {
+    return m_threatMap;
+}
+
+bool CombatManager::isAttackFavorable() const {
+    return m_isAttackFavorable;
+}
+
 void CombatManager::onStart() {
-    m_clusterTimer = 0;
-    m_defenseTimer = 0;
-    m_offenseTimer = 0;
+    m_isSimulating = false;
 
     m_isDefending = false;
     m_isAttacking = false;
     m_isWaiting = false;
+    m_isAttackFavorable = false;
 
     m_defenseUnits.clear();
     m_offenseUnits.clear();
@@ -42,10 +71,21 @@ void CombatManager::onStart() {
     m_offenseClusters.clear();
     m_dangerClusters.clear();
 
+    m_threatMap.reset(g_game->mapWidth(), g_game->mapHeight());
+
     m_defenseLeader = nullptr;
     m_offenseLeader = nullptr;
 }
 
+void CombatManager::onAnalyze(TaskPool& pool) {
+    // The danger set and the threat map both read the enemy units without touching each
+    // other, so they're worked out side by side.
+    pool.run({
+        [this]() { updateDanger(); },
+        [this]() { updateThreats(); },
+    });
+}
+
 void CombatManager::onFrame() {
     updateUnits();
     updateDefense();
@@ -53,14 +93,15 @@ void CombatManager::onFrame() {
 }
 
 void CombatManager::onDraw() {
-    drawClusters(m_defenseClusters, WAIT_RADIUS, bw::Colors::Purple);
-    drawClusters(m_offenseClusters, WAIT_RADIUS, bw::Colors::Purple);
-    drawClusters(m_dangerClusters, DANGER_RADIUS, bw::Colors::Orange);
+    drawClusters(m_defenseClusters.getClusters(), WAIT_RADIUS, bw::Colors::Purple);
+    drawClusters(m_offenseClusters.getClusters(), WAIT_RADIUS, bw::Colors::Purple);
+    drawClusters(m_dangerClusters.getClusters(), DANGER_RADIUS, bw::Colors::Orange);
 }
 
 void CombatManager::onUnitDestroy(bw::Unit unit) {
     m_defenseUnits.erase(unit);
     m_offenseUnits.erase(unit);
+    m_dangerUnits.erase(unit);
 
     // If the unit is the defensive or offensive leader, just set it to null. The relevant
     // functions will decide which unit to assign as the leader later on.
@@ -71,9 +112,11 @@ void CombatManager::onUnitDestroy(bw::Unit unit) {
         m_offenseLeader = nullptr;
     }
 
-    // Since a unit was destroyed, we need to recompute the clusters to avoid having any
-    // dead units in the clusters.
-    m_clusterTimer = 0;
+    // The clusters may not be recomputed until later in the frame, so the unit is taken
+    // out of them now to avoid having any dead units in the clusters.
+    m_defenseClusters.remove(unit);
+    m_offenseClusters.remove(unit);
+    m_dangerClusters.remove(unit);
 }
 
 void CombatManager::updateUnits() {
@@ -83,21 +126,83 @@ void CombatManager::updateUnits() {
         m_unitManager.reserveUnits(bw::CanAttack && bw::CanMove && !bw::IsWorker);
     m_defenseUnits.insert(reserved.begin(), reserved.end());
 
-    // We find all known enemy units with the same criteria, putting them in the set of
-    // dangerous enemy units.
+    // If we obtained some new defensive units, we need to recompute the unit clusters
+    // rather than waiting for the next time around.
+    if (!reserved.empty()) {
+        m_jobScheduler.runNow(m_clusterJob);
+    }
+}
+
+void CombatManager::updateClusters() {
+    m_defenseClusters.update(m_defenseUnits);
+    m_offenseClusters.update(m_offenseUnits);
+    m_dangerClusters.update(m_dangerUnits);
+}
+
+void CombatManager::updateDanger() {
+    // We find all known enemy units with the same criteria as our own fighters, putting
+    // them in the set of dangerous enemy units.
     m_dangerUnits = m_unitManager.enemyUnits(bw::CanAttack && bw::CanMove && !bw::IsWorker);
+}
 
-    // If our recluster timeout has occurred or we obtained some new defensive units, we
-    // need to recompute the unit clusters.
-    if (m_clusterTimer == 0 || !reserved.empty()) {
-        m_clusterTimer = RETARGET_TIME;
+void CombatManager::updateThreats() {
+    // Every enemy unit that can attack, workers and buildings included, adds to the threat
+    // map, which only has to redo the ones that moved or changed.
+    m_threatMap.update(m_unitManager.enemyUnits());
+}
 
-        m_defenseClusters = findUnitClusters(m_defenseUnits, IDEAL_CLUSTER, MAX_CLUSTER);
-        m_offenseClusters = findUnitClusters(m_offenseUnits, IDEAL_CLUSTER, MAX_CLUSTER);
-        m_dangerClusters = findUnitClusters(m_dangerUnits, IDEAL_CLUSTER, MAX_CLUSTER);
-    } else {
-        m_clusterTimer--;
+bool CombatManager::updateSimulation() {
+    // If we're in the middle of a simulation, continue it with the units it started with.
+    if (m_isSimulating) {
+        return advanceSimulation();
     }
+
+    bw::Unitset enemyArmy = m_unitManager.enemyUnits(bw::CanAttack && !bw::IsWorker);
+    if (m_defenseUnits.empty() || enemyArmy.empty()) {
+        m_isAttackFavorable = false;
+        return true;
+    }
+
+    // The enemy army is somewhere else entirely, so we move it as a whole to where the
+    // fight would start: ENGAGE_DISTANCE away from the center of our army, on the side it
+    // would be approached from.
+    bw::Position ourCenter = m_defenseUnits.getPosition();
+    bw::Position theirCenter = enemyArmy.getPosition();
+
+    double dx = theirCenter.x - ourCenter.x;
+    double dy = theirCenter.y - ourCenter.y;
+    double length = std::sqrt(dx * dx + dy * dy);
+    if (length == 0) {
+        dx = 1;
+        length = 1;
+    }
+
+    bw::Position engagePos = ourCenter + bw::Position(
+        (int)(dx / length * ENGAGE_DISTANCE), (int)(dy / length * ENGAGE_DISTANCE));
+
+    m_simulator.clear();
+    m_simulator.addUnits(m_defenseUnits, 0);
+    m_simulator.addUnits(enemyArmy, 1, engagePos - theirCenter);
+
+    m_simulator.start();
+    m_isSimulating = true;
+
+    return advanceSimulation();
+}
+
+bool CombatManager::advanceSimulation() {
+    // Large fights can take a while to simulate, so we only play out part of the fight
+    // each time and let the scheduler resume it on a later frame.
+    int frames = std::min(SIMULATION_SLICE, SIMULATION_FRAMES - m_simulator.getResult().frames);
+    if (!m_simulator.advance(frames) && m_simulator.getResult().frames < SIMULATION_FRAMES) {
+        return false;
+    }
+
+    CombatSimulator::Result result = m_simulator.getResult();
+    m_isAttackFavorable = result.endValue[0] > result.endValue[1] * FAVORABLE_RATIO;
+    m_isSimulating = false;
+
+    return true;
 }
 
 void CombatManager::updateDefense() {
@@ -110,25 +215,23 @@ void CombatManager::updateDefense() {
     // If so, we need to have our defensive code kick in.
     bool defend = false;
 
-    for (bw::Unit baseUnit : getBaseUnits(g_self)) {
+    for (bw::Unit baseUnit : m_unitManager.baseUnits(g_self)) {
         if (hasUnitInRadius(m_dangerUnits, baseUnit->getPosition(), DANGER_RADIUS)) {
             defend = true;
             break;
         }
     }
 
-    // If we need to defend and weren't doing so before, reset the defense timer so our
-    // units can start defending right away.
+    // If we need to defend and weren't doing so before, run the defense job right away so
+    // our units can start defending.
     if (defend && !m_isDefending) {
-        m_defenseTimer = 0;
+        m_jobScheduler.runNow(m_defenseJob);
     }
     m_isDefending = defend;
 
     // Now that we know our current defensive status, we can decide what our defensive
-    // units should be doing.
-    if (m_isDefending) {
-        updateActiveDefense();
-    } else {
+    // units should be doing. Active defense is taken care of by the defense job.
+    if (!m_isDefending) {
         updatePassiveDefense();
     }
 }
@@ -166,23 +269,19 @@ void CombatManager::updatePassiveDefense() {
 }
 
 void CombatManager::updateActiveDefense() {
-    // Update our retarget timeout. If it hasn't expired yet, we don't do any retargeting.
-    if (m_defenseTimer != 0) {
-        m_defenseTimer--;
+    // The job runs all the time, but only has something to do while we're defending.
+    if (!m_isDefending || m_defenseUnits.empty()) {
         return;
     }
-    m_defenseTimer = RETARGET_TIME;
 
-    // We need to choose a target for each cluster of defensive units. The simplest
-    // choice, that of choosing the closest dangerous enemy unit, is simple but gives
-    // fairly good results.
-    for (Cluster& cluster : m_defenseClusters) {
-        bw::Unit target = getClosestUnit(m_dangerUnits, cluster.centroid);
+    // We need to choose a target for each defensive unit among the dangerous enemy
+    // units. Choosing them all at once lets us spread our units over the enemies rather
+    // than wasting damage on a unit that is already as good as dead.
+    m_targetAssigner.clear();
+    m_targetAssigner.addAttackers(m_defenseUnits);
+    m_targetAssigner.addTargets(m_dangerUnits);
 
-        for (bw::Unit unit : cluster.units) {
-            unit->attack(m_unitManager.getReal(target));
-        }
-    }
+    attackAssignedTargets(m_defenseClusters.getClusters(), { &m_dangerUnits });
 }
 
 void CombatManager::updateOffense() {
@@ -193,11 +292,9 @@ void CombatManager::updateOffense() {
     }
 
     // We decide what to do with our units based on whether the units are moving to the
-    // enemy base or are currently attacking.
+    // enemy base or are currently attacking, which is taken care of by the offense job.
     if (m_isWaiting) {
         updateWaitingOffense();
-    } else {
-        updateAttackOffense();
     }
 }
 
@@ -206,12 +303,16 @@ void CombatManager::updateWaitingOffense() {
         // If we don't currently have an offensive leader, then all of our units still
         // need to get close to the enemy base.
         bw::Unitset buildings = m_unitManager.enemyUnits(bw::IsBuilding);
-        bw::Unitset baseUnits = getBaseUnits(g_game->enemy());
+        bw::Unitset baseUnits = m_unitManager.baseUnits(g_game->enemy());
 
         for (bw::Unit unit : m_offenseUnits) {
             // Tell each unit to move towards the closest known building at the enemy base
-            // to get them moving over there.
-            bw::Unit target = getClosestUnit(buildings, unit->getPosition());
+            // to get them moving over there, measuring by the distance they actually have
+            // to walk when possible.
+            bw::Unit target = getClosestUnitByGround(buildings, unit->getPosition());
+            if (target == nullptr) {
+                target = getClosestUnit(buildings, unit->getPosition());
+            }
             if (target != nullptr) {
                 unit->move(target->getPosition());
             }
@@ -245,77 +346,103 @@ void CombatManager::updateWaitingOffense() {
             }
         }
 
-        // If we are fully regrouped, we can stop waiting and reset the offensive timer so
-        // we can begin the battle!
+        // If we are fully regrouped, we can stop waiting and run the offense job right
+        // away so we can begin the battle!
         if (fullGroup) {
             m_isWaiting = false;
-            m_offenseTimer = 0;
+            m_jobScheduler.runNow(m_offenseJob);
         }
     }
 
     // If, at any point during our travel to the enemy base or regrouping procedure,
-    // dangerous enemy units get too close to any of our attacking units, we can't take
-    // the time to regroup and must begin attacking.
+    // dangerous enemy units get too close to any of our attacking units, or any of them
+    // is within reach of something that can attack it, such as a static defense, we can't
+    // take the time to regroup and must begin attacking.
     for (bw::Unit unit : m_offenseUnits) {
-        if (hasUnitInRadius(m_dangerUnits, unit->getPosition(), DANGER_RADIUS)) {
+        if (hasUnitInRadius(m_dangerUnits, unit->getPosition(), DANGER_RADIUS) ||
+                m_threatMap.getThreat(unit->getPosition(), unit->isFlying()) > 0) {
             m_isWaiting = false;
-            m_offenseTimer = 0;
+            m_jobScheduler.runNow(m_offenseJob);
             break;
         }
     }
 }
 
 void CombatManager::updateAttackOffense() {
-    // Update our retarget timeout. If it hasn't expired yet, we don't do any retargeting.
-    if (m_offenseTimer != 0) {
-        m_offenseTimer--;
+    // Like the defense job, this only has something to do while we're attacking.
+    if (!m_isAttacking || m_isWaiting || m_offenseUnits.empty()) {
         return;
     }
-    m_offenseTimer = RETARGET_TIME;
 
     // Attacking code is slighly more complex than defensive code, since we need to attack
     // the enemy's workers and buildings as well as their troops. However, we still choose
     // which one to attack based on their proximity.
+    // Choose the targets to attack as follows: first, attack dangerous troops, as they
+    // are the most likely to kill our soldiers. Second, attack anything else that can
+    // attack us, namely certain buildings and workers, which also cuts off their means
+    // of production. Finally, attack anything else that can be attacked. Units already
+    // added with a higher priority keep it, so each set only adds the units that are new.
     bw::Unitset enemyAttack = m_unitManager.enemyUnits(bw::CanAttack);
     bw::Unitset enemyOthers = m_unitManager.enemyUnits(bw::IsTargetable);
 
-    for (Cluster& cluster : m_offenseClusters) {
-        // Choose the target to attack as follows: first, attack dangerous troops, as they
-        // are the most likely to kill our soldiers. Second, attack anything else that can
-        // attack us, namely certain buildings and workers, which also cuts off their
-        // means of production. Finally, attack anything else that can be attacked.
-        bw::Unit target = getClosestUnit(m_dangerUnits, cluster.centroid);
-        if (target == nullptr) {
-            target = getClosestUnit(enemyAttack, cluster.centroid);
-        }
-        if (target == nullptr) {
-            target = getClosestUnit(enemyOthers, cluster.centroid);
-        }
+    m_targetAssigner.clear();
+    m_targetAssigner.addAttackers(m_offenseUnits);
+    m_targetAssigner.addTargets(m_dangerUnits, 0);
+    m_targetAssigner.addTargets(enemyAttack, 1);
+    m_targetAssigner.addTargets(enemyOthers, 2);
 
-        for (bw::Unit unit : cluster.units) {
-            unit->attack(m_unitManager.getReal(target));
-        }
-    }
+    attackAssignedTargets(m_offenseClusters.getClusters(), { &m_dangerUnits, &enemyAttack, &enemyOthers });
 }
 
-bw::Unitset CombatManager::getBaseUnits(bw::Player player) {
-    // Start with the set of buildings owned by this player.
-    bw::Unitset buildings = m_unitManager.shadowUnits(bw::GetPlayer == player && bw::IsBuilding);
-    bw::Unitset baseUnits;
-
-    for (bw::Unit building : buildings) {
-        // Add all the units owned by this player that are within the base radius of this
-        // building to the set.
-        bw::Unitset nearUnits = getUnitsInRadius(m_unitManager.shadowUnits(bw::GetPlayer == player),
-            building->getPosition(), BASE_RADIUS);
-        baseUnits.insert(nearUnits.begin(), nearUnits.end());
+void CombatManager::attackAssignedTargets(
+        const std::vector<Cluster>& clusters, std::initializer_list<const bw::Unitset*> targets) {
+    m_targetAssigner.solve();
+
+    bw::Unitset assigned;
+    for (const TargetAssigner::Assignment& assignment : m_targetAssigner.getAssignments()) {
+        bw::Unit target = m_unitManager.getReal(assignment.target);
+        if (target != nullptr) {
+            assignment.attacker->attack(target);
+            assigned.insert(assignment.attacker);
+        }
     }
 
-    return baseUnits;
+    // Units that didn't get a target, such as units that can't hit any of the targets or
+    // whose target we can't see right now, still go with their cluster. They attack-move
+    // towards the enemy closest to the cluster, taking the target sets in order, so they
+    // fight whatever they can on the way.
+    for (const Cluster& cluster : clusters) {
+        bw::Unit target = nullptr;
+        bool isTargetChosen = false;
+
+        for (bw::Unit unit : cluster.units) {
+            if (assigned.contains(unit)) {
+                continue;
+            }
+
+            if (!isTargetChosen) {
+                for (const bw::Unitset* units : targets) {
+                    target = getClosestUnit(*units, cluster.centroid);
+                    if (target != nullptr) {
+                        break;
+                    }
+                }
+                isTargetChosen = true;
+            }
+
+            if (target != nullptr) {
+                unit->attack(target->getPosition());
+            }
+        }
+    }
 }
 
 void CombatManager::drawClusters(
         const std::vector<Cluster>& clusters, int radius, bw::Color color) {
+    if (!g_debugDraw.isEnabled(DrawChannel::Clusters)) {
+        return;
+    }
+
     for (const Cluster& cluster : clusters) {
         // Don't bother drawing a cluster that is empty to avoid useless circles drawn
         // around false centroids of empty sets.
@@ -323,16 +450,32 @@ void CombatManager::drawClusters(
             continue;
         }
 
+        // Every shape of a cluster lies within its circle or between its units, so we can
+        // skip the whole cluster if none of that is on screen.
+        bw::Position topLeft = cluster.centroid - bw::Position(radius, radius);
+        bw::Position bottomRight = cluster.centroid + bw::Position(radius, radius);
+        for (bw::Unit unit : cluster.units) {
+            bw::Position pos = unit->getPosition();
+            topLeft = bw::Position(std::min(topLeft.x, pos.x), std::min(topLeft.y, pos.y));
+            bottomRight = bw::Position(std::max(bottomRight.x, pos.x), std::max(bottomRight.y, pos.y));
+        }
+        if (!g_debugDraw.isOnScreen(topLeft, bottomRight)) {
+            continue;
+        }
+
         // Draw a line between every pair of units in this cluster with the appropriate
         // color, which is a crude but effective way to delineate the units in a cluster.
-        for (bw::Unit first : cluster.units) {
-            for (bw::Unit second : cluster.units) {
-                g_game->drawLineMap(first->getPosition(), second->getPosition(), color);
+        // Each pair is only drawn once, and the channel's budget stops huge clusters from
+        // crowding out everything else.
+        for (auto first = cluster.units.begin(); first != cluster.units.end(); ++first) {
+            for (auto second = std::next(first); second != cluster.units.end(); ++second) {
+                g_debugDraw.drawLine(DrawChannel::Clusters,
+                    (*first)->getPosition(), (*second)->getPosition(), color);
             }
         }
 
         // Draw a dot at the centroid of the cluster and a circle at the specified radius.
-        g_game->drawCircleMap(cluster.centroid, 2, color, true);
-        g_game->drawCircleMap(cluster.centroid, radius, color);
+        g_debugDraw.drawCircle(DrawChannel::Clusters, cluster.centroid, 2, color, true);
+        g_debugDraw.drawCircle(DrawChannel::Clusters, cluster.centroid, radius, color);
     }
 }
\ No newline at end of file
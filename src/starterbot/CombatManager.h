@@ -1,9 +1,17 @@
 #pragma once
 
+#include "CombatSimulator.h"
+#include "JobScheduler.h"
+#include "TargetAssigner.h"
+#include "TaskPool.h"
+#include "ThreatMap.h"
 #include "Tools.h"
 #include "UnitManager.h"
 #include "UnitTools.h"
 
+#include <initializer_list>
+#include <vector>
+
 // This class is in charge of all defensive and offensive operation for the bot. It
 // automatically reserves fighter units for defensive purposes and defends the base
 // against attacking enemy units. Additionally, when the class is instructed to attack, it
@@ -12,6 +20,7 @@
 class CombatManager : public EventReceiver {
 private:
     UnitManager& m_unitManager;
+    JobScheduler& m_jobScheduler;
 
     // The ideal and maximum sizes that we cluster units into for combat purposes.
     static constexpr int IDEAL_CLUSTER = 7;
@@ -22,8 +31,6 @@ private:
     // How close all the units in the group need to be to be considered regrouped.
     static constexpr int GROUP_RADIUS = 192;
 
-    // How large a radius around our buildings is considered to be part of our base.
-    static constexpr int BASE_RADIUS = 768;
     // How close enemy units must be to our base for our defensive units to attack.
     static constexpr int DANGER_RADIUS = 256;
 
@@ -31,13 +38,27 @@ private:
     // in order to prevent switching between targets too quickly to get any progress.
     static constexpr int RETARGET_TIME = 50;
 
-    // The countdown timer between recomputing which units are in each cluster. We do this
-    // on a timeout to prevent clusters from changing too rapidly as units move around.
-    int m_clusterTimer;
-
-    // The countdown timers before choosing new targets for our defensive/attacking units.
-    int m_defenseTimer;
-    int m_offenseTimer;
+    // How often we simulate a fight against the known enemy army, how many frames each
+    // simulation plays out at most, how many of those are played out per game frame, and
+    // how far apart the armies start.
+    static constexpr int SIMULATION_TIME = 24;
+    static constexpr int SIMULATION_FRAMES = 24 * 20;
+    static constexpr int SIMULATION_SLICE = 24 * 5;
+    static constexpr int ENGAGE_DISTANCE = 384;
+    // How many times more value our army must have left than the enemy's after a
+    // simulated fight for an attack to be considered favorable.
+    static constexpr int FAVORABLE_RATIO = 2;
+
+    // The jobs that recompute which units are in each cluster, choose new targets for our
+    // defensive and attacking units, and simulate fights. Clustering and targeting run
+    // every RETARGET_TIME frames to prevent them from changing too rapidly, and are run
+    // right away when something happens that they need to respond to.
+    int m_clusterJob;
+    int m_defenseJob;
+    int m_offenseJob;
+    int m_simulationJob;
+    // Whether a simulation has been started but not finished yet.
+    bool m_isSimulating;
 
     // Whether the bot should defend against attackers, which is recomputed each frame.
     bool m_isDefending;
@@ -47,6 +68,9 @@ private:
     // Whether the bot is moving units to the enemy base or waiting for units to regroup
     // before commencing the attack itself.
     bool m_isWaiting;
+    // Whether the last simulated fight between our defensive units and the known enemy
+    // army went well enough for us to attack.
+    bool m_isAttackFavorable;
 
     // Sets containing the reserved units for defense and offense. All new fighter units
     // are reserved for defense upon creation. Defensive troops are transferred to become
@@ -55,13 +79,23 @@ private:
     bw::Unitset m_offenseUnits;
     // Set containing all enemy units considered dangerous for the purposes of defense,
     // namely mobile troops (not including buildings) that can attack us. This set is
-    // recomputed every frame, and primarily exists for clustering purposes.
+    // recomputed every frame during analysis, and primarily exists for clustering
+    // purposes.
     bw::Unitset m_dangerUnits;
 
-    // Clusterings of the previous defensive, offensive, and dangerous enemy sets.
-    std::vector<Cluster> m_defenseClusters;
-    std::vector<Cluster> m_offenseClusters;
-    std::vector<Cluster> m_dangerClusters;
+    // The damage that known enemy units threaten to deal across the map, updated every
+    // frame during analysis from every enemy unit that can attack, including static
+    // defenses. Attacking units stop regrouping as soon as any of them is under threat.
+    ThreatMap m_threatMap;
+    CombatSimulator m_simulator;
+    // Chooses targets for all of our defensive or offensive units together.
+    TargetAssigner m_targetAssigner;
+
+    // Clusterings of the defensive, offensive, and dangerous enemy sets, which are kept
+    // between reclusterings so that each one only has to account for what changed.
+    UnitClusterer m_defenseClusters;
+    UnitClusterer m_offenseClusters;
+    UnitClusterer m_dangerClusters;
 
     // Arbitrary units that are chosen to be the "leaders" for the defensive and offensive
     // parts of the army, primarily to have a fixed unit that the other units can follow
@@ -70,14 +104,24 @@ private:
     bw::Unit m_offenseLeader;
 
 public:
-    CombatManager(UnitManager& unitManager);
+    CombatManager(UnitManager& unitManager, JobScheduler& jobScheduler);
 
     // Instructs the combat code to start attacking the enemy base using all the current
     // units assigned as defensive units.
     void startAttack();
 
+    // Gets the threat map, which can be sampled to find how dangerous a position is for
+    // our ground or air units.
+    const ThreatMap& getThreatMap() const;
+
+    // Whether our defensive units would clearly win a fight against all the enemy army
+    // units we know about, according to the combat simulator. This is false until we've
+    // seen some of the enemy army.
+    bool isAttackFavorable() const;
+
 protected:
     virtual void onStart() override;
+    virtual void onAnalyze(TaskPool& pool) override;
     virtual void onFrame() override;
     virtual void onDraw() override;
     virtual void onUnitDestroy(bw::Unit unit) override;
@@ -86,6 +130,15 @@ private:
     // Helper functions that manage each major portion of combat, namely common unit
     // tasks shared across the whole class, defense, and offense.
     void updateUnits();
+    void updateDanger();
+    void updateThreats();
+
+    // The work done by the scheduled jobs besides targeting. The simulation starts a new
+    // simulated fight or continues the current one, playing out part of it each time and
+    // returning whether it's finished.
+    void updateClusters();
+    bool updateSimulation();
+    bool advanceSimulation();
 
     void updateDefense();
     void updatePassiveDefense();
@@ -95,9 +148,11 @@ private:
     void updateWaitingOffense();
     void updateAttackOffense();
 
-    // Gets all units that are within the base radius of any buildings for a specific
-    // player, used to determine which units are a safe distance away from a base.
-    bw::Unitset getBaseUnits(bw::Player player);
+    // Tells each of our units to attack the target the target assigner chose for it. The
+    // rest of the units in the clusters attack-move towards the closest unit of the first
+    // of the target sets that isn't empty.
+    void attackAssignedTargets(
+        const std::vector<Cluster>& clusters, std::initializer_list<const bw::Unitset*> targets);
 
     // Draws lines and circles to give a visual demonstration of the clusters in a base.
     void drawClusters(const std::vector<Cluster>& clusters, int radius, bw::Color color);
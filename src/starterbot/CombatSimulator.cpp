@@ -0,0 +1,315 @@
+#include "CombatSimulator.h"
+
+#include "CarriedWeapons.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Every hit that its damage type lets through deals at least half a hit point of damage.
+constexpr int MIN_DAMAGE = 128;
+
+void CombatSimulator::clear() {
+    m_units.clear();
+}
+
+void CombatSimulator::addUnit(bw::Unit unit, int side, bw::Position offset) {
+    if (unit->getHitPoints() <= 0 || !unit->getPosition().isValid() || unit->isInvincible()) {
+        return;
+    }
+
+    bw::UnitType type = unit->getType();
+    bw::Player player = unit->getPlayer();
+    bw::Position pos = unit->getPosition() + offset;
+
+    SimUnit sim;
+    sim.x = (float)pos.x;
+    sim.y = (float)pos.y;
+    sim.speed = type.isBuilding() ? 0.0f : (float)player->topSpeed(type);
+    sim.radius = std::max(type.width(), type.height()) / 2;
+
+    sim.hitPoints = unit->getHitPoints() * 256;
+    sim.shields = unit->getShields() * 256;
+    sim.maxHealth = (type.maxHitPoints() + type.maxShields()) * 256;
+    sim.armor = player->armor(type) * 256;
+    sim.shieldArmor = player->getUpgradeLevel(bw::UpgradeTypes::Protoss_Plasma_Shields) * 256;
+    sim.size = (uint8_t)type.size().getID();
+    sim.isFlyer = type.isFlyer();
+    sim.side = (uint8_t)side;
+
+    // Some units don't attack with their own weapons, but with the units they carry. For
+    // those, we use the weapons of the carried units, adjusted for how many attack at once
+    // and from how far away, the same way as the threat map.
+    if (type == bw::UnitTypes::Terran_Bunker) {
+        bw::UnitType marine = bw::UnitTypes::Terran_Marine;
+        sim.ground = makeWeapon(player, marine, marine.groundWeapon());
+        sim.air = makeWeapon(player, marine, marine.airWeapon());
+        for (Weapon* weapon : { &sim.ground, &sim.air }) {
+            weapon->hits *= BUNKER_MARINES;
+            weapon->range += BUNKER_RANGE_BONUS;
+        }
+    } else if (type == bw::UnitTypes::Protoss_Carrier) {
+        bw::UnitType interceptor = bw::UnitTypes::Protoss_Interceptor;
+        sim.ground = makeWeapon(player, interceptor, interceptor.groundWeapon());
+        sim.air = makeWeapon(player, interceptor, interceptor.airWeapon());
+        for (Weapon* weapon : { &sim.ground, &sim.air }) {
+            weapon->hits *= unit->getInterceptorCount();
+            weapon->range = LAUNCH_RANGE;
+            weapon->cooldown = INTERCEPTOR_COOLDOWN;
+        }
+    } else if (type == bw::UnitTypes::Protoss_Reaver) {
+        bw::UnitType scarab = bw::UnitTypes::Protoss_Scarab;
+        sim.ground = makeWeapon(player, scarab, scarab.groundWeapon());
+        sim.ground.range = LAUNCH_RANGE;
+        sim.ground.cooldown = REAVER_COOLDOWN;
+    } else {
+        sim.ground = makeWeapon(player, type, type.groundWeapon());
+        sim.air = makeWeapon(player, type, type.airWeapon());
+    }
+    sim.cooldown = std::max(unit->getGroundWeaponCooldown(), unit->getAirWeaponCooldown());
+
+    sim.value = type.mineralPrice() + type.gasPrice();
+
+    m_units.push_back(sim);
+}
+
+void CombatSimulator::addUnits(const bw::Unitset& units, int side, bw::Position offset) {
+    for (bw::Unit unit : units) {
+        addUnit(unit, side, offset);
+    }
+}
+
+int CombatSimulator::getUnitCount() const {
+    return (int)m_units.size();
+}
+
+CombatSimulator::Result CombatSimulator::simulate(
+        int maxFrames, Behavior ourBehavior, Behavior theirBehavior) {
+    start(ourBehavior, theirBehavior);
+    advance(maxFrames);
+    return getResult();
+}
+
+void CombatSimulator::start(Behavior ourBehavior, Behavior theirBehavior) {
+    // Work on a copy so that the added units can be simulated again.
+    m_state = m_units;
+    m_behaviors[0] = ourBehavior;
+    m_behaviors[1] = theirBehavior;
+
+    m_frame = 0;
+    m_isOver = false;
+
+    // Retreating units run straight away from where the other side started out.
+    int counts[2] = {};
+    for (int side = 0; side < 2; side++) {
+        m_centerX[side] = 0;
+        m_centerY[side] = 0;
+    }
+
+    for (const SimUnit& unit : m_state) {
+        m_centerX[unit.side] += unit.x;
+        m_centerY[unit.side] += unit.y;
+        counts[unit.side]++;
+    }
+    for (int side = 0; side < 2; side++) {
+        if (counts[side] > 0) {
+            m_centerX[side] /= counts[side];
+            m_centerY[side] /= counts[side];
+        }
+    }
+}
+
+bool CombatSimulator::advance(int frames) {
+    for (int step = 0; step < frames && !m_isOver; step++) {
+        bool isFighting = false;
+        m_hits.clear();
+
+        for (int i = 0; i < (int)m_state.size(); i++) {
+            SimUnit& unit = m_state[i];
+            if (unit.hitPoints <= 0) {
+                continue;
+            }
+            if (unit.cooldown > 0) {
+                unit.cooldown--;
+            }
+
+            if (m_behaviors[unit.side] == Behavior::Retreat) {
+                int other = 1 - unit.side;
+                float dx = unit.x - m_centerX[other];
+                float dy = unit.y - m_centerY[other];
+                float length = std::sqrt(dx * dx + dy * dy);
+
+                if (length > 0) {
+                    unit.x += dx / length * unit.speed;
+                    unit.y += dy / length * unit.speed;
+                }
+                continue;
+            }
+
+            // Keep attacking the same unit until it dies, like units in the game do.
+            if (unit.target < 0 || m_state[unit.target].hitPoints <= 0) {
+                unit.target = findTarget(i);
+                if (unit.target < 0) {
+                    continue;
+                }
+            }
+            isFighting = true;
+
+            SimUnit& target = m_state[unit.target];
+            const Weapon& weapon = weaponAgainst(unit, target);
+
+            // Ranges are measured between the edges of the units.
+            float dx = target.x - unit.x;
+            float dy = target.y - unit.y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            float distance = length - unit.radius - target.radius;
+
+            if (distance < weapon.minRange) {
+                // The target is too close to fire at. Units that can move back off, and the
+                // others give it up, since findTarget() passes over such targets for them.
+                if (unit.speed > 0 && length > 0) {
+                    float step = std::min(unit.speed, weapon.minRange - distance);
+                    unit.x -= dx / length * step;
+                    unit.y -= dy / length * step;
+                } else {
+                    unit.target = -1;
+                }
+            } else if (distance <= weapon.range) {
+                if (unit.cooldown == 0) {
+                    m_hits.push_back({ i, unit.target });
+                    unit.cooldown = weapon.cooldown;
+                }
+            } else if (unit.speed > 0 && length > 0) {
+                float step = std::min(unit.speed, distance - weapon.range);
+                unit.x += dx / length * step;
+                unit.y += dy / length * step;
+            }
+        }
+
+        for (const Hit& hit : m_hits) {
+            const Weapon& weapon = weaponAgainst(m_state[hit.attacker], m_state[hit.target]);
+            for (int i = 0; i < weapon.hits; i++) {
+                applyHit(weapon, m_state[hit.target]);
+            }
+        }
+
+        if (!isFighting) {
+            m_isOver = true;
+        } else {
+            m_frame++;
+        }
+    }
+
+    return m_isOver;
+}
+
+CombatSimulator::Result CombatSimulator::getResult() const {
+    Result result;
+    result.frames = m_frame;
+
+    // The added units are the state at the start, in the same order as the working copy.
+    for (int i = 0; i < (int)m_state.size(); i++) {
+        const SimUnit& unit = m_state[i];
+        result.startValue[unit.side] += getValue(m_units[i]);
+
+        if (unit.hitPoints > 0) {
+            result.survivors[unit.side]++;
+            result.endValue[unit.side] += getValue(unit);
+        }
+    }
+
+    return result;
+}
+
+int CombatSimulator::getValue(const SimUnit& unit) {
+    return (int)((long long)unit.value * (unit.hitPoints + unit.shields) /
+        std::max(unit.maxHealth, 1));
+}
+
+CombatSimulator::Weapon CombatSimulator::makeWeapon(
+        bw::Player player, bw::UnitType type, bw::WeaponType weapon) {
+    Weapon result;
+    if (weapon == bw::WeaponTypes::None || weapon == bw::WeaponTypes::Unknown) {
+        return result;
+    }
+
+    // The player's damage includes every hit of the weapon, but armor applies to each
+    // hit separately, so we split it back up.
+    result.hits = std::max(weapon.damageFactor(), 1);
+    result.damage = player->damage(weapon) / result.hits * 256;
+    result.range = player->weaponMaxRange(weapon);
+    result.minRange = weapon.minRange();
+    result.damageType = (uint8_t)weapon.damageType().getID();
+
+    // The player's cooldown only accounts for upgrades of ground weapons.
+    result.cooldown = weapon == type.groundWeapon() ?
+        player->weaponDamageCooldown(type) : weapon.damageCooldown();
+    result.cooldown = std::max(result.cooldown, 1);
+
+    return result;
+}
+
+const CombatSimulator::Weapon& CombatSimulator::weaponAgainst(
+        const SimUnit& attacker, const SimUnit& target) const {
+    return target.isFlyer ? attacker.air : attacker.ground;
+}
+
+bool CombatSimulator::canAttack(const SimUnit& attacker, const SimUnit& target) const {
+    return weaponAgainst(attacker, target).hits > 0;
+}
+
+int CombatSimulator::findTarget(int index) const {
+    const SimUnit& unit = m_state[index];
+
+    int minTarget = -1;
+    float minDistance = 0;
+
+    for (int i = 0; i < (int)m_state.size(); i++) {
+        const SimUnit& other = m_state[i];
+        if (other.side == unit.side || other.hitPoints <= 0 || !canAttack(unit, other)) {
+            continue;
+        }
+
+        float dx = other.x - unit.x;
+        float dy = other.y - unit.y;
+        float distance = dx * dx + dy * dy;
+
+        // Units that can't move can't get away from targets inside their minimum range.
+        int minRange = weaponAgainst(unit, other).minRange;
+        if (unit.speed == 0 && minRange > 0 &&
+                std::sqrt(distance) - unit.radius - other.radius < minRange) {
+            continue;
+        }
+
+        if (minTarget < 0 || distance < minDistance) {
+            minTarget = i;
+            minDistance = distance;
+        }
+    }
+
+    return minTarget;
+}
+
+void CombatSimulator::applyHit(const Weapon& weapon, SimUnit& target) {
+    int damage = weapon.damage;
+
+    // Shields soak up damage first, reduced only by their own armor and regardless of
+    // the damage type. Whatever they can't absorb carries over to the hit points.
+    if (target.shields > 0) {
+        damage = std::max(damage - target.shieldArmor, 0);
+        if (target.shields >= damage) {
+            target.shields -= damage;
+            return;
+        }
+
+        damage -= target.shields;
+        target.shields = 0;
+    }
+
+    if (weapon.damageType != bw::DamageTypes::Enum::Ignore_Armor) {
+        damage -= target.armor;
+    }
+    int ratio = bw::damageRatio[weapon.damageType][target.size];
+    if (ratio > 0) {
+        target.hitPoints -= std::max(damage * ratio / 256, MIN_DAMAGE);
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <cstdint>
+#include <vector>
+
+// Predicts the outcome of a fight between two groups of units by playing it out frame by
+// frame on compact copies of the units' current state. Each unit picks the closest enemy
+// it can hit, walks towards it until it's in range, and then fires whenever its weapon is
+// off cooldown. Damage follows the rules of the game: shields absorb damage first and
+// have their own armor, while hit points are protected by armor and take a fraction of
+// the damage depending on the weapon's damage type and the target's size. Weapon damage,
+// range, armor and speed include each player's upgrades.
+//
+// Things that are left out for speed are collisions between units, splash damage, spells,
+// healing and regeneration, so the result is an estimate. Carriers, reavers and bunkers
+// fight with the weapons of the units they launch or hold, from a fixed range. It is
+// deterministic, though: simulating the same units twice always gives the same result.
+//
+// Units are added once, after which simulate() can be called any number of times, for
+// example to compare fighting against retreating, without modifying the added units. A
+// simulation can also be played out a few frames at a time with start() and advance(),
+// so that a long one can be spread over several game frames.
+class CombatSimulator {
+public:
+    // What the units of a side do during a simulation.
+    enum class Behavior {
+        // Go after the closest enemy unit and attack it.
+        Fight,
+        // Move straight away from the enemy without attacking.
+        Retreat,
+    };
+
+    struct Result {
+        // The number of frames simulated before the fight ended or the limit was reached.
+        int frames = 0;
+        // For each side, the number of units alive at the end.
+        int survivors[2] = {};
+        // For each side, the mineral and gas cost of its units at the start and the end of
+        // the fight. The value of a damaged unit is scaled by its remaining hit points and
+        // shields.
+        int startValue[2] = {};
+        int endValue[2] = {};
+    };
+
+private:
+    // Damage and hit points are kept in 256ths, as the game does.
+    struct Weapon {
+        int damage = 0; // Per hit, including upgrades.
+        int hits = 0;
+        int range = 0;
+        int minRange = 0;
+        int cooldown = 0;
+        uint8_t damageType = 0;
+    };
+
+    struct SimUnit {
+        float x = 0;
+        float y = 0;
+        float speed = 0;
+        int radius = 0;
+
+        int hitPoints = 0;
+        int shields = 0;
+        int maxHealth = 0;
+        int armor = 0;
+        int shieldArmor = 0;
+        uint8_t size = 0;
+        bool isFlyer = false;
+        uint8_t side = 0;
+
+        Weapon ground;
+        Weapon air;
+        int cooldown = 0;
+        int target = -1;
+
+        int value = 0;
+    };
+
+    // The units as added, and the working copy that a simulation modifies.
+    std::vector<SimUnit> m_units;
+    std::vector<SimUnit> m_state;
+
+    // The hits made in the current frame, applied after every unit has fired so that the
+    // order of the units doesn't matter.
+    struct Hit {
+        int attacker;
+        int target;
+    };
+    std::vector<Hit> m_hits;
+
+    // The state of the simulation in progress.
+    Behavior m_behaviors[2] = {};
+    float m_centerX[2] = {};
+    float m_centerY[2] = {};
+    int m_frame = 0;
+    bool m_isOver = false;
+
+public:
+    void clear();
+
+    // Adds a unit to one side of the fight, where side 0 is usually our units and side 1
+    // the enemy's. The unit can be a real or shadow unit, and is placed at its current
+    // position moved by the given offset. Units that can't be hurt, like those that are
+    // already dead, are ignored.
+    void addUnit(bw::Unit unit, int side, bw::Position offset = bw::Positions::Origin);
+    void addUnits(const bw::Unitset& units, int side, bw::Position offset = bw::Positions::Origin);
+
+    int getUnitCount() const;
+
+    // Plays out the fight for at most maxFrames frames. The fight ends early once neither
+    // side has a unit that can still attack a unit of the other side.
+    Result simulate(int maxFrames, Behavior ourBehavior = Behavior::Fight,
+        Behavior theirBehavior = Behavior::Fight);
+
+    // Sets up a new simulation of the added units without playing out any frames.
+    void start(Behavior ourBehavior = Behavior::Fight, Behavior theirBehavior = Behavior::Fight);
+    // Plays out at most the given number of frames of the simulation in progress. Returns
+    // true once the fight is over, after which advancing has no effect.
+    bool advance(int frames);
+    // Gets the outcome of the simulation so far.
+    Result getResult() const;
+
+private:
+    static Weapon makeWeapon(bw::Player player, bw::UnitType type, bw::WeaponType weapon);
+
+    const Weapon& weaponAgainst(const SimUnit& attacker, const SimUnit& target) const;
+    bool canAttack(const SimUnit& attacker, const SimUnit& target) const;
+
+    // Finds the closest living unit of the other side that a unit can attack. Units that
+    // can't move skip targets inside their weapon's minimum range.
+    int findTarget(int index) const;
+
+    // The unit's cost scaled by its remaining hit points and shields.
+    static int getValue(const SimUnit& unit);
+
+    // Deals the damage of one hit of a weapon to a unit, split between its shields and
+    // hit points the way the game does it.
+    static void applyHit(const Weapon& weapon, SimUnit& target);
+};
@@ -0,0 +1,148 @@
+#include "DebugDraw.h"
+
+#include <BWAPI/Client.h>
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+DebugDraw g_debugDraw;
+
+size_t DebugDraw::ShapeHash::operator()(const Shape& shape) const {
+    size_t hash = (size_t)shape.type * 2 + shape.isSolid;
+    for (int value : { shape.color.getID(), shape.first.x, shape.first.y, shape.second.x, shape.second.y }) {
+        hash = hash * 31 + std::hash<int>()(value);
+    }
+    return hash;
+}
+
+DebugDraw::DebugDraw() :
+    m_channels({ {
+        // Health bars take three boxes and up to a dozen tick marks for each bar.
+        { "boxes", true, 500 },
+        { "commands", true, 1000 },
+        { "health", true, 4000 },
+        { "clusters", true, 2000 },
+    } }) {
+}
+
+void DebugDraw::setEnabled(DrawChannel channel, bool isEnabled) {
+    m_channels[(int)channel].isEnabled = isEnabled;
+}
+
+bool DebugDraw::isEnabled(DrawChannel channel) const {
+    const Channel& entry = m_channels[(int)channel];
+    return m_isVisible && entry.isEnabled && entry.count < entry.budget;
+}
+
+bool DebugDraw::isOnScreen(bw::Position topLeft, bw::Position bottomRight) const {
+    return bottomRight.x >= m_screenTopLeft.x && topLeft.x <= m_screenBottomRight.x &&
+        bottomRight.y >= m_screenTopLeft.y && topLeft.y <= m_screenBottomRight.y;
+}
+
+void DebugDraw::drawLine(DrawChannel channel, bw::Position from, bw::Position to, bw::Color color) {
+    bw::Position topLeft(std::min(from.x, to.x), std::min(from.y, to.y));
+    bw::Position bottomRight(std::max(from.x, to.x), std::max(from.y, to.y));
+
+    addShape(channel, { ShapeType::Line, false, color, from, to }, topLeft, bottomRight);
+}
+
+void DebugDraw::drawBox(DrawChannel channel, bw::Position topLeft, bw::Position bottomRight,
+        bw::Color color, bool isSolid) {
+    addShape(channel, { ShapeType::Box, isSolid, color, topLeft, bottomRight },
+        topLeft, bottomRight);
+}
+
+void DebugDraw::drawCircle(DrawChannel channel, bw::Position center, int radius,
+        bw::Color color, bool isSolid) {
+    bw::Position extent(radius, radius);
+
+    // The radius goes in the second position so that shapes can be compared as a whole.
+    addShape(channel, { ShapeType::Circle, isSolid, color, center, bw::Position(radius, 0) },
+        center - extent, center + extent);
+}
+
+void DebugDraw::beginFrame() {
+    m_shapes.clear();
+    m_seen.clear();
+
+    for (Channel& channel : m_channels) {
+        channel.count = 0;
+    }
+
+    m_isVisible = g_game->isGUIEnabled();
+    m_screenTopLeft = g_game->getScreenPosition();
+    m_screenBottomRight = m_screenTopLeft + bw::Position(SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+void DebugDraw::endFrame() {
+    if (m_shapes.empty()) {
+        return;
+    }
+
+    // Something may have drawn straight to BWAPI already, so we only fill what's left of
+    // the shape buffer rather than tripping its assertion.
+    const bw::GameData* data = static_cast<bw::GameImpl*>(bw::BroodwarPtr)->getGameData();
+    int room = std::min(bw::GameData::MAX_SHAPES - data->shapeCount, FRAME_BUDGET);
+    int count = std::min((int)m_shapes.size(), std::max(room, 0));
+
+    bw::Game* game = bw::BroodwarPtr;
+    for (int i = 0; i < count; i++) {
+        const Shape& shape = m_shapes[i];
+
+        switch (shape.type) {
+        case ShapeType::Line:
+            game->drawLineMap(shape.first, shape.second, shape.color);
+            break;
+        case ShapeType::Box:
+            game->drawBoxMap(shape.first, shape.second, shape.color, shape.isSolid);
+            break;
+        case ShapeType::Circle:
+            game->drawCircleMap(shape.first, shape.second.x, shape.color, shape.isSolid);
+            break;
+        }
+    }
+}
+
+bool DebugDraw::handleCommand(const std::string& text) {
+    std::istringstream stream(text);
+    std::string command, name;
+    stream >> command >> name;
+
+    if (command != "/draw") {
+        return false;
+    }
+
+    bool isFound = false;
+    for (Channel& channel : m_channels) {
+        if (name == "all" || name == "none") {
+            channel.isEnabled = name == "all";
+            isFound = true;
+        } else if (name == channel.name) {
+            channel.isEnabled = !channel.isEnabled;
+            isFound = true;
+        }
+    }
+
+    // Whether or not the channel was found, list the state of every channel so the user
+    // can see what is available.
+    if (!isFound && !name.empty()) {
+        g_game->printf("Unknown drawing channel \"%s\"", name.c_str());
+    }
+    for (const Channel& channel : m_channels) {
+        g_game->printf("Drawing %s: %s", channel.name, channel.isEnabled ? "on" : "off");
+    }
+    return true;
+}
+
+void DebugDraw::addShape(DrawChannel channel, const Shape& shape,
+        bw::Position topLeft, bw::Position bottomRight) {
+    if (!isEnabled(channel) || !isOnScreen(topLeft, bottomRight)) {
+        return;
+    }
+
+    if (m_seen.insert(shape).second) {
+        m_shapes.push_back(shape);
+        m_channels[(int)channel].count++;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// The kinds of debugging information that can be drawn, each of which can be turned on
+// and off separately while the game is running.
+enum class DrawChannel {
+    UnitBoxes,
+    Commands,
+    HealthBars,
+    Clusters,
+    Count
+};
+
+// Collects the debugging shapes drawn during a frame and sends them to BWAPI together at
+// the end of the frame. Shapes that are entirely off screen are dropped, as are shapes
+// identical to one already drawn this frame, and each channel only gets so many shapes per
+// frame. This keeps drawing cheap no matter how many units there are, and makes sure the
+// fixed shape buffer that BWAPI shares with the game never overflows.
+//
+// Channels are toggled by typing "/draw" followed by the name of a channel into the chat,
+// or "/draw all" or "/draw none" for every channel at once.
+class DebugDraw {
+private:
+    // The part of the map that is visible on screen, which is the size of the game at its
+    // native resolution.
+    static constexpr int SCREEN_WIDTH = 640;
+    static constexpr int SCREEN_HEIGHT = 480;
+
+    // The most shapes that are sent to BWAPI per frame, which leaves room in the shape
+    // buffer for anything else that draws directly.
+    static constexpr int FRAME_BUDGET = 10000;
+
+    enum class ShapeType : uint8_t {
+        Line,
+        Box,
+        Circle
+    };
+
+    struct Shape {
+        ShapeType type;
+        bool isSolid;
+        bw::Color color;
+        bw::Position first;
+        bw::Position second;
+
+        bool operator==(const Shape& other) const = default;
+    };
+
+    struct ShapeHash {
+        size_t operator()(const Shape& shape) const;
+    };
+
+    struct Channel {
+        const char* name;
+        bool isEnabled;
+        int budget;
+
+        // The number of shapes drawn in the channel this frame.
+        int count = 0;
+    };
+
+    std::array<Channel, (int)DrawChannel::Count> m_channels;
+
+    // The shapes of the current frame in the order they were drawn, plus the same shapes
+    // in a set to find duplicates. Both keep their memory between frames.
+    std::vector<Shape> m_shapes;
+    std::unordered_set<Shape, ShapeHash> m_seen;
+
+    bool m_isVisible = false;
+    bw::Position m_screenTopLeft;
+    bw::Position m_screenBottomRight;
+
+public:
+    DebugDraw();
+
+    void setEnabled(DrawChannel channel, bool isEnabled);
+
+    // Whether anything drawn in a channel this frame can still show up. When it can't,
+    // callers can skip the work of figuring out what to draw.
+    bool isEnabled(DrawChannel channel) const;
+
+    // Whether any part of a rectangle on the map is on screen, which callers can use to
+    // skip drawing a group of shapes at once.
+    bool isOnScreen(bw::Position topLeft, bw::Position bottomRight) const;
+
+    // These work like the corresponding BWAPI functions in map coordinates.
+    void drawLine(DrawChannel channel, bw::Position from, bw::Position to, bw::Color color);
+    void drawBox(DrawChannel channel, bw::Position topLeft, bw::Position bottomRight,
+        bw::Color color, bool isSolid = false);
+    void drawCircle(DrawChannel channel, bw::Position center, int radius,
+        bw::Color color, bool isSolid = false);
+
+    // Starts collecting the shapes for a new frame, which needs to be called before any
+    // events for the frame are handled.
+    void beginFrame();
+    // Sends the shapes collected during the frame to BWAPI.
+    void endFrame();
+
+    // Handles a "/draw" chat command, returning false if the text isn't one.
+    bool handleCommand(const std::string& text);
+
+private:
+    void addShape(DrawChannel channel, const Shape& shape,
+        bw::Position topLeft, bw::Position bottomRight);
+};
+
+extern DebugDraw g_debugDraw;
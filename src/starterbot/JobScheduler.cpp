@@ -0,0 +1,150 @@
+#include "JobScheduler.h"
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+JobScheduler::JobScheduler(int frameBudget) :
+    m_frameBudget(frameBudget) {
+}
+
+void JobScheduler::setFrameBudget(int frameBudget) {
+    m_frameBudget = frameBudget;
+}
+
+int JobScheduler::getFrameBudget() const {
+    return m_frameBudget;
+}
+
+int JobScheduler::addJob(const char* name, int priority, int period, int cost, Job job) {
+    m_jobs.push_back({ name, priority, period, std::move(job), cost });
+    return (int)m_jobs.size() - 1;
+}
+
+void JobScheduler::removeJob(int id) {
+    // The job might be the one running right now, so we only mark it here.
+    m_jobs[id].isRemoved = true;
+}
+
+void JobScheduler::runNow(int id) {
+    Entry& entry = m_jobs[id];
+    if (entry.startFrame < 0) {
+        entry.dueFrame = std::min(entry.dueFrame, g_game->getFrameCount());
+    }
+}
+
+void JobScheduler::reset() {
+    for (Entry& entry : m_jobs) {
+        if (entry.period == 0) {
+            entry.isRemoved = true;
+        }
+        entry.dueFrame = 0;
+        entry.startFrame = -1;
+    }
+    m_lastChanceFrame = -1;
+}
+
+void JobScheduler::runFrame() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    int frame = g_game->getFrameCount();
+
+    // If our commands are sent to the game after this frame, nothing due can wait any
+    // longer, so we make sure at least one job runs even if it goes over budget. Jobs that
+    // already waited through the last such frame are overdue, and the one that has waited
+    // the longest gets to be that job, so that a job too large for the budget still runs.
+    bool isLastChance = g_game->getRemainingLatencyFrames() <= 1;
+    auto isOverdue = [this, isLastChance](const Entry& entry) {
+        return isLastChance && entry.dueFrame <= m_lastChanceFrame;
+    };
+
+    // Gather the due jobs in the order we want to run them: overdue jobs from the one that
+    // has waited the longest, and then the rest by priority and by how long they waited.
+    m_due.clear();
+    for (int i = 0; i < (int)m_jobs.size(); i++) {
+        if (!m_jobs[i].isRemoved && m_jobs[i].dueFrame <= frame) {
+            m_due.push_back(i);
+        }
+    }
+
+    std::sort(m_due.begin(), m_due.end(), [this, &isOverdue](int a, int b) {
+        const Entry& first = m_jobs[a];
+        const Entry& second = m_jobs[b];
+
+        if (isOverdue(first) != isOverdue(second)) {
+            return isOverdue(first);
+        }
+        if (isOverdue(first) && first.dueFrame != second.dueFrame) {
+            return first.dueFrame < second.dueFrame;
+        }
+        if (first.priority != second.priority) {
+            return first.priority < second.priority;
+        }
+        if (first.dueFrame != second.dueFrame) {
+            return first.dueFrame < second.dueFrame;
+        }
+        return a < b;
+    });
+
+    bool hasRun = false;
+
+    for (int id : m_due) {
+        // An earlier job this frame may have removed this one.
+        if (m_jobs[id].isRemoved) {
+            continue;
+        }
+
+        int elapsed = (int)std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - start).count();
+
+        if (elapsed + m_jobs[id].cost > m_frameBudget && (hasRun || !isLastChance)) {
+            continue;
+        }
+
+        if (m_jobs[id].startFrame < 0) {
+            m_jobs[id].startFrame = frame;
+        }
+
+        // The job may add more jobs, which can move the entries around, so we don't keep
+        // a reference to the entry while it runs.
+        Clock::time_point jobStart = Clock::now();
+        bool isFinished;
+        {
+            Profiler::Scope scope(m_jobs[id].name);
+            isFinished = m_jobs[id].job();
+        }
+        int time = (int)std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - jobStart).count();
+        hasRun = true;
+
+        Entry& entry = m_jobs[id];
+        entry.cost = (entry.cost * 3 + time) / 4;
+
+        if (!isFinished) {
+            continue;
+        }
+
+        // The next run is timed from when this one started, so that jobs which take a few
+        // frames still run at their period on average.
+        if (entry.period == 0) {
+            entry.isRemoved = true;
+        } else {
+            entry.dueFrame = entry.startFrame + entry.period;
+        }
+        entry.startFrame = -1;
+    }
+
+    if (isLastChance) {
+        m_lastChanceFrame = frame;
+    }
+
+    // Removed jobs keep their entries so that identifiers stay valid, but their functions
+    // can be freed.
+    for (Entry& entry : m_jobs) {
+        if (entry.isRemoved && entry.job) {
+            entry.job = nullptr;
+        }
+    }
+}
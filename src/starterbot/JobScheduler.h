@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <functional>
+#include <vector>
+
+// Runs the expensive work of the managers within a time budget for each frame, instead of
+// every manager running its work whenever its own countdown runs out. Jobs are registered
+// with a priority, a period, and an estimate of how long they take, and every frame the
+// scheduler runs the jobs that are due in order of priority for as long as the budget
+// allows, leaving the rest for the following frames.
+//
+// A job is a function that does one slice of work and returns whether it's finished. A
+// job that takes too long to run in one go can do part of its work and return false, in
+// which case it's resumed on a later frame, so long jobs don't cause spikes in frame time.
+//
+// Commands are only sent to the game once every few frames, depending on the latency, so
+// a job that is due can be put off until the last frame before the next send without its
+// commands taking effect any later. The scheduler only goes over budget to make sure a
+// due job makes progress on such a frame, and otherwise leaves jobs that don't fit for
+// later. A job that was already due on the previous such frame is overdue, and the one
+// that has waited the longest is the one that runs first on the next, whatever its cost,
+// so a job whose estimate is larger than the budget can't be put off forever.
+class JobScheduler {
+public:
+    // Does one slice of a job's work, returning true if the job has finished.
+    using Job = std::function<bool()>;
+
+private:
+    struct Entry {
+        const char* name;
+        int priority;
+        int period;
+        Job job;
+
+        // The estimated time of a slice of the job in microseconds, which starts out as
+        // the estimate it was added with and then follows the measured times.
+        int cost;
+
+        // The frame that the job is due to run, and the frame its current run began on if
+        // it has been started but hasn't finished.
+        int dueFrame = 0;
+        int startFrame = -1;
+
+        bool isRemoved = false;
+    };
+
+    // The time in microseconds that jobs are allowed to take per frame.
+    int m_frameBudget;
+
+    // The last frame before commands were sent to the game. Jobs that were due by then
+    // are overdue.
+    int m_lastChanceFrame = -1;
+
+    // Job identifiers are indices into this list and are never reused.
+    std::vector<Entry> m_jobs;
+    std::vector<int> m_due;
+
+public:
+    explicit JobScheduler(int frameBudget);
+
+    void setFrameBudget(int frameBudget);
+    int getFrameBudget() const;
+
+    // Adds a job that runs every period frames, or once if the period is zero, and returns
+    // its identifier. Jobs with lower priority values run first, and the name is used for
+    // profiling, so it must be a string literal. The job is due as soon as it's added.
+    int addJob(const char* name, int priority, int period, int cost, Job job);
+    void removeJob(int id);
+
+    // Makes a job due immediately, such as when something happened that its results
+    // depend on. A job that is in the middle of running is unaffected.
+    void runNow(int id);
+
+    // Prepares for a new game: one-off jobs are dropped, jobs in the middle of running are
+    // abandoned, and all other jobs become due immediately.
+    void reset();
+
+    // Runs the jobs that are due this frame, which should be called once per frame.
+    void runFrame();
+};
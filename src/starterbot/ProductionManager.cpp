@@ -1,7 +1,10 @@
 #include "ProductionManager.h"
 
+#include "Profiler.h"
+
 ProductionManager::ProductionManager(UnitManager& unitManager) :
-    m_unitManager(unitManager) {
+    m_unitManager(unitManager),
+    m_resourceAssigner(unitManager) {
 }
 
 int ProductionManager::freeMinerals() {
@@ -121,8 +124,10 @@ int ProductionManager::countBuildRequests(bw::UnitType type) {
 bool ProductionManager::addTrainRequest(bw::UnitType type, bool morph) {
     // If we don't have enough resources to train this unit given our build requests,
     // don't train anything because that would take away resources from the build requests
-    // and possibly make the building placement fail.
-    if (!hasEnoughResources(type)) {
+    // and possibly make the building placement fail. The same goes for the resources that
+    // are being saved up for the next building of the build plan.
+    if (type.mineralPrice() > freeMinerals() - m_reservedMinerals ||
+            type.gasPrice() > freeGas() - m_reservedGas) {
         return false;
     }
 
@@ -149,7 +154,7 @@ bool ProductionManager::addTrainRequest(bw::UnitType type, bool morph) {
 bool ProductionManager::targetBuildRequests(bw::UnitType type, int count) {
     // Our current fulfillment of the quota includes both existing buildings and build
     // requests for buildings that have not been placed yet.
-    int progress = m_unitManager.selfCount(bw::GetType == type) + countBuildRequests(type);
+    int progress = m_unitManager.typeCount(g_self, type) + countBuildRequests(type);
 
     while (progress < count && addBuildRequest(type)) {
         progress++;
@@ -163,8 +168,8 @@ bool ProductionManager::targetTrainRequests(bw::UnitType type, int count, bool m
     // need to check the build type if the unit if morphing since the unit type might be
     // an egg. We don't check the build type for non-morphing units since that would
     // result in double-counting partially trained units for non-Zerg races.
-    int progress = m_unitManager.selfCount(
-        bw::GetType == type || (bw::BuildType == type && bw::IsMorphing));
+    int progress = m_unitManager.typeCount(g_self, type) +
+        m_unitManager.morphingCount(g_self, type);
 
     while (progress < count && addTrainRequest(type, morph)) {
         progress++;
@@ -208,9 +213,31 @@ void ProductionManager::groupTrainRequests(
     }
 }
 
+void ProductionManager::setBuildGoal(const BuildPlanner::Goal& goal) {
+    // A new goal needs a new plan right away.
+    if (goal != m_goal) {
+        m_goal = goal;
+        m_planFrame = -PLAN_TIME;
+    }
+}
+
+const BuildPlanner::Plan& ProductionManager::getBuildPlan() const {
+    return m_plan;
+}
+
+void ProductionManager::notifyMembers(const bw::Event& event) {
+    m_resourceAssigner.notifyReceiver(event);
+}
+
 void ProductionManager::onStart() {
     m_builders.clear();
     m_trainers.clear();
+
+    m_goal.clear();
+    m_plan = {};
+    m_planFrame = 0;
+    m_reservedMinerals = 0;
+    m_reservedGas = 0;
 }
 
 void ProductionManager::onFrame() {
@@ -223,45 +250,104 @@ void ProductionManager::onFrame() {
     // finished morphing into another unit type.
     m_unitManager.releaseUnits(m_trainers, !bw::IsTraining && !bw::IsMorphing);
 
-    // We base the number of workers who are assigned to gas collection using a proportion
-    // of the total number of workers. We subtract the number of current workers currently
-    // gathering gas in order to get the number of workers who need to be assigned.
-    int workerCount = m_unitManager.borrowCount(bw::IsWorker);
-    int targetGasWorkers = workerCount / 17 -
-        m_unitManager.borrowCount(bw::IsWorker && bw::IsGatheringGas);
-
-    // Borrow as many workers as possible that aren't reserved by any manager and send
-    // them to collect resources if they aren't already doing so.
-    bw::Unitset idleWorkers = m_unitManager.borrowUnits(
-        bw::IsWorker && !bw::IsGatheringMinerals && !bw::IsGatheringGas);
-
-    for (bw::Unit unit : idleWorkers) {
-        bw::Unit resource = nullptr;
-
-        // If we want gas gatherers, find the nearest refinery and decrement the target
-        // number. We want to get the refinery that is closest to the base rather than
-        // closest to the worker since the worker may be far away from the base.
-        if (targetGasWorkers > 0) {
-            resource = g_game->getClosestUnit(
-                bw::Position(g_self->getStartLocation()), bw::IsRefinery);
-            targetGasWorkers--;
+    // Gathering is handled by the resource assigner, which runs before this.
+
+    updatePlan();
+    followPlan();
+}
+
+void ProductionManager::onUnitDestroy(bw::Unit unit) {
+    m_builders.erase(unit);
+    m_trainers.erase(unit);
+}
+
+BuildPlanner::Snapshot ProductionManager::takeSnapshot() {
+    BuildPlanner::Snapshot snapshot;
+    snapshot.frame = g_game->getFrameCount();
+    snapshot.minerals = freeMinerals();
+    snapshot.gas = freeGas();
+    snapshot.supplyUsed = g_self->supplyUsed();
+    snapshot.supplyTotal = g_self->supplyTotal();
+
+    snapshot.patches = m_resourceAssigner.countPatches();
+    snapshot.mineralWorkers = m_resourceAssigner.countMineralWorkers();
+    snapshot.gasWorkers = m_resourceAssigner.countGasWorkers();
+
+    for (bw::Unit unit : g_self->getUnits()) {
+        // Eggs, cocoons, and morphing buildings count as what they're becoming.
+        bw::UnitType type = unit->getType();
+        if (unit->isMorphing() && unit->getBuildType() != bw::UnitTypes::None) {
+            type = unit->getBuildType();
         }
 
-        // If we don't need any more gas gatherers or there are no refineries available,
-        // find the nearest mineral instead. The same distance calculation applies.
-        if (resource == nullptr) {
-            resource = g_game->getClosestUnit(
-                bw::Position(g_self->getStartLocation()), bw::IsMineralField);
+        int remaining = unit->isCompleted() && !unit->isMorphing() ?
+            0 : unit->getRemainingBuildTime();
+        snapshot.units.push_back({ type, remaining, unit->getRemainingTrainTime() });
+    }
+
+    // Buildings that a worker is on its way to place have their resources set aside
+    // already, so they're as good as started.
+    for (bw::Unit builder : m_builders) {
+        bw::UnitType type = builder->getBuildType();
+        if (type != bw::UnitTypes::None && builder->getBuildUnit() == nullptr &&
+                !builder->isMorphing()) {
+            snapshot.units.push_back({ type, type.buildTime(), 0 });
         }
+    }
+
+    return snapshot;
+}
+
+void ProductionManager::updatePlan() {
+    int frame = g_game->getFrameCount();
+    if (frame - m_planFrame < PLAN_TIME) {
+        return;
+    }
+    m_planFrame = frame;
+
+    if (m_goal.empty()) {
+        m_plan = {};
+        return;
+    }
+
+    Profiler::Scope scope("buildPlan");
+    m_plan = m_planner.plan(takeSnapshot(), m_goal);
+}
+
+void ProductionManager::followPlan() {
+    m_reservedMinerals = 0;
+    m_reservedGas = 0;
 
-        // If a suitable resource was found, instruct the worker to gather it.
-        if (resource != nullptr) {
-            unit->gather(resource);
+    // Request the buildings whose time has come. A step that is requested is taken out of
+    // the plan so that it isn't requested again before the next plan.
+    int frame = g_game->getFrameCount();
+    std::vector<BuildPlanner::Step>& steps = m_plan.steps;
+
+    for (auto it = steps.begin(); it != steps.end() && it->startFrame <= frame;) {
+        if (isPlannedBuilding(it->type) && addBuildRequest(it->type)) {
+            it = steps.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // If a building is coming up soon, save up for it. The steps are in the order they
+    // start, so the first building is the one to save for, even if units come before it.
+    for (const BuildPlanner::Step& step : steps) {
+        if (step.startFrame > frame + RESERVE_TIME) {
+            break;
+        }
+
+        if (isPlannedBuilding(step.type)) {
+            m_reservedMinerals = step.type.mineralPrice();
+            m_reservedGas = step.type.gasPrice();
+            break;
         }
     }
 }
 
-void ProductionManager::onUnitDestroy(bw::Unit unit) {
-    m_builders.erase(unit);
-    m_trainers.erase(unit);
-}
\ No newline at end of file
+bool ProductionManager::isPlannedBuilding(bw::UnitType type) const {
+    // The strategy keeps up with supply by itself, so the planner's supply providers are
+    // only there to time the rest of the plan.
+    return type.whatBuilds().first.isWorker() && type != g_self->getRace().getSupplyProvider();
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "BuildPlanner.h"
+#include "ResourceAssigner.h"
 #include "Tools.h"
 #include "UnitManager.h"
 
@@ -8,6 +10,13 @@
 // construction of new buildings.
 class ProductionManager : public EventReceiver {
 private:
+    // The number of frames between plans for the build goal, which is short enough that
+    // the plan keeps up with what actually happens in the game.
+    static constexpr int PLAN_TIME = 8;
+
+    // How far ahead of a planned building its resources are set aside.
+    static constexpr int RESERVE_TIME = 120;
+
     UnitManager& m_unitManager;
 
     // The set of workers that are reserved to build a building or morph into another
@@ -19,6 +28,19 @@ private:
     // units that are morphing into a non-building type.
     bw::Unitset m_trainers;
 
+    // Sends the workers that aren't reserved by any manager to gather resources.
+    ResourceAssigner m_resourceAssigner;
+
+    BuildPlanner m_planner;
+    BuildPlanner::Goal m_goal;
+    BuildPlanner::Plan m_plan;
+    int m_planFrame = 0;
+
+    // The resources set aside for the next building of the plan, which train requests
+    // aren't allowed to use.
+    int m_reservedMinerals = 0;
+    int m_reservedGas = 0;
+
 public:
     ProductionManager(UnitManager& unitManager);
 
@@ -62,8 +84,27 @@ public:
     // the same basic building or morphable unit.
     void groupTrainRequests(const std::vector<std::pair<bw::UnitType, double>>& items, bool morph);
 
+    // Sets the units that should exist, which are planned for together by the build
+    // planner. The buildings of the plan are requested when the plan says to start them,
+    // and their resources are saved up beforehand. Units in the plan are left to the train
+    // requests, so the goal mostly serves to plan the buildings around the army.
+    void setBuildGoal(const BuildPlanner::Goal& goal);
+    const BuildPlanner::Plan& getBuildPlan() const;
+
 protected:
+    virtual void notifyMembers(const bw::Event& event) override;
+
     virtual void onStart() override;
     virtual void onFrame() override;
     virtual void onUnitDestroy(bw::Unit unit) override;
+
+private:
+    // Collects what the build planner needs to know about the game.
+    BuildPlanner::Snapshot takeSnapshot();
+
+    void updatePlan();
+    void followPlan();
+
+    // Whether a step of the plan is a building that the plan requests and saves up for.
+    bool isPlannedBuilding(bw::UnitType type) const;
 };
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+Profiler g_profiler;
+
+// Gets a readable name for a type, which the compilers don't agree on for type_info.
+static std::string getTypeName(const std::type_info& type) {
+#ifdef __GNUG__
+    int status = 0;
+    char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0) {
+        std::string result = name;
+        std::free(name);
+        return result;
+    }
+    return type.name();
+#else
+    // MSVC gives names like "class CombatManager", so we just drop the first word.
+    std::string name = type.name();
+    size_t space = name.find(' ');
+    return space == std::string::npos ? name : name.substr(space + 1);
+#endif
+}
+
+static double toMicroseconds(int64_t nanoseconds) {
+    return std::round(nanoseconds / 100.0) / 10.0;
+}
+
+void Profiler::Histogram::add(int64_t value) {
+    if (m_buckets.empty()) {
+        m_buckets.resize(NUM_BUCKETS, 0);
+    }
+
+    m_buckets[getBucket(value)]++;
+    m_count++;
+    m_total += value;
+    m_max = std::max(m_max, value);
+}
+
+int64_t Profiler::Histogram::getPercentile(double fraction) const {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    int64_t target = std::max((int64_t)std::ceil(fraction * m_count), (int64_t)1);
+    int64_t seen = 0;
+
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += m_buckets[i];
+        if (seen >= target) {
+            return std::min(getBucketLimit(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+int Profiler::Histogram::getBucket(int64_t value) {
+    // Small values get a bucket each. After that, the bucket is chosen by the position of
+    // the highest bit and the SUB_BITS bits after it.
+    if (value < (1 << SUB_BITS)) {
+        return (int)std::max(value, (int64_t)0);
+    }
+
+    int exponent = std::bit_width((uint64_t)value) - 1;
+    int mantissa = (int)(value >> (exponent - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+    return ((exponent - SUB_BITS + 1) << SUB_BITS) + mantissa;
+}
+
+int64_t Profiler::Histogram::getBucketLimit(int bucket) {
+    if (bucket < (1 << SUB_BITS)) {
+        return bucket;
+    }
+
+    int exponent = (bucket >> SUB_BITS) + SUB_BITS - 1;
+    int64_t mantissa = bucket & ((1 << SUB_BITS) - 1);
+    int64_t width = (int64_t)1 << (exponent - SUB_BITS);
+    return (((int64_t)(1 << SUB_BITS) + mantissa) << (exponent - SUB_BITS)) + width - 1;
+}
+
+Profiler::Scope::Scope(const void* object, const std::type_info& type) {
+    if (g_profiler.isTiming()) {
+        m_profiler = &g_profiler;
+        m_profiler->enter(object, nullptr, &type);
+        m_start = Clock::now();
+    }
+}
+
+Profiler::Scope::Scope(const char* name) {
+    if (g_profiler.isTiming()) {
+        m_profiler = &g_profiler;
+        m_profiler->enter(name, name, nullptr);
+        m_start = Clock::now();
+    }
+}
+
+Profiler::Scope::~Scope() {
+    if (m_profiler != nullptr) {
+        m_profiler->leave(m_start);
+    }
+}
+
+void Profiler::setEnabled(bool isEnabled) {
+    m_isEnabled = isEnabled;
+}
+
+bool Profiler::isEnabled() const {
+    return m_isEnabled;
+}
+
+void Profiler::setFrameBudget(int budget) {
+    m_frameBudget = budget;
+}
+
+int Profiler::getFrameBudget() const {
+    return m_frameBudget;
+}
+
+void Profiler::reset() {
+    m_thread = std::this_thread::get_id();
+
+    m_nodes.clear();
+    m_nodes.emplace_back("frame", -1);
+    m_current = 0;
+
+    m_isInFrame = false;
+    m_overruns = 0;
+}
+
+void Profiler::beginFrame() {
+    if (!m_isEnabled || m_nodes.empty()) {
+        return;
+    }
+
+    m_isInFrame = true;
+    m_current = 0;
+    m_frameStart = Clock::now();
+}
+
+void Profiler::endFrame() {
+    if (!m_isInFrame) {
+        return;
+    }
+    m_isInFrame = false;
+
+    int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - m_frameStart).count();
+
+    Node& root = m_nodes[0];
+    root.frameTime = time;
+    root.calls++;
+
+    if (m_frameBudget > 0 && time > (int64_t)m_frameBudget * 1000) {
+        m_overruns++;
+    }
+
+    // Only the nodes that were entered this frame get a sample, so that the percentiles
+    // of rare events aren't dragged down by all the frames where they didn't happen.
+    for (Node& node : m_nodes) {
+        if (node.frameTime > 0) {
+            node.frames.add(node.frameTime);
+            node.frameTime = 0;
+        }
+    }
+}
+
+void Profiler::write(std::ostream& out) const {
+    out << "{\n";
+    out << "  \"frameBudget\": " << m_frameBudget << ",\n";
+    out << "  \"overruns\": " << m_overruns << ",\n";
+    out << "  \"nodes\": [";
+
+    for (int i = 0; i < (int)m_nodes.size(); i++) {
+        const Node& node = m_nodes[i];
+        const Histogram& frames = node.frames;
+
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"path\": \"" << getPath(i) << "\""
+            << ", \"calls\": " << node.calls
+            << ", \"frames\": " << frames.getCount()
+            << ", \"total\": " << toMicroseconds(frames.getTotal())
+            << ", \"p50\": " << toMicroseconds(frames.getPercentile(0.50))
+            << ", \"p95\": " << toMicroseconds(frames.getPercentile(0.95))
+            << ", \"p99\": " << toMicroseconds(frames.getPercentile(0.99))
+            << ", \"max\": " << toMicroseconds(frames.getMax()) << "}";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+bool Profiler::isTiming() const {
+    return m_isEnabled && m_isInFrame && std::this_thread::get_id() == m_thread;
+}
+
+void Profiler::enter(const void* key, const char* name, const std::type_info* type) {
+    Node& current = m_nodes[m_current];
+
+    auto it = std::find_if(current.children.begin(), current.children.end(),
+        [key](const std::pair<const void*, int>& child) { return child.first == key; });
+
+    if (it != current.children.end()) {
+        m_current = it->second;
+    } else {
+        // Adding the node may move the nodes around, so we can't use current after this.
+        int index = (int)m_nodes.size();
+        current.children.emplace_back(key, index);
+
+        m_nodes.emplace_back(type != nullptr ? getTypeName(*type) : name, m_current);
+        m_current = index;
+    }
+}
+
+void Profiler::leave(Clock::time_point start) {
+    Node& node = m_nodes[m_current];
+
+    node.frameTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start).count();
+    node.calls++;
+
+    m_current = node.parent;
+}
+
+std::string Profiler::getPath(int node) const {
+    // The root is left out of the paths of the other nodes, which start at the top-level
+    // event receiver.
+    if (node == 0 || m_nodes[node].parent <= 0) {
+        return m_nodes[node].name;
+    }
+    return getPath(m_nodes[node].parent) + "/" + m_nodes[node].name;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Measures how much time each part of the bot takes per frame. Time is recorded in a tree
+// of scopes that mirrors how events are passed down through the event receivers, so each
+// receiver gets a node for itself with nodes for its members and for each of its event
+// handlers underneath. The time a node takes within each frame is added to a histogram,
+// from which percentiles can be read out at the end of the game, and whole frames that
+// take longer than the frame budget are counted as overruns.
+//
+// When the profiler is disabled, a scope costs a single check, so the scopes can stay in
+// place permanently. Only the thread that last called reset() is timed, since other
+// threads could otherwise mess up the tree.
+class Profiler {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // A histogram of times in nanoseconds, with buckets that grow exponentially so that
+    // the error of a percentile is the same fraction of the time no matter how large it is.
+    // Each power of two is split into 2^SUB_BITS buckets.
+    class Histogram {
+    private:
+        static constexpr int SUB_BITS = 3;
+        static constexpr int NUM_BUCKETS = 64 << SUB_BITS;
+
+        std::vector<uint32_t> m_buckets;
+        int64_t m_count = 0;
+        int64_t m_total = 0;
+        int64_t m_max = 0;
+
+    public:
+        void add(int64_t value);
+
+        int64_t getCount() const { return m_count; }
+        int64_t getTotal() const { return m_total; }
+        int64_t getMax() const { return m_max; }
+
+        // Gets an upper bound on the time that the given fraction of samples take at most.
+        int64_t getPercentile(double fraction) const;
+
+    private:
+        static int getBucket(int64_t value);
+        static int64_t getBucketLimit(int bucket);
+    };
+
+    struct Node {
+        std::string name;
+        int parent;
+
+        // The children of the node, looked up by the key of the scope that created them.
+        std::vector<std::pair<const void*, int>> children;
+
+        // The time spent in the node during the current frame and the number of times it
+        // was entered over the whole game, along with the per-frame times so far.
+        int64_t frameTime = 0;
+        int64_t calls = 0;
+        Histogram frames;
+
+        Node(std::string name, int parent) :
+            name(std::move(name)),
+            parent(parent) {}
+    };
+
+    bool m_isEnabled = false;
+    int m_frameBudget = 0;
+    std::thread::id m_thread;
+
+    // Node 0 is the root, which holds the time of whole frames.
+    std::vector<Node> m_nodes;
+    int m_current = 0;
+
+    Clock::time_point m_frameStart;
+    bool m_isInFrame = false;
+    int m_overruns = 0;
+
+public:
+    // Times the code from where it's created until the end of the enclosing block as a
+    // child of the innermost enclosing scope.
+    class Scope {
+    private:
+        Profiler* m_profiler = nullptr;
+        Clock::time_point m_start;
+
+    public:
+        // Creates a scope named after the type of an object, like an event receiver, which
+        // is looked up by the address of the object.
+        Scope(const void* object, const std::type_info& type);
+        // Creates a scope with a fixed name, which must be a string literal since it's also
+        // used to look up the scope.
+        Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    void setEnabled(bool isEnabled);
+    bool isEnabled() const;
+
+    // Frames that take longer than the budget in microseconds are counted as overruns. A
+    // budget of zero or less disables counting.
+    void setFrameBudget(int budget);
+    int getFrameBudget() const;
+
+    // Removes all measurements in preparation for a new game.
+    void reset();
+
+    // Marks the start and end of a frame, in between which all the events for the frame
+    // are handled.
+    void beginFrame();
+    void endFrame();
+
+    // Writes every measurement as JSON, with an entry for each node containing the path
+    // of the node and its statistics in microseconds.
+    void write(std::ostream& out) const;
+
+private:
+    bool isTiming() const;
+
+    void enter(const void* key, const char* name, const std::type_info* type);
+    void leave(Clock::time_point start);
+
+    std::string getPath(int node) const;
+};
+
+extern Profiler g_profiler;
@@ -0,0 +1,295 @@
+#include "ResourceAssigner.h"
+
+#include <algorithm>
+#include <climits>
+
+ResourceAssigner::ResourceAssigner(UnitManager& unitManager) :
+    m_unitManager(unitManager) {
+}
+
+bw::Unit ResourceAssigner::getAssignment(bw::Unit worker) const {
+    auto it = m_assignments.find(worker);
+    return it != m_assignments.end() ? it->second.resource : nullptr;
+}
+
+int ResourceAssigner::getWorkerCount(bw::Unit resource) const {
+    auto it = m_resources.find(resource);
+    return it != m_resources.end() ? it->second.workers : 0;
+}
+
+int ResourceAssigner::countPatches() const {
+    int patches = 0;
+    for (const auto& [unit, resource] : m_resources) {
+        patches += !resource.isRefinery;
+    }
+    return patches;
+}
+
+int ResourceAssigner::countMineralWorkers() const {
+    int workers = 0;
+    for (const auto& [unit, resource] : m_resources) {
+        if (!resource.isRefinery) {
+            workers += resource.workers;
+        }
+    }
+    return workers;
+}
+
+int ResourceAssigner::countGasWorkers() const {
+    int workers = 0;
+    for (const auto& [unit, resource] : m_resources) {
+        if (resource.isRefinery) {
+            workers += resource.workers;
+        }
+    }
+    return workers;
+}
+
+void ResourceAssigner::onStart() {
+    m_bases.clear();
+    m_resources.clear();
+    m_assignments.clear();
+
+    // The depot we start with may have been completed before we were told about it.
+    for (bw::Unit unit : g_self->getUnits()) {
+        if (unit->getType().isResourceDepot() && unit->isCompleted()) {
+            addBase(unit);
+        }
+    }
+}
+
+void ResourceAssigner::onFrame() {
+    // Workers that have been reserved by another manager or have died are no longer ours
+    // to assign, so free up their resources.
+    for (auto it = m_assignments.begin(); it != m_assignments.end();) {
+        bw::Unit worker = it->first;
+        ++it;
+
+        if (!m_unitManager.isFree(worker)) {
+            unassign(worker);
+        }
+    }
+
+    int frame = g_game->getFrameCount();
+
+    for (bw::Unit worker : m_unitManager.borrowUnits(bw::IsWorker)) {
+        bool isNew = false;
+        if (!m_assignments.contains(worker)) {
+            bw::Unit resource = chooseResource(worker);
+            if (resource == nullptr) {
+                continue;
+            }
+            assign(worker, resource);
+            isNew = true;
+        }
+
+        Assignment& assignment = m_assignments.at(worker);
+        bw::Unit resource = assignment.resource;
+
+        // A worker that is carrying something brings it back before returning to its
+        // resource by itself, so we only step in if it has stopped. A newly assigned worker
+        // is sent to its resource straight away, but one that the game moved to another
+        // patch is only sent back if it stays there.
+        if (worker->isCarryingMinerals() || worker->isCarryingGas()) {
+            if (worker->isIdle()) {
+                worker->returnCargo();
+            }
+        } else if (isNew || worker->isIdle()) {
+            worker->gather(resource);
+            assignment.elsewhereSince = -1;
+        } else if (worker->getTarget() == resource || worker->getOrderTarget() == resource) {
+            assignment.elsewhereSince = -1;
+        } else if (assignment.elsewhereSince < 0) {
+            assignment.elsewhereSince = frame;
+        } else if (frame - assignment.elsewhereSince >= RETARGET_FRAMES) {
+            worker->gather(resource);
+            assignment.elsewhereSince = -1;
+        }
+    }
+}
+
+void ResourceAssigner::onUnitComplete(bw::Unit unit) {
+    if (unit->getPlayer() != g_self) {
+        return;
+    }
+
+    if (unit->getType().isResourceDepot()) {
+        addBase(unit);
+    } else if (unit->getType().isRefinery()) {
+        addRefinery(unit);
+    }
+}
+
+void ResourceAssigner::onUnitDestroy(bw::Unit unit) {
+    // A mined out patch is destroyed, as are our depots and refineries when they're
+    // killed, so they all end up here.
+    removeResource(unit);
+
+    for (int i = 0; i < (int)m_bases.size(); i++) {
+        if (m_bases[i].depot == unit) {
+            for (bw::Unit resource : std::vector<bw::Unit>(m_bases[i].resources)) {
+                removeResource(resource);
+            }
+            m_bases[i].depot = nullptr;
+        }
+    }
+
+    if (m_assignments.contains(unit)) {
+        unassign(unit);
+    }
+}
+
+void ResourceAssigner::onUnitRenegade(bw::Unit unit) {
+    // A refinery changes owner when it's placed on a geyser, and again if it's destroyed,
+    // so that's when we find out it's no longer ours.
+    if (unit->getPlayer() != g_self) {
+        removeResource(unit);
+    }
+}
+
+void ResourceAssigner::addBase(bw::Unit depot) {
+    for (const Base& base : m_bases) {
+        if (base.depot == depot) {
+            return;
+        }
+    }
+
+    int index = (int)m_bases.size();
+    m_bases.push_back({ depot, {} });
+
+    for (bw::Unit unit : g_game->getUnitsInRadius(depot->getPosition(), BASE_RADIUS)) {
+        if (unit->getType().isMineralField() ||
+                (unit->getType().isRefinery() && unit->getPlayer() == g_self && unit->isCompleted())) {
+            addResource(index, unit);
+        }
+    }
+
+    releaseExtraWorkers();
+}
+
+void ResourceAssigner::addResource(int base, bw::Unit resource) {
+    // A patch between two bases belongs to whichever base claimed it first.
+    if (m_resources.contains(resource)) {
+        return;
+    }
+
+    // The distance is measured between the edges of the two units, which is about how
+    // far a worker travels on each trip.
+    bw::Unit depot = m_bases[base].depot;
+    m_resources[resource] = { base, depot->getDistance(resource), resource->getType().isRefinery() };
+
+    std::vector<bw::Unit>& resources = m_bases[base].resources;
+    auto it = std::find_if(resources.begin(), resources.end(), [&](bw::Unit other) {
+        return m_resources[other].distance > m_resources[resource].distance;
+    });
+    resources.insert(it, resource);
+}
+
+void ResourceAssigner::addRefinery(bw::Unit refinery) {
+    for (int i = 0; i < (int)m_bases.size(); i++) {
+        if (m_bases[i].depot != nullptr &&
+                m_bases[i].depot->getDistance(refinery) <= BASE_RADIUS) {
+            addResource(i, refinery);
+            releaseExtraWorkers();
+            return;
+        }
+    }
+}
+
+void ResourceAssigner::removeResource(bw::Unit resource) {
+    auto it = m_resources.find(resource);
+    if (it == m_resources.end()) {
+        return;
+    }
+
+    if (it->second.workers > 0) {
+        for (auto assignment = m_assignments.begin(); assignment != m_assignments.end();) {
+            if (assignment->second.resource == resource) {
+                assignment = m_assignments.erase(assignment);
+            } else {
+                ++assignment;
+            }
+        }
+    }
+
+    std::vector<bw::Unit>& resources = m_bases[it->second.base].resources;
+    resources.erase(std::remove(resources.begin(), resources.end(), resource), resources.end());
+
+    m_resources.erase(it);
+}
+
+void ResourceAssigner::releaseExtraWorkers() {
+    for (auto it = m_assignments.begin(); it != m_assignments.end();) {
+        bw::Unit worker = it->first;
+        const Resource& resource = m_resources[it->second.resource];
+        ++it;
+
+        if (!resource.isRefinery && resource.workers >= PATCH_WORKERS) {
+            unassign(worker);
+        }
+    }
+}
+
+bw::Unit ResourceAssigner::chooseResource(bw::Unit worker) const {
+    bw::Unit best = nullptr;
+    int bestStep = INT_MAX;
+    int bestDistance = INT_MAX;
+
+    for (const Base& base : m_bases) {
+        if (base.depot == nullptr) {
+            continue;
+        }
+
+        // The resources are sorted by distance, so the first one with the lowest step is
+        // the best this base has to offer.
+        bw::Unit choice = nullptr;
+        int step = INT_MAX;
+        for (bw::Unit resource : base.resources) {
+            int resourceStep = getStep(m_resources.at(resource));
+            if (resourceStep >= 0 && resourceStep < step) {
+                choice = resource;
+                step = resourceStep;
+            }
+        }
+
+        int distance = worker->getDistance(base.depot);
+        if (choice != nullptr && (step < bestStep || (step == bestStep && distance < bestDistance))) {
+            best = choice;
+            bestStep = step;
+            bestDistance = distance;
+        }
+    }
+
+    return best;
+}
+
+int ResourceAssigner::getStep(const Resource& resource) const {
+    if (resource.isRefinery) {
+        return resource.workers < REFINERY_WORKERS ? 1 : -1;
+    }
+
+    // The first worker on a patch is step 0, and the second and third are steps 2 and 3,
+    // leaving step 1 for refineries.
+    if (resource.workers >= PATCH_WORKERS) {
+        return -1;
+    }
+    return resource.workers == 0 ? 0 : resource.workers + 1;
+}
+
+void ResourceAssigner::assign(bw::Unit worker, bw::Unit resource) {
+    m_assignments[worker] = { resource };
+    m_resources[resource].workers++;
+}
+
+void ResourceAssigner::unassign(bw::Unit worker) {
+    auto it = m_assignments.find(worker);
+    if (it == m_assignments.end()) {
+        return;
+    }
+
+    auto resource = m_resources.find(it->second.resource);
+    if (resource != m_resources.end()) {
+        resource->second.workers--;
+    }
+    m_assignments.erase(it);
+}
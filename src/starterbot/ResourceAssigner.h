@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Tools.h"
+#include "UnitManager.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Assigns the player's free workers to the mineral patches and refineries of its bases so
+// that every base is saturated evenly, rather than sending every worker to the patch
+// closest to the start location. When a resource depot finishes, the minerals around it
+// are found and sorted by their distance from the depot once, and every resource keeps a
+// count of the workers assigned to it, so assigning a worker only looks at the handful of
+// resources of each base. Workers keep their resource until it runs out, the base is lost,
+// or another manager reserves them.
+//
+// The game moves a worker to a free patch nearby when its own is busy, so a worker is only
+// sent back to its resource once it has worked elsewhere for RETARGET_FRAMES. Ordering it
+// back every frame would restart its trip each time the game switched patches.
+//
+// Workers are handed out in the order that they add the most income: first one worker on
+// every mineral patch, then every refinery up to REFINERY_WORKERS, then a second worker on
+// every patch, and finally a third, which adds little since the patch is already being
+// mined most of the time. Within each step, patches closer to the depot are filled first,
+// and among bases, the one closest to the worker.
+class ResourceAssigner : public EventReceiver {
+private:
+    // Minerals and refineries within this distance of a depot belong to its base.
+    static constexpr int BASE_RADIUS = 320;
+
+    // The most workers that are assigned to each kind of resource.
+    static constexpr int PATCH_WORKERS = 3;
+    static constexpr int REFINERY_WORKERS = 3;
+
+    // How long a worker may work on a resource other than its own before it is sent back.
+    static constexpr int RETARGET_FRAMES = 48;
+
+    struct Resource {
+        int base;
+        int distance;
+        bool isRefinery;
+        int workers = 0;
+    };
+
+    struct Base {
+        // The depot of the base, or nullptr if the base has been lost. Lost bases keep
+        // their place so that the indices of the other bases stay the same.
+        bw::Unit depot;
+
+        // The resources of the base, sorted by their distance from the depot.
+        std::vector<bw::Unit> resources;
+    };
+
+    UnitManager& m_unitManager;
+
+    std::vector<Base> m_bases;
+    std::unordered_map<bw::Unit, Resource> m_resources;
+
+    struct Assignment {
+        bw::Unit resource;
+
+        // The frame since which the worker has been working elsewhere, or -1 if it is
+        // working on its own resource.
+        int elsewhereSince = -1;
+    };
+
+    // The resource that each worker is assigned to.
+    std::unordered_map<bw::Unit, Assignment> m_assignments;
+
+public:
+    ResourceAssigner(UnitManager& unitManager);
+
+    // Gets the resource a worker is assigned to, or nullptr if it isn't assigned to one.
+    bw::Unit getAssignment(bw::Unit worker) const;
+
+    // Gets the number of workers assigned to a mineral patch or refinery.
+    int getWorkerCount(bw::Unit resource) const;
+
+    // Counts the mineral patches of our bases, and the workers assigned to minerals and
+    // to gas, from which the income can be forecast.
+    int countPatches() const;
+    int countMineralWorkers() const;
+    int countGasWorkers() const;
+
+protected:
+    virtual void onStart() override;
+    virtual void onFrame() override;
+    virtual void onUnitComplete(bw::Unit unit) override;
+    virtual void onUnitDestroy(bw::Unit unit) override;
+    virtual void onUnitRenegade(bw::Unit unit) override;
+
+private:
+    void addBase(bw::Unit depot);
+    void addResource(int base, bw::Unit resource);
+    void addRefinery(bw::Unit refinery);
+
+    // Removes a resource and frees up its workers to be assigned elsewhere.
+    void removeResource(bw::Unit resource);
+
+    // Unassigns every worker that is the third on its patch, which happens when a new
+    // base or refinery gives them a better place to go.
+    void releaseExtraWorkers();
+
+    // Finds the resource that a worker would add the most income at, or nullptr if every
+    // resource is full.
+    bw::Unit chooseResource(bw::Unit worker) const;
+
+    // The step in which a resource gets its next worker, where lower steps are filled
+    // first, or -1 if the resource is full.
+    int getStep(const Resource& resource) const;
+
+    void assign(bw::Unit worker, bw::Unit resource);
+    void unassign(bw::Unit worker);
+};
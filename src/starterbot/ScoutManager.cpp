@@ -34,14 +34,29 @@ void ScoutManager::onFrame() {
             continue;
         }
 
-        // Otherwise, find the first potential start location that is not yet explored and
-        // send the scout to explore it.
+        // Otherwise, find the closest potential start location by ground that is not yet
+        // explored and send the scout to explore it. If none of them can be reached by
+        // ground, the first unexplored one is used instead.
+        bw::Position target = bw::Positions::None;
+        int minDistance = INT_MAX;
+
         for (bw::TilePosition pos : g_game->getStartLocations()) {
-            if (!g_game->isExplored(pos)) {
-                scout->move(bw::Position(pos));
-                break;
+            if (g_game->isExplored(pos)) {
+                continue;
+            }
+
+            int distance = g_game->getGroundDistance(scout->getPosition(), bw::Position(pos));
+            if (distance >= 0 && distance < minDistance) {
+                target = bw::Position(pos);
+                minDistance = distance;
+            } else if (target == bw::Positions::None) {
+                target = bw::Position(pos);
             }
         }
+
+        if (target != bw::Positions::None) {
+            scout->move(target);
+        }
     }
 }
 
@@ -0,0 +1,313 @@
+#include "ShadowStore.h"
+#include "ShadowUnit.h"
+
+#include <BWAPI/Client.h>
+
+#include <algorithm>
+#include <span>
+
+void ShadowStore::clear() {
+    m_real.clear();
+    m_views.clear();
+    m_live.clear();
+
+    m_player.clear();
+    m_type.clear();
+    m_position.clear();
+    m_angle.clear();
+    m_velocityX.clear();
+    m_velocityY.clear();
+    m_hitPoints.clear();
+    m_shields.clear();
+    m_energy.clear();
+    m_groundWeaponCooldown.clear();
+    m_airWeaponCooldown.clear();
+    m_spellCooldown.clear();
+    m_flags.clear();
+    m_cold.clear();
+
+    m_dirty.clear();
+    m_dirtyRows.clear();
+    m_dirtyFrame = -1;
+
+    m_history.clear();
+    m_historyNext.clear();
+    m_historyCount.clear();
+
+    m_freeRows.clear();
+}
+
+bw::Unit ShadowStore::getUnit(int row) const {
+    return m_views[row];
+}
+
+void ShadowStore::update(int row) {
+    bw::Unit real = m_real[row];
+
+    assign(row, m_player[row],               real->getPlayer(),               DirtyPlayer);
+    assign(row, m_type[row],                 real->getType(),                 DirtyType);
+    assign(row, m_position[row],             real->getPosition(),             DirtyPosition);
+    assign(row, m_angle[row],                real->getAngle(),                DirtyPosition);
+    assign(row, m_velocityX[row],            real->getVelocityX(),            DirtyPosition);
+    assign(row, m_velocityY[row],            real->getVelocityY(),            DirtyPosition);
+    assign(row, m_hitPoints[row],            real->getHitPoints(),            DirtyHealth);
+    assign(row, m_shields[row],              real->getShields(),              DirtyHealth);
+    assign(row, m_energy[row],               real->getEnergy(),               DirtyHealth);
+    assign(row, m_groundWeaponCooldown[row], real->getGroundWeaponCooldown(), DirtyCooldown);
+    assign(row, m_airWeaponCooldown[row],    real->getAirWeaponCooldown(),    DirtyCooldown);
+    assign(row, m_spellCooldown[row],        real->getSpellCooldown(),        DirtyCooldown);
+
+    // Build up the whole flag word before storing it so that it's only compared once.
+    uint64_t flags = 0;
+    flags |= real->hasNuke()              ? HasNuke              : 0;
+    flags |= real->isAccelerating()       ? IsAccelerating       : 0;
+    flags |= real->isAttacking()          ? IsAttacking          : 0;
+    flags |= real->isAttackFrame()        ? IsAttackFrame        : 0;
+    flags |= real->isBeingGathered()      ? IsBeingGathered      : 0;
+    flags |= real->isBeingHealed()        ? IsBeingHealed        : 0;
+    flags |= real->isBlind()              ? IsBlind              : 0;
+    flags |= real->isBraking()            ? IsBraking            : 0;
+    flags |= real->isBurrowed()           ? IsBurrowed           : 0;
+    flags |= real->isCarryingGas()        ? IsCarryingGas        : 0;
+    flags |= real->isCarryingMinerals()   ? IsCarryingMinerals   : 0;
+    flags |= real->isCloaked()            ? IsCloaked            : 0;
+    flags |= real->isCompleted()          ? IsCompleted          : 0;
+    flags |= real->isConstructing()       ? IsConstructing       : 0;
+    flags |= real->isDetected()           ? IsDetected           : 0;
+    flags |= real->isGatheringGas()       ? IsGatheringGas       : 0;
+    flags |= real->isGatheringMinerals()  ? IsGatheringMinerals  : 0;
+    flags |= real->isHallucination()      ? IsHallucination      : 0;
+    flags |= real->isIdle()               ? IsIdle               : 0;
+    flags |= real->isInterruptible()      ? IsInterruptible      : 0;
+    flags |= real->isInvincible()         ? IsInvincible         : 0;
+    flags |= real->isLifted()             ? IsLifted             : 0;
+    flags |= real->isMorphing()           ? IsMorphing           : 0;
+    flags |= real->isMoving()             ? IsMoving             : 0;
+    flags |= real->isParasited()          ? IsParasited          : 0;
+    flags |= real->isSelected()           ? IsSelected           : 0;
+    flags |= real->isStartingAttack()     ? IsStartingAttack     : 0;
+    flags |= real->isStuck()              ? IsStuck              : 0;
+    flags |= real->isTraining()           ? IsTraining           : 0;
+    flags |= real->isUnderAttack()        ? IsUnderAttack        : 0;
+    flags |= real->isUnderDarkSwarm()     ? IsUnderDarkSwarm     : 0;
+    flags |= real->isUnderDisruptionWeb() ? IsUnderDisruptionWeb : 0;
+    flags |= real->isUnderStorm()         ? IsUnderStorm         : 0;
+    flags |= real->isPowered()            ? IsPowered            : 0;
+    flags |= real->isTargetable()         ? IsTargetable         : 0;
+    assign(row, m_flags[row], flags, DirtyFlags);
+
+    // The cold fields are compared and assigned in place like the others, so that the
+    // training queue and unit sets are only copied on the rare frames when they change.
+    const bw::UnitImpl* impl = static_cast<const bw::UnitImpl*>(real);
+    ColdFields& cold = m_cold[row];
+
+    assign(row, cold.resources,              real->getResources(),             DirtyCold);
+    assign(row, cold.resourceGroup,          real->getResourceGroup(),         DirtyCold);
+    assign(row, cold.lastCommandFrame,       real->getLastCommandFrame(),      DirtyCold);
+    assign(row, cold.lastCommand,            real->getLastCommand(),           DirtyCold);
+    assign(row, cold.lastAttackingPlayer,    real->getLastAttackingPlayer(),   DirtyCold);
+    assign(row, cold.killCount,              real->getKillCount(),             DirtyCold);
+    assign(row, cold.acidSporeCount,         real->getAcidSporeCount(),        DirtyCold);
+    assign(row, cold.interceptorCount,       real->getInterceptorCount(),      DirtyCold);
+    assign(row, cold.scarabCount,            real->getScarabCount(),           DirtyCold);
+    assign(row, cold.spiderMineCount,        real->getSpiderMineCount(),       DirtyCold);
+    assign(row, cold.defenseMatrixPoints,    real->getDefenseMatrixPoints(),   DirtyCold);
+    assign(row, cold.defenseMatrixTimer,     real->getDefenseMatrixTimer(),    DirtyCold);
+    assign(row, cold.ensnareTimer,           real->getEnsnareTimer(),          DirtyCold);
+    assign(row, cold.irradiateTimer,         real->getIrradiateTimer(),        DirtyCold);
+    assign(row, cold.lockdownTimer,          real->getLockdownTimer(),         DirtyCold);
+    assign(row, cold.maelstromTimer,         real->getMaelstromTimer(),        DirtyCold);
+    assign(row, cold.orderTimer,             real->getOrderTimer(),            DirtyCold);
+    assign(row, cold.plagueTimer,            real->getPlagueTimer(),           DirtyCold);
+    assign(row, cold.removeTimer,            real->getRemoveTimer(),           DirtyCold);
+    assign(row, cold.stasisTimer,            real->getStasisTimer(),           DirtyCold);
+    assign(row, cold.stimTimer,              real->getStimTimer(),             DirtyCold);
+    assign(row, cold.buildType,              real->getBuildType(),             DirtyCold);
+    assign(row, cold.tech,                   real->getTech(),                  DirtyCold);
+    assign(row, cold.upgrade,                real->getUpgrade(),               DirtyCold);
+    assign(row, cold.remainingBuildTime,     real->getRemainingBuildTime(),    DirtyCold);
+    assign(row, cold.remainingTrainTime,     real->getRemainingTrainTime(),    DirtyCold);
+    assign(row, cold.remainingResearchTime,  real->getRemainingResearchTime(), DirtyCold);
+    assign(row, cold.remainingUpgradeTime,   real->getRemainingUpgradeTime(),  DirtyCold);
+    assign(row, cold.buildUnit,              real->getBuildUnit(),             DirtyCold);
+    assign(row, cold.target,                 real->getTarget(),                DirtyCold);
+    assign(row, cold.targetPosition,         real->getTargetPosition(),        DirtyCold);
+    assign(row, cold.order,                  real->getOrder(),                 DirtyCold);
+    assign(row, cold.secondaryOrder,         real->getSecondaryOrder(),        DirtyCold);
+    assign(row, cold.orderTarget,            real->getOrderTarget(),           DirtyCold);
+    assign(row, cold.orderTargetPosition,    real->getOrderTargetPosition(),   DirtyCold);
+    assign(row, cold.rallyPosition,          real->getRallyPosition(),         DirtyCold);
+    assign(row, cold.rallyUnit,              real->getRallyUnit(),             DirtyCold);
+    assign(row, cold.addon,                  real->getAddon(),                 DirtyCold);
+    assign(row, cold.nydusExit,              real->getNydusExit(),             DirtyCold);
+    assign(row, cold.powerUp,                real->getPowerUp(),               DirtyCold);
+    assign(row, cold.transport,              real->getTransport(),             DirtyCold);
+    assign(row, cold.loadedUnits,            impl->getLoadedUnitsView(),       DirtyCold);
+    assign(row, cold.carrier,                real->getCarrier(),               DirtyCold);
+    assign(row, cold.interceptors,           impl->getInterceptorsView(),      DirtyCold);
+    assign(row, cold.hatchery,               real->getHatchery(),              DirtyCold);
+    assign(row, cold.larva,                  impl->getLarvaView(),             DirtyCold);
+
+    std::span<const bw::UnitType> queue = impl->getTrainingQueueView();
+    if (!std::ranges::equal(cold.trainingQueue, queue)) {
+        cold.trainingQueue.assign(queue.begin(), queue.end());
+        markDirty(row, DirtyCold);
+    }
+
+    recordHistory(row);
+}
+
+const ShadowStore::HistoryEntry* ShadowStore::getHistory(int row, int framesAgo) const {
+    int count = m_historyCount[row];
+    if (count == 0) {
+        return nullptr;
+    }
+
+    // Walk back from the newest observation until we find one that was already in effect
+    // at the requested frame. Ages are bounded by HISTORY_SIZE, so this is cheap.
+    int frame = g_game->getFrameCount() - framesAgo;
+    for (int age = 0; age < count; age++) {
+        const HistoryEntry& entry = historyAt(row, age);
+        if (entry.frame <= frame) {
+            return &entry;
+        }
+    }
+
+    return &historyAt(row, count - 1);
+}
+
+int ShadowStore::getDamageTaken(int row, int frames) const {
+    int count = m_historyCount[row];
+    int since = g_game->getFrameCount() - frames;
+    int damage = 0;
+
+    // Add up every drop in health between consecutive observations in the window. Drops
+    // that happened at or before the start of the window aren't counted.
+    for (int age = 0; age + 1 < count; age++) {
+        const HistoryEntry& newer = historyAt(row, age);
+        if (newer.frame <= since) {
+            break;
+        }
+
+        const HistoryEntry& older = historyAt(row, age + 1);
+        int lost = (older.hitPoints + older.shields) - (newer.hitPoints + newer.shields);
+        if (lost > 0) {
+            damage += lost;
+        }
+    }
+
+    return damage;
+}
+
+const std::vector<int>& ShadowStore::getDirtyRows() const {
+    static const std::vector<int> empty;
+    return m_dirtyFrame == g_game->getFrameCount() ? m_dirtyRows : empty;
+}
+
+uint8_t ShadowStore::getDirty(int row) const {
+    return m_dirtyFrame == g_game->getFrameCount() ? m_dirty[row] : 0;
+}
+
+void ShadowStore::clearDirty() {
+    for (int row : m_dirtyRows) {
+        m_dirty[row] = 0;
+    }
+    m_dirtyRows.clear();
+}
+
+int ShadowStore::addRow(bw::Unit real, ShadowUnitImpl* view) {
+    // Reuse a released row if possible so that the store doesn't keep growing as units
+    // come and go.
+    if (!m_freeRows.empty()) {
+        int row = m_freeRows.back();
+        m_freeRows.pop_back();
+
+        m_real[row] = real;
+        m_views[row] = view;
+        m_live[row] = true;
+        m_historyNext[row] = 0;
+        m_historyCount[row] = 0;
+        return row;
+    }
+
+    m_real.push_back(real);
+    m_views.push_back(view);
+    m_live.push_back(true);
+
+    m_player.push_back(nullptr);
+    m_type.emplace_back();
+    m_position.emplace_back();
+    m_angle.push_back(0.0);
+    m_velocityX.push_back(0.0);
+    m_velocityY.push_back(0.0);
+    m_hitPoints.push_back(0);
+    m_shields.push_back(0);
+    m_energy.push_back(0);
+    m_groundWeaponCooldown.push_back(0);
+    m_airWeaponCooldown.push_back(0);
+    m_spellCooldown.push_back(0);
+    m_flags.push_back(0);
+    m_cold.emplace_back();
+
+    m_dirty.push_back(0);
+
+    m_history.resize(m_history.size() + HISTORY_SIZE);
+    m_historyNext.push_back(0);
+    m_historyCount.push_back(0);
+
+    return (int)m_real.size() - 1;
+}
+
+void ShadowStore::releaseRow(int row) {
+    m_views[row] = nullptr;
+    m_live[row] = false;
+
+    // Drop any heap memory held by the row right away rather than when it's reused.
+    m_cold[row] = ColdFields();
+
+    m_freeRows.push_back(row);
+}
+
+void ShadowStore::recordHistory(int row) {
+    HistoryEntry entry;
+    entry.frame     = g_game->getFrameCount();
+    entry.position  = m_position[row];
+    entry.hitPoints = m_hitPoints[row];
+    entry.shields   = m_shields[row];
+    entry.order     = m_cold[row].order;
+
+    if (m_historyCount[row] > 0) {
+        const HistoryEntry& newest = historyAt(row, 0);
+        if (newest.position == entry.position && newest.hitPoints == entry.hitPoints &&
+                newest.shields == entry.shields && newest.order == entry.order) {
+            return;
+        }
+
+        // If the row was already observed this frame, replace that observation rather
+        // than using up another slot.
+        if (newest.frame == entry.frame) {
+            m_history[historyIndex(row, 0)] = entry;
+            return;
+        }
+    }
+
+    m_history[row * HISTORY_SIZE + m_historyNext[row]] = entry;
+    m_historyNext[row] = (m_historyNext[row] + 1) % HISTORY_SIZE;
+    if (m_historyCount[row] < HISTORY_SIZE) {
+        m_historyCount[row]++;
+    }
+}
+
+void ShadowStore::markDirty(int row, uint8_t groups) {
+    // The first change of a new frame throws away the changes from the previous one.
+    int frame = g_game->getFrameCount();
+    if (frame != m_dirtyFrame) {
+        clearDirty();
+        m_dirtyFrame = frame;
+    }
+
+    if (m_dirty[row] == 0) {
+        m_dirtyRows.push_back(row);
+    }
+    m_dirty[row] |= groups;
+}
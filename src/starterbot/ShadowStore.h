@@ -0,0 +1,272 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <cstdint>
+#include <vector>
+
+class ShadowUnitImpl;
+
+// The saved fields of every shadow unit live in this class rather than in the shadow unit
+// objects themselves. Each shadow unit owns one row of the store, and the fields that are
+// read most often (owner, type, position, health, cooldowns and the boolean flags) are
+// kept in separate contiguous columns so that loops over many units can scan just the
+// columns they need without touching the rest of each unit or making virtual calls.
+// Fields that are rarely needed in bulk are kept together in one ColdFields entry per row.
+//
+// The store also remembers which groups of fields changed during the current frame, so
+// that code which caches information derived from units only needs to revisit the rows
+// that actually changed.
+//
+// Lastly, each row has a short history of the observed position, health, and order of its
+// unit, kept in a ring buffer inside one arena shared by all rows. An observation is only
+// recorded when one of these changes, so the observation in effect at some past frame is
+// the newest one that isn't newer than that frame.
+//
+// Rows are identified by index, which stays the same for the lifetime of a shadow unit.
+// Rows released by shadow units that are gone are reused for later ones.
+class ShadowStore {
+public:
+    // The bits of the packed flag column, with one bit for each boolean field of a unit.
+    enum Flag : uint64_t {
+        HasNuke              = 1ull << 0,
+        IsAccelerating       = 1ull << 1,
+        IsAttacking          = 1ull << 2,
+        IsAttackFrame        = 1ull << 3,
+        IsBeingGathered      = 1ull << 4,
+        IsBeingHealed        = 1ull << 5,
+        IsBlind              = 1ull << 6,
+        IsBraking            = 1ull << 7,
+        IsBurrowed           = 1ull << 8,
+        IsCarryingGas        = 1ull << 9,
+        IsCarryingMinerals   = 1ull << 10,
+        IsCloaked            = 1ull << 11,
+        IsCompleted          = 1ull << 12,
+        IsConstructing       = 1ull << 13,
+        IsDetected           = 1ull << 14,
+        IsGatheringGas       = 1ull << 15,
+        IsGatheringMinerals  = 1ull << 16,
+        IsHallucination      = 1ull << 17,
+        IsIdle               = 1ull << 18,
+        IsInterruptible      = 1ull << 19,
+        IsInvincible         = 1ull << 20,
+        IsLifted             = 1ull << 21,
+        IsMorphing           = 1ull << 22,
+        IsMoving             = 1ull << 23,
+        IsParasited          = 1ull << 24,
+        IsSelected           = 1ull << 25,
+        IsStartingAttack     = 1ull << 26,
+        IsStuck              = 1ull << 27,
+        IsTraining           = 1ull << 28,
+        IsUnderAttack        = 1ull << 29,
+        IsUnderDarkSwarm     = 1ull << 30,
+        IsUnderDisruptionWeb = 1ull << 31,
+        IsUnderStorm         = 1ull << 32,
+        IsPowered            = 1ull << 33,
+        IsTargetable         = 1ull << 34,
+    };
+
+    // The groups of fields whose changes are tracked for each row.
+    enum Dirty : uint8_t {
+        DirtyPlayer   = 1 << 0,
+        DirtyType     = 1 << 1,
+        DirtyPosition = 1 << 2, // Position, angle, and velocity.
+        DirtyHealth   = 1 << 3, // Hit points, shields, and energy.
+        DirtyCooldown = 1 << 4, // Weapon and spell cooldowns.
+        DirtyFlags    = 1 << 5,
+        DirtyCold     = 1 << 6, // Anything stored in ColdFields.
+    };
+
+    // The fields of a unit that are rarely needed for many units at once.
+    struct ColdFields {
+        int                resources             = 0;
+        int                resourceGroup         = 0;
+        int                lastCommandFrame      = 0;
+        bw::UnitCommand    lastCommand;
+        bw::Player         lastAttackingPlayer   = nullptr;
+        int                killCount             = 0;
+        int                acidSporeCount        = 0;
+        int                interceptorCount      = 0;
+        int                scarabCount           = 0;
+        int                spiderMineCount       = 0;
+        int                defenseMatrixPoints   = 0;
+        int                defenseMatrixTimer    = 0;
+        int                ensnareTimer          = 0;
+        int                irradiateTimer        = 0;
+        int                lockdownTimer         = 0;
+        int                maelstromTimer        = 0;
+        int                orderTimer            = 0;
+        int                plagueTimer           = 0;
+        int                removeTimer           = 0;
+        int                stasisTimer           = 0;
+        int                stimTimer             = 0;
+        bw::UnitType       buildType;
+        std::vector<bw::UnitType> trainingQueue;
+        bw::TechType       tech;
+        bw::UpgradeType    upgrade;
+        int                remainingBuildTime    = 0;
+        int                remainingTrainTime    = 0;
+        int                remainingResearchTime = 0;
+        int                remainingUpgradeTime  = 0;
+        bw::Unit           buildUnit             = nullptr;
+        bw::Unit           target                = nullptr;
+        bw::Position       targetPosition;
+        bw::Order          order;
+        bw::Order          secondaryOrder;
+        bw::Unit           orderTarget           = nullptr;
+        bw::Position       orderTargetPosition;
+        bw::Position       rallyPosition;
+        bw::Unit           rallyUnit             = nullptr;
+        bw::Unit           addon                 = nullptr;
+        bw::Unit           nydusExit             = nullptr;
+        bw::Unit           powerUp               = nullptr;
+        bw::Unit           transport             = nullptr;
+        bw::Unitset        loadedUnits;
+        bw::Unit           carrier               = nullptr;
+        bw::Unitset        interceptors;
+        bw::Unit           hatchery              = nullptr;
+        bw::Unitset        larva;
+
+        bool operator==(const ColdFields& other) const = default;
+    };
+
+    // The number of observations kept in the history of each row. Units that are moving
+    // change every frame, so this is about two seconds of history at the fastest speed.
+    static constexpr int HISTORY_SIZE = 48;
+
+    // The number of frames per second at the fastest game speed, rounded.
+    static constexpr int FRAMES_PER_SECOND = 24;
+
+    // A single observation in the history of a row, made at the given frame.
+    struct HistoryEntry {
+        int          frame     = -1;
+        bw::Position position;
+        int          hitPoints = 0;
+        int          shields   = 0;
+        bw::Order    order;
+    };
+
+private:
+    friend class ShadowUnitImpl;
+
+    // The real unit and the shadow unit object that own each row. Copies of shadow units
+    // have their own rows that share the real unit of the original.
+    std::vector<bw::Unit> m_real;
+    std::vector<ShadowUnitImpl*> m_views;
+
+    // Whether each row belongs to a shadow unit, as opposed to a row that has been
+    // released.
+    std::vector<bool> m_live;
+
+    std::vector<bw::Player>   m_player;
+    std::vector<bw::UnitType> m_type;
+    std::vector<bw::Position> m_position;
+    std::vector<double>       m_angle;
+    std::vector<double>       m_velocityX;
+    std::vector<double>       m_velocityY;
+    std::vector<int>          m_hitPoints;
+    std::vector<int>          m_shields;
+    std::vector<int>          m_energy;
+    std::vector<int>          m_groundWeaponCooldown;
+    std::vector<int>          m_airWeaponCooldown;
+    std::vector<int>          m_spellCooldown;
+    std::vector<uint64_t>     m_flags;
+    std::vector<ColdFields>   m_cold;
+
+    // The dirty groups of each row, and the list of rows with any dirty groups. These are
+    // reset lazily by the first change in a new frame, which is stored in m_dirtyFrame.
+    std::vector<uint8_t> m_dirty;
+    std::vector<int> m_dirtyRows;
+    int m_dirtyFrame = -1;
+
+    // The history arena, holding HISTORY_SIZE entries for each row. m_historyNext is the
+    // slot that the next observation of a row will be written to, and m_historyCount is
+    // the number of valid observations of the row, up to HISTORY_SIZE.
+    std::vector<HistoryEntry> m_history;
+    std::vector<uint8_t> m_historyNext;
+    std::vector<uint8_t> m_historyCount;
+
+    // Rows that have been released and can be handed out again.
+    std::vector<int> m_freeRows;
+
+public:
+    // Removes every row from the store. All shadow units using the store must have been
+    // destroyed beforehand.
+    void clear();
+
+    // The number of rows in the store, including rows that aren't live. Linear scans
+    // should go up to this count and skip rows for which isLive() is false.
+    int size() const {
+        return (int)m_real.size();
+    }
+
+    bool isLive(int row) const {
+        return m_live[row];
+    }
+
+    // Gets the shadow unit that owns a row, or nullptr if the row has been released.
+    bw::Unit getUnit(int row) const;
+
+    // Copies the current fields of the real unit of a row into the store, marking the
+    // groups of fields that changed as dirty. The real unit should be visible.
+    void update(int row);
+
+    // The rows whose fields changed during the current frame, and which groups of fields
+    // changed for a specific row. Both are empty if nothing has changed yet this frame.
+    const std::vector<int>& getDirtyRows() const;
+    uint8_t getDirty(int row) const;
+
+    // Read-only access to the hot columns for linear scans, all indexed by row.
+    const std::vector<bw::Player>&   players()   const { return m_player; }
+    const std::vector<bw::UnitType>& types()     const { return m_type; }
+    const std::vector<bw::Position>& positions() const { return m_position; }
+    const std::vector<int>&          hitPoints() const { return m_hitPoints; }
+    const std::vector<int>&          shields()   const { return m_shields; }
+    const std::vector<uint64_t>&     flags()     const { return m_flags; }
+    const std::vector<int>&          groundWeaponCooldowns() const { return m_groundWeaponCooldown; }
+    const std::vector<int>&          airWeaponCooldowns()    const { return m_airWeaponCooldown; }
+
+private:
+    // Adds an observation of a row's current fields to its history if any of them differ
+    // from the newest observation.
+    void recordHistory(int row);
+
+    // Gets the index in the arena of the observation of a row with the given age, where
+    // the newest observation has an age of zero.
+    int historyIndex(int row, int age) const {
+        int slot = (m_historyNext[row] - 1 - age + HISTORY_SIZE) % HISTORY_SIZE;
+        return row * HISTORY_SIZE + slot;
+    }
+    const HistoryEntry& historyAt(int row, int age) const {
+        return m_history[historyIndex(row, age)];
+    }
+
+    // Allocates a row for a shadow unit, reusing a released row if there is one.
+    int addRow(bw::Unit real, ShadowUnitImpl* view);
+    void releaseRow(int row);
+
+    void markDirty(int row, uint8_t groups);
+    void clearDirty();
+
+    // Gets the observation of a row that was in effect the given number of frames ago.
+    // If the history doesn't go back that far, the oldest observation is returned. If the
+    // row has never been observed, nullptr is returned.
+    const HistoryEntry* getHistory(int row, int framesAgo) const;
+
+    // Gets the total hit points and shields lost by a row over the given number of past
+    // frames, ignoring any that were regained in the meantime.
+    int getDamageTaken(int row, int frames) const;
+
+    template<typename T>
+    void assign(int row, T& field, const T& value, uint8_t group) {
+        if (!(field == value)) {
+            field = value;
+            markDirty(row, group);
+        }
+    }
+
+    void assignFlag(int row, uint64_t flag, bool value) {
+        uint64_t flags = value ? (m_flags[row] | flag) : (m_flags[row] & ~flag);
+        assign(row, m_flags[row], flags, DirtyFlags);
+    }
+};
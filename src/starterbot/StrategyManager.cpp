@@ -1,19 +1,37 @@
 #include "StrategyManager.h"
 
+#include "DebugDraw.h"
+
 StrategyManager::StrategyManager() :
+    m_taskPool(ANALYSIS_THREADS),
+    m_jobScheduler(JOB_BUDGET),
     m_productionManager(m_unitManager),
     m_scoutManager(m_unitManager),
-    m_combatManager(m_unitManager) {
+    m_combatManager(m_unitManager, m_jobScheduler) {
 }
 
 void StrategyManager::notifyMembers(const bw::Event& event) {
     m_unitManager.notifyReceiver(event);
 
+    // Once the unit manager has brought the shadow units up to date for a new frame, the
+    // other managers analyze the frame, spreading the work over the task pool. Neither
+    // BWAPI's shared memory nor the shadow units change until our next frame, so this
+    // only reads an unchanging view of the game. Commands are only issued afterwards,
+    // from onFrame(), which still runs for each manager in the same fixed order. The
+    // production and scouting managers don't have any analysis worth splitting off.
+    if (event.getType() == bw::EventType::MatchFrame) {
+        m_combatManager.analyzeReceiver(m_taskPool);
+    }
+
     m_productionManager.notifyReceiver(event);
     m_scoutManager.notifyReceiver(event);
     m_combatManager.notifyReceiver(event);
 }
 
+void StrategyManager::onStart() {
+    m_jobScheduler.reset();
+}
+
 void StrategyManager::onFrame() {
     if (g_self->getRace() == bw::Races::Protoss) {
         onProtossFrame();
@@ -22,6 +40,10 @@ void StrategyManager::onFrame() {
     } else {
         onZergFrame();
     }
+
+    // Once every manager has done its regular work for the frame, the scheduled jobs get
+    // whatever time is left in the budget.
+    m_jobScheduler.runFrame();
 }
 
 void StrategyManager::onDraw() {
@@ -45,9 +67,9 @@ void StrategyManager::onProtossFrame() {
     m_productionManager.targetBuildRequests(
         bw::UnitTypes::Protoss_Pylon, g_self->supplyUsed() / 14);
 
-    int workerCount  = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Protoss_Probe);
-    int zealotCount  = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Protoss_Zealot);
-    int dragoonCount = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Protoss_Dragoon);
+    int workerCount  = m_unitManager.typeCount(g_self, bw::UnitTypes::Protoss_Probe);
+    int zealotCount  = m_unitManager.typeCount(g_self, bw::UnitTypes::Protoss_Zealot);
+    int dragoonCount = m_unitManager.typeCount(g_self, bw::UnitTypes::Protoss_Dragoon);
 
     // If we have enough workers with which to gather resources, we can send one of them
     // out to go do some scouting.
@@ -55,6 +77,10 @@ void StrategyManager::onProtossFrame() {
         m_scoutManager.addScout(bw::UnitTypes::Protoss_Probe);
     }
 
+    // The buildings we need are left to the build planner, which works out when to start
+    // each of them and saves up for them in the meantime.
+    BuildPlanner::Goal goal;
+
     // If we have a sufficient number of workers, we can start expanding our army. We
     // choose the number of gateways to build based on the number of fighting units we
     // currently have so we don't run into bottlenecks in army production.
@@ -67,21 +93,23 @@ void StrategyManager::onProtossFrame() {
             target = 2;
         }
 
-        m_productionManager.targetBuildRequests(bw::UnitTypes::Protoss_Gateway, target);
+        goal.push_back({ bw::UnitTypes::Protoss_Gateway, target });
     }
 
     // Once we've built a few zealots, we should start expanding to get more powerful
-    // units. So, build an assimilator to start collecting gas, and then a cybernetics
-    // core for dragoon support.
+    // units. Asking for another dragoon makes the planner fit in the assimilator and the
+    // cybernetics core that it needs.
     if (zealotCount >= 3) {
-        m_productionManager.targetBuildRequests(bw::UnitTypes::Protoss_Assimilator, 1);
-    }
-    if (zealotCount >= 4) {
-        m_productionManager.targetBuildRequests(bw::UnitTypes::Protoss_Cybernetics_Core, 1);
+        goal.push_back({ bw::UnitTypes::Protoss_Dragoon, dragoonCount + 1 });
     }
 
-    // If we have a large enough army at any point, we can send them out to attack.
-    if (dragoonCount + zealotCount >= 20) {
+    m_productionManager.setBuildGoal(goal);
+
+    // If we have a large enough army at any point, we can send them out to attack. We
+    // also attack earlier with a smaller army if the combat simulator expects it to beat
+    // the enemy army we know about.
+    int armyCount = dragoonCount + zealotCount;
+    if (armyCount >= 20 || (armyCount >= 8 && m_combatManager.isAttackFavorable())) {
         m_combatManager.startAttack();
     }
 }
@@ -96,8 +124,8 @@ void StrategyManager::onTerranFrame() {
     m_productionManager.targetBuildRequests(
         bw::UnitTypes::Terran_Supply_Depot, g_self->supplyUsed() / 12);
 
-    int workerCount = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Terran_SCV);
-    int fighterCount = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Terran_Marine);
+    int workerCount = m_unitManager.typeCount(g_self, bw::UnitTypes::Terran_SCV);
+    int fighterCount = m_unitManager.typeCount(g_self, bw::UnitTypes::Terran_Marine);
 
     if (workerCount >= 8 && m_scoutManager.countScouts(bw::UnitTypes::Terran_SCV) == 0) {
         m_scoutManager.addScout(bw::UnitTypes::Terran_SCV);
@@ -122,8 +150,8 @@ void StrategyManager::onZergFrame() {
         {bw::UnitTypes::Zerg_Zergling, 0.60},
     }, true);
 
-    int workerCount = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Zerg_Drone);
-    int fighterCount = m_unitManager.selfCount(bw::GetType == bw::UnitTypes::Zerg_Broodling);
+    int workerCount = m_unitManager.typeCount(g_self, bw::UnitTypes::Zerg_Drone);
+    int fighterCount = m_unitManager.typeCount(g_self, bw::UnitTypes::Zerg_Broodling);
 
     // If we have enough workers past a certain threshold, we can make a spawning pool in
     // order to gain the ability to morph fighter units.
@@ -143,34 +171,53 @@ void StrategyManager::onZergFrame() {
 }
 
 void StrategyManager::drawUnitBoxes() {
+    if (!g_debugDraw.isEnabled(DrawChannel::UnitBoxes)) {
+        return;
+    }
+
     for (bw::Unit unit : g_game->getAllUnits()) {
         bw::Position topLeft(unit->getLeft(), unit->getTop());
         bw::Position bottomRight(unit->getRight(), unit->getBottom());
 
-        g_game->drawBoxMap(topLeft, bottomRight, bw::Colors::White);
+        g_debugDraw.drawBox(DrawChannel::UnitBoxes, topLeft, bottomRight, bw::Colors::White);
     }
 }
 
 void StrategyManager::drawCommands() {
+    if (!g_debugDraw.isEnabled(DrawChannel::Commands)) {
+        return;
+    }
+
     for (bw::Unit unit : g_self->getUnits()) {
         const bw::UnitCommand& command = unit->getLastCommand();
 
         // If the previous command had a ground position target, draw it in green.
         if (command.getTargetPosition() != bw::Positions::None) {
-            g_game->drawLineMap(unit->getPosition(),
+            g_debugDraw.drawLine(DrawChannel::Commands, unit->getPosition(),
                 command.getTargetPosition(), bw::Colors::Green);
         }
 
         // If the previous command had a unit target, draw it in white.
         if (command.getTarget() != nullptr) {
-            g_game->drawLineMap(unit->getPosition(),
+            g_debugDraw.drawLine(DrawChannel::Commands, unit->getPosition(),
                 command.getTarget()->getPosition(), bw::Colors::White);
         }
     }
 }
 
 void StrategyManager::drawHealthBars() {
+    if (!g_debugDraw.isEnabled(DrawChannel::HealthBars)) {
+        return;
+    }
+
     for (bw::Unit unit : g_game->getAllUnits()) {
+        // The bars are drawn just above the unit, so skip units that are well off screen
+        // before working out what their bars look like.
+        if (!g_debugDraw.isOnScreen(bw::Position(unit->getLeft(), unit->getTop() - 16),
+                bw::Position(unit->getRight(), unit->getBottom()))) {
+            continue;
+        }
+
         // If the unit is a resource, draw the remaining resources in cyan.
         if (unit->getType().isResourceContainer() && unit->getInitialResources() > 0) {
             double mineralRatio = (double)unit->getResources() / (double)unit->getInitialResources();
@@ -215,11 +262,15 @@ void StrategyManager::drawHealthBar(bw::Unit unit, double ratio, bw::Color color
     int bar = (int)((right - left) * ratio + left);
 
     // Draw the background of the bar, the bar itself, and the tick marks inside the bar.
-    g_game->drawBoxMap(bw::Position(left, top), bw::Position(right, bottom), bw::Colors::Grey, true);
-    g_game->drawBoxMap(bw::Position(left, top), bw::Position(bar, bottom), color, true);
-    g_game->drawBoxMap(bw::Position(left, top), bw::Position(right, bottom), bw::Colors::Black, false);
+    g_debugDraw.drawBox(DrawChannel::HealthBars,
+        bw::Position(left, top), bw::Position(right, bottom), bw::Colors::Grey, true);
+    g_debugDraw.drawBox(DrawChannel::HealthBars,
+        bw::Position(left, top), bw::Position(bar, bottom), color, true);
+    g_debugDraw.drawBox(DrawChannel::HealthBars,
+        bw::Position(left, top), bw::Position(right, bottom), bw::Colors::Black, false);
 
     for (int i = left; i < right - 1; i += 3) {
-        g_game->drawLineMap(bw::Position(i, top), bw::Position(i, bottom), bw::Colors::Black);
+        g_debugDraw.drawLine(DrawChannel::HealthBars,
+            bw::Position(i, top), bw::Position(i, bottom), bw::Colors::Black);
     }
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "CombatManager.h"
+#include "JobScheduler.h"
 #include "ProductionManager.h"
 #include "ScoutManager.h"
+#include "TaskPool.h"
 #include "Tools.h"
 #include "UnitManager.h"
 
@@ -11,6 +13,20 @@
 // build order and strategy-making decisions.
 class StrategyManager : public EventReceiver {
 private:
+    // The number of threads besides the main one that the managers analyze each frame
+    // on. With zero, all of the analysis happens on the main thread. The only analysis so
+    // far is the combat manager's danger set and threat map updates, which are too small
+    // to gain anything from waking other threads, so there are none until heavier
+    // analysis moves there.
+    static constexpr int ANALYSIS_THREADS = 0;
+
+    TaskPool m_taskPool;
+
+    // The time in microseconds that the scheduled jobs of the managers may take per frame.
+    static constexpr int JOB_BUDGET = 5000;
+
+    JobScheduler m_jobScheduler;
+
     UnitManager m_unitManager;
 
     ProductionManager m_productionManager;
@@ -23,6 +39,7 @@ public:
 protected:
     virtual void notifyMembers(const bw::Event& event) override;
 
+    virtual void onStart() override;
     virtual void onFrame() override;
     virtual void onDraw() override;
 
@@ -0,0 +1,181 @@
+#include "TargetAssigner.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TargetAssigner::clear() {
+    m_attackers.clear();
+
+    m_targets.clear();
+    m_targetX.clear();
+    m_targetY.clear();
+    m_targetRadius.clear();
+    m_targetHealth.clear();
+    m_targetPriority.clear();
+    m_targetKind.clear();
+    m_targetIndex.clear();
+    m_targetKinds.clear();
+
+    m_assignments.clear();
+}
+
+void TargetAssigner::addAttacker(bw::Unit unit) {
+    m_attackers.push_back(unit);
+}
+
+void TargetAssigner::addAttackers(const bw::Unitset& units) {
+    m_attackers.insert(m_attackers.end(), units.begin(), units.end());
+}
+
+void TargetAssigner::addTarget(bw::Unit unit, int priority) {
+    if (!unit->getPosition().isValid() || !m_targetIndex.emplace(unit, m_targets.size()).second) {
+        return;
+    }
+
+    bw::UnitType type = unit->getType();
+    TargetKind kind = { type, unit->getPlayer(), unit->isFlying() };
+
+    auto it = std::find(m_targetKinds.begin(), m_targetKinds.end(), kind);
+    if (it == m_targetKinds.end()) {
+        it = m_targetKinds.insert(m_targetKinds.end(), kind);
+    }
+
+    m_targets.push_back(unit);
+    m_targetX.push_back((float)unit->getPosition().x);
+    m_targetY.push_back((float)unit->getPosition().y);
+    m_targetRadius.push_back((float)(std::max(type.width(), type.height()) / 2));
+    m_targetHealth.push_back((float)std::max(unit->getHitPoints() + unit->getShields(), 1));
+    m_targetPriority.push_back((float)priority);
+    m_targetKind.push_back((int)(it - m_targetKinds.begin()));
+}
+
+void TargetAssigner::addTargets(const bw::Unitset& units, int priority) {
+    for (bw::Unit unit : units) {
+        addTarget(unit, priority);
+    }
+}
+
+void TargetAssigner::solve() {
+    m_assignments.clear();
+
+    int numAttackers = m_attackers.size();
+    int numTargets = m_targets.size();
+    if (numAttackers == 0 || numTargets == 0) {
+        return;
+    }
+
+    m_scores.resize(numAttackers * numTargets);
+    m_rates.resize(numAttackers * numTargets);
+
+    for (int i = 0; i < numAttackers; i++) {
+        scoreAttacker(i);
+    }
+
+    // Sort every pair that can be assigned by its score, breaking ties by index so that
+    // the result doesn't depend on the sorting algorithm.
+    m_order.clear();
+    for (int i = 0; i < (int)m_scores.size(); i++) {
+        if (m_scores[i] < UNREACHABLE) {
+            m_order.push_back(i);
+        }
+    }
+
+    std::sort(m_order.begin(), m_order.end(), [this](int a, int b) {
+        return m_scores[a] != m_scores[b] ? m_scores[a] < m_scores[b] : a < b;
+    });
+
+    m_remaining = m_targetHealth;
+    m_chosen.assign(numAttackers, -1);
+
+    for (int pair : m_order) {
+        int attacker = pair / numTargets;
+        int target = pair % numTargets;
+
+        if (m_chosen[attacker] >= 0 || m_remaining[target] <= 0) {
+            continue;
+        }
+
+        m_chosen[attacker] = target;
+        m_remaining[target] -= m_rates[pair] * OVERKILL_FRAMES;
+    }
+
+    // If every target an attacker can hit is already expected to die, it's still better
+    // to help out with the best one than to stand around.
+    for (int pair : m_order) {
+        int attacker = pair / numTargets;
+        if (m_chosen[attacker] < 0) {
+            m_chosen[attacker] = pair % numTargets;
+        }
+    }
+
+    for (int i = 0; i < numAttackers; i++) {
+        if (m_chosen[i] >= 0) {
+            m_assignments.push_back({ m_attackers[i], m_targets[m_chosen[i]] });
+        }
+    }
+}
+
+const std::vector<TargetAssigner::Assignment>& TargetAssigner::getAssignments() const {
+    return m_assignments;
+}
+
+void TargetAssigner::scoreAttacker(int index) {
+    bw::Unit attacker = m_attackers[index];
+    bw::UnitType type = attacker->getType();
+    bw::Player player = attacker->getPlayer();
+
+    // First work out the damage per frame and range against each kind of target, which
+    // is where all the calls into BWAPI happen.
+    int numKinds = m_targetKinds.size();
+    m_kindRates.resize(numKinds);
+    m_kindRanges.resize(numKinds);
+
+    for (int i = 0; i < numKinds; i++) {
+        const TargetKind& kind = m_targetKinds[i];
+        bw::WeaponType weapon = kind.isFlying ? type.airWeapon() : type.groundWeapon();
+
+        if (weapon == bw::WeaponTypes::None || weapon == bw::WeaponTypes::Unknown) {
+            m_kindRates[i] = 0;
+            m_kindRanges[i] = 0;
+            continue;
+        }
+
+        int damage = g_game->getDamageFrom(type, kind.type, player, kind.player);
+        int cooldown = kind.isFlying ? weapon.damageCooldown() : player->weaponDamageCooldown(type);
+
+        m_kindRates[i] = (float)damage / std::max(cooldown, 1);
+        m_kindRanges[i] = (float)player->weaponMaxRange(weapon);
+    }
+
+    // Then spread those out to the targets, so that the scoring loop below only has to
+    // go through flat arrays.
+    int numTargets = m_targets.size();
+    float* scores = m_scores.data() + index * numTargets;
+    float* rates = m_rates.data() + index * numTargets;
+    m_ranges.resize(numTargets);
+
+    for (int i = 0; i < numTargets; i++) {
+        rates[i] = m_kindRates[m_targetKind[i]];
+        m_ranges[i] = m_kindRanges[m_targetKind[i]];
+    }
+
+    // The score is the number of frames the attacker needs to walk into range and then
+    // kill the target on its own, with the target's priority added on top.
+    float x = (float)attacker->getPosition().x;
+    float y = (float)attacker->getPosition().y;
+    float radius = (float)(std::max(type.width(), type.height()) / 2);
+    float speed = type.isBuilding() ? 0.0f : (float)player->topSpeed(type);
+    float inverseSpeed = speed > 0 ? 1 / speed : 0;
+
+    for (int i = 0; i < numTargets; i++) {
+        float dx = m_targetX[i] - x;
+        float dy = m_targetY[i] - y;
+        float gap = std::sqrt(dx * dx + dy * dy) - radius - m_targetRadius[i] - m_ranges[i];
+        gap = std::max(gap, 0.0f);
+
+        bool canHit = rates[i] > 0 && (speed > 0 || gap == 0);
+        float frames = gap * inverseSpeed + m_targetHealth[i] / std::max(rates[i], 1e-6f);
+
+        scores[i] = canHit ? m_targetPriority[i] * PRIORITY_COST + frames : UNREACHABLE;
+    }
+}
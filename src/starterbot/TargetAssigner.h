@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Chooses a target for each of a group of attacking units at once, rather than letting
+// every unit or cluster pick the closest enemy on its own. Every attacker is scored
+// against every target by the number of frames it would take the attacker to get in
+// range and kill the target by itself, using the actual damage of the attacker against
+// the target, and the pairs are then assigned greedily from the best score down.
+//
+// To avoid overkill, each assignment counts the damage the attacker is expected to deal
+// over the next few seconds towards the target's remaining health. Once a target is
+// expected to die, further attackers go to their next best target instead, and only if
+// every target they can hit is taken care of do they pile onto one anyway.
+//
+// Targets can be given priorities, where a less preferred target is only chosen if the
+// attacker can't hit any of the more preferred ones or they're all expected to die. The
+// scores are computed into a flat matrix from per-target arrays in plain loops that the
+// compiler can vectorize.
+class TargetAssigner {
+public:
+    struct Assignment {
+        bw::Unit attacker;
+        bw::Unit target;
+    };
+
+private:
+    // The number of frames of expected damage that count towards killing a target.
+    static constexpr int OVERKILL_FRAMES = 48;
+    // The score penalty for each level of priority. This is larger than any real number
+    // of frames, so it makes the priority dominate the rest of the score.
+    static constexpr float PRIORITY_COST = 1e6f;
+    // The score given to pairs where the attacker can't ever hit the target. Anything at
+    // or above this isn't assigned at all.
+    static constexpr float UNREACHABLE = 1e12f;
+
+    std::vector<bw::Unit> m_attackers;
+
+    // The targets, along with the index of each one's kind in m_targetKinds, so that
+    // damage only has to be computed once per kind of target.
+    std::vector<bw::Unit> m_targets;
+    std::vector<float> m_targetX;
+    std::vector<float> m_targetY;
+    std::vector<float> m_targetRadius;
+    std::vector<float> m_targetHealth;
+    std::vector<float> m_targetPriority;
+    std::vector<int> m_targetKind;
+    std::unordered_map<bw::Unit, int> m_targetIndex;
+
+    struct TargetKind {
+        bw::UnitType type;
+        bw::Player player;
+        bool isFlying;
+
+        bool operator==(const TargetKind& other) const = default;
+    };
+    std::vector<TargetKind> m_targetKinds;
+
+    // Scratch space for scoring one attacker: its damage per frame and range against each
+    // kind of target, and its range against each target.
+    std::vector<float> m_kindRates;
+    std::vector<float> m_kindRanges;
+    std::vector<float> m_ranges;
+
+    // The score of every attacker against every target, one row per attacker, and the
+    // damage per frame of every attacker against every target in the same layout.
+    std::vector<float> m_scores;
+    std::vector<float> m_rates;
+
+    // The indices of the scores that can be assigned, sorted from best to worst, along
+    // with the health each target has left after the damage assigned to it so far.
+    std::vector<int> m_order;
+    std::vector<float> m_remaining;
+    std::vector<int> m_chosen;
+
+    std::vector<Assignment> m_assignments;
+
+public:
+    // Removes all attackers and targets.
+    void clear();
+
+    // Adds a unit of ours that needs a target.
+    void addAttacker(bw::Unit unit);
+    void addAttackers(const bw::Unitset& units);
+
+    // Adds a unit that can be attacked, with higher priority values making it less
+    // preferred. A unit that has already been added keeps its original priority.
+    void addTarget(bw::Unit unit, int priority = 0);
+    void addTargets(const bw::Unitset& units, int priority = 0);
+
+    // Assigns targets to the attackers. Attackers that can't attack any target are left
+    // out of the assignments.
+    void solve();
+
+    // The assignments made by the last call to solve().
+    const std::vector<Assignment>& getAssignments() const;
+
+private:
+    // Fills in the score and damage rate rows of one attacker.
+    void scoreAttacker(int index);
+};
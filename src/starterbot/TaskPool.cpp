@@ -0,0 +1,160 @@
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <exception>
+
+// The index of the queue owned by the current thread if it's a worker thread of a pool,
+// along with that pool so that threads of other pools don't mistake it for their own.
+static thread_local const TaskPool* t_pool = nullptr;
+static thread_local int t_queue = -1;
+
+TaskPool::TaskPool(int threadCount) {
+    threadCount = std::max(threadCount, 0);
+
+    for (int i = 0; i <= threadCount; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+int TaskPool::getThreadCount() const {
+    return (int)m_threads.size();
+}
+
+void TaskPool::run(std::vector<Task> tasks) {
+    if (m_threads.empty()) {
+        for (Task& task : tasks) {
+            task();
+        }
+        return;
+    }
+
+    // Each task counts itself off once it's done, even if it throws, and that's the last
+    // thing it touches, so the batch can live on this stack frame as long as we wait for
+    // the count to reach zero. The first exception thrown is passed on once they're done.
+    struct Batch {
+        std::mutex mutex;
+        std::condition_variable done;
+        int remaining = 0;
+        std::exception_ptr error;
+    } batch;
+    batch.remaining = (int)tasks.size();
+
+    struct CountOff {
+        Batch& batch;
+
+        ~CountOff() {
+            // Notify while holding the lock, since the batch is gone as soon as run()
+            // sees the count reach zero.
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (--batch.remaining == 0) {
+                batch.done.notify_all();
+            }
+        }
+    };
+
+    // Spread the tasks over every queue so that the workers can start on them without
+    // having to steal anything first.
+    for (int i = 0; i < (int)tasks.size(); i++) {
+        Queue& queue = *m_queues[(currentQueue() + i) % m_queues.size()];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back([task = std::move(tasks[i]), &batch]() {
+            CountOff countOff = { batch };
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                if (!batch.error) {
+                    batch.error = std::current_exception();
+                }
+            }
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued += (int)tasks.size();
+    }
+    m_wake.notify_all();
+
+    // Help out until there's nothing left to take, and then sleep until the last few
+    // tasks have finished running on other threads.
+    int index = currentQueue();
+    while (runOne(index)) {
+    }
+
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void TaskPool::workerLoop(int index) {
+    t_pool = this;
+    t_queue = index;
+
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_isStopping || m_queued > 0; });
+
+        if (m_isStopping) {
+            return;
+        }
+    }
+}
+
+bool TaskPool::runOne(int index) {
+    Task task;
+
+    for (int i = 0; i < (int)m_queues.size() && !task; i++) {
+        Queue& queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        // Our own queue is worked through in order, while other queues are stolen from
+        // at the other end so that we get in the way of their owner as little as possible.
+        if (i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    m_queued--;
+    task();
+    return true;
+}
+
+int TaskPool::currentQueue() const {
+    return t_pool == this ? t_queue : (int)m_threads.size();
+}
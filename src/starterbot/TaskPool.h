@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small pool of worker threads that runs batches of independent tasks. Each thread,
+// including the one that calls run(), has its own queue of tasks, which it works through
+// from the front while idle threads steal tasks from the back of the other queues. This
+// keeps every thread busy without them all fighting over a single queue, and a task can
+// itself call run() to split its work up further, since the calling thread keeps running
+// tasks while it waits.
+//
+// The pool makes no attempt to protect what the tasks do, so tasks in the same batch must
+// not modify anything that another one reads or modifies. If a task throws, the rest of
+// the batch still runs, and run() then throws the first exception. With no worker threads,
+// run() simply runs each task on the calling thread in order, stopping at an exception.
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // One queue for each worker thread, followed by a queue shared by any thread outside
+    // of the pool that calls run().
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    // The number of tasks in all the queues. Idle worker threads sleep until it becomes
+    // non-zero, so it's only increased while holding m_mutex.
+    std::atomic<int> m_queued = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_isStopping = false;
+
+public:
+    explicit TaskPool(int threadCount);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    int getThreadCount() const;
+
+    // Runs every task in the batch and returns once all of them have finished.
+    void run(std::vector<Task> tasks);
+
+private:
+    void workerLoop(int index);
+
+    // Takes one task, preferring the given queue and stealing from the others otherwise,
+    // and runs it. Returns false if there were no tasks to take.
+    bool runOne(int index);
+
+    int currentQueue() const;
+};
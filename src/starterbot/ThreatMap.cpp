@@ -0,0 +1,182 @@
+#include "ThreatMap.h"
+
+#include "CarriedWeapons.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Our units are hit when their edge is in range rather than their center, so ranges are
+// extended by roughly half the size of a small unit.
+constexpr int TARGET_SIZE = 16;
+
+void ThreatMap::reset(int width, int height) {
+    m_width = width;
+    m_height = height;
+
+    m_ground.assign(width * height, 0);
+    m_air.assign(width * height, 0);
+
+    m_entries.clear();
+    m_update = 0;
+}
+
+void ThreatMap::update(const bw::Unitset& units) {
+    m_update++;
+
+    for (bw::Unit unit : units) {
+        Stamp stamp = makeStamp(unit);
+        bool threatens = stamp.groundThreat > 0 || stamp.airThreat > 0;
+
+        auto it = m_entries.find(unit);
+        if (it != m_entries.end()) {
+            it->second.update = m_update;
+
+            // Most units don't cross into another tile or change how they can attack
+            // between frames, so their stamps stay as they are.
+            if (it->second.stamp == stamp) {
+                continue;
+            }
+
+            addStamp(it->second.stamp, -1);
+            if (!threatens) {
+                m_entries.erase(it);
+                continue;
+            }
+            it->second.stamp = stamp;
+        } else if (threatens) {
+            m_entries.emplace(unit, Entry{ stamp, m_update });
+        } else {
+            continue;
+        }
+
+        addStamp(stamp, 1);
+    }
+
+    // Take off any units that weren't in the set, since they were destroyed or are no
+    // longer enemies.
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.update != m_update) {
+            addStamp(it->second.stamp, -1);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int ThreatMap::getGroundThreat(bw::Position pos) const {
+    int index = tileIndex(pos);
+    return index < 0 ? 0 : m_ground[index];
+}
+
+int ThreatMap::getAirThreat(bw::Position pos) const {
+    int index = tileIndex(pos);
+    return index < 0 ? 0 : m_air[index];
+}
+
+int ThreatMap::getThreat(bw::Position pos, bool isFlyer) const {
+    return isFlyer ? getAirThreat(pos) : getGroundThreat(pos);
+}
+
+ThreatMap::Stamp ThreatMap::makeStamp(bw::Unit unit) {
+    Stamp stamp;
+
+    // Units that aren't finished or are disabled can't attack right now.
+    if (!unit->getPosition().isValid() || !unit->isCompleted() || unit->isLockedDown() ||
+            unit->isStasised() || unit->isMaelstrommed()) {
+        return stamp;
+    }
+
+    bw::UnitType type = unit->getType();
+    bw::Player player = unit->getPlayer();
+    stamp.tile = bw::TilePosition(unit->getPosition());
+
+    // Some units don't attack with their own weapons, but with the units they carry. For
+    // those, we measure the damage of the carried unit and adjust its range and rate.
+    bw::UnitType shooter = type;
+    int count = 1;
+    int range = -1;
+    int cooldown = -1;
+
+    if (type == bw::UnitTypes::Terran_Bunker) {
+        shooter = bw::UnitTypes::Terran_Marine;
+        count = BUNKER_MARINES;
+        range = player->weaponMaxRange(shooter.groundWeapon()) + BUNKER_RANGE_BONUS;
+    } else if (type == bw::UnitTypes::Protoss_Carrier) {
+        shooter = bw::UnitTypes::Protoss_Interceptor;
+        count = unit->getInterceptorCount();
+        range = LAUNCH_RANGE;
+        cooldown = INTERCEPTOR_COOLDOWN;
+    } else if (type == bw::UnitTypes::Protoss_Reaver) {
+        shooter = bw::UnitTypes::Protoss_Scarab;
+        range = LAUNCH_RANGE;
+        cooldown = REAVER_COOLDOWN;
+    }
+
+    // We measure damage against our own worker and transport, as typical ground and air
+    // units, taking our armor upgrades into account.
+    bw::Race race = g_self != nullptr ? g_self->getRace() : bw::Races::Terran;
+    int reach = std::max(type.width(), type.height()) / 2 + TARGET_SIZE;
+
+    auto measure = [&](bw::WeaponType weapon, bw::UnitType target, int& radius, int& threat) {
+        if (count == 0 || weapon == bw::WeaponTypes::None || weapon == bw::WeaponTypes::Unknown) {
+            return;
+        }
+
+        int damage = g_game->getDamageFrom(shooter, target, player);
+        int frames = cooldown;
+        if (frames < 0) {
+            frames = target.isFlyer() ? weapon.damageCooldown() : player->weaponDamageCooldown(shooter);
+        }
+
+        radius = (range >= 0 ? range : player->weaponMaxRange(weapon)) + reach;
+        threat = damage * count * THREAT_FRAMES / std::max(frames, 1);
+    };
+
+    measure(shooter.groundWeapon(), race.getWorker(), stamp.groundRadius, stamp.groundThreat);
+    measure(shooter.airWeapon(), race.getTransport(), stamp.airRadius, stamp.airThreat);
+
+    return stamp;
+}
+
+void ThreatMap::addStamp(const Stamp& stamp, int sign) {
+    if (stamp.groundThreat > 0) {
+        addCircle(m_ground, stamp.tile, stamp.groundRadius, sign * stamp.groundThreat);
+    }
+    if (stamp.airThreat > 0) {
+        addCircle(m_air, stamp.tile, stamp.airRadius, sign * stamp.airThreat);
+    }
+}
+
+void ThreatMap::addCircle(std::vector<int>& layer, bw::TilePosition tile, int radius, int value) {
+    // The circle covers every tile whose center is within the radius of the center of the
+    // stamp's tile. Each row of the circle is a contiguous span of tiles, so we work out
+    // its ends once and then add to the whole span in a plain loop that the compiler can
+    // vectorize.
+    int rows = radius / 32;
+
+    for (int dy = -rows; dy <= rows; dy++) {
+        int y = tile.y + dy;
+        if (y < 0 || y >= m_height) {
+            continue;
+        }
+
+        int offset = dy * 32;
+        int halfWidth = (int)std::sqrt((double)(radius * radius - offset * offset)) / 32;
+
+        int left = std::max(tile.x - halfWidth, 0);
+        int right = std::min(tile.x + halfWidth, m_width - 1);
+
+        int* row = layer.data() + y * m_width;
+        for (int x = left; x <= right; x++) {
+            row[x] += value;
+        }
+    }
+}
+
+int ThreatMap::tileIndex(bw::Position pos) const {
+    if (pos.x < 0 || pos.y < 0 || pos.x / 32 >= m_width || pos.y / 32 >= m_height) {
+        return -1;
+    }
+    return (pos.y / 32) * m_width + pos.x / 32;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <unordered_map>
+#include <vector>
+
+// A grid over the map holding, for every build tile, how much damage the known enemy
+// units could deal to a unit of ours standing on it, separately for ground and air units.
+// Each enemy unit adds its damage rate to every tile within the range of its weapon, so
+// sampling the threat at a position is a single lookup.
+//
+// The grid is updated incrementally: update() is given the current set of enemy units
+// every frame, and only units that appeared, disappeared, moved to another tile or
+// changed in some other way that affects their threat are taken off and put back on the
+// grid. Values are integers so that doing so never leaves rounding errors behind.
+class ThreatMap {
+public:
+    // Threat is measured in damage per this many frames, about a second at the fastest
+    // game speed.
+    static constexpr int THREAT_FRAMES = 24;
+
+private:
+    // How one unit was last added to the grid: its tile, its reach in pixels around the
+    // center of that tile, and the threat added to tiles in reach of each layer.
+    struct Stamp {
+        bw::TilePosition tile;
+        int groundRadius = 0;
+        int airRadius = 0;
+        int groundThreat = 0;
+        int airThreat = 0;
+
+        bool operator==(const Stamp& other) const = default;
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+
+    std::vector<int> m_ground;
+    std::vector<int> m_air;
+
+    // The stamp of every unit on the grid, with the number of the last update that saw
+    // the unit so that units missing from an update can be taken off.
+    struct Entry {
+        Stamp stamp;
+        int update;
+    };
+    std::unordered_map<bw::Unit, Entry> m_entries;
+    int m_update = 0;
+
+public:
+    // Clears the grid and sizes it for a new game, in build tiles.
+    void reset(int width, int height);
+
+    // Brings the grid up to date with the current positions and states of a set of units.
+    // Units that can't attack add nothing, so all known enemy units can be passed in.
+    void update(const bw::Unitset& units);
+
+    // The threat to ground or air units at a position, which is zero outside the map.
+    int getGroundThreat(bw::Position pos) const;
+    int getAirThreat(bw::Position pos) const;
+    int getThreat(bw::Position pos, bool isFlyer) const;
+
+private:
+    // Works out how a unit threatens the tiles around it at the moment.
+    static Stamp makeStamp(bw::Unit unit);
+
+    void addStamp(const Stamp& stamp, int sign);
+    void addCircle(std::vector<int>& layer, bw::TilePosition tile, int radius, int value);
+
+    int tileIndex(bw::Position pos) const;
+};
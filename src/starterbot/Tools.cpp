@@ -1,5 +1,7 @@
 #include "Tools.h"
 
+#include "Profiler.h"
+
 bw::GameWrapper& g_game = bw::Broodwar;
 bw::Player g_self = nullptr;
 
@@ -15,17 +17,58 @@ namespace BWAPI::Filter {
     const CompareFilter<Unit, Unit, Unit(*)(Unit)> BuildUnit(&implBuildUnit);
 }
 
+// Gets the name of the handler that is called for a type of event, which is what the
+// time spent in it is recorded under by the profiler.
+static const char* getHandlerName(bw::EventType::Enum type) {
+    switch (type) {
+    case bw::EventType::MatchStart:   return "onStart";
+    case bw::EventType::MatchEnd:     return "onEnd";
+    case bw::EventType::SendText:     return "onSendText";
+    case bw::EventType::ReceiveText:  return "onReceiveText";
+    case bw::EventType::UnitCreate:   return "onUnitCreate";
+    case bw::EventType::UnitDestroy:  return "onUnitDestroy";
+    case bw::EventType::UnitComplete: return "onUnitComplete";
+    case bw::EventType::UnitMorph:    return "onUnitMorph";
+    case bw::EventType::UnitRenegade: return "onUnitRenegade";
+    case bw::EventType::UnitHide:     return "onUnitHide";
+    case bw::EventType::UnitShow:     return "onUnitShow";
+    case bw::EventType::UnitEvade:    return "onUnitEvade";
+    case bw::EventType::UnitDiscover: return "onUnitDiscover";
+    default:                          return "other";
+    }
+}
+
+void EventReceiver::analyzeReceiver(TaskPool& pool) {
+    Profiler::Scope receiverScope(this, typeid(*this));
+    Profiler::Scope handlerScope("onAnalyze");
+
+    onAnalyze(pool);
+}
+
 void EventReceiver::notifyReceiver(const bw::Event& event) {
+    // The time of the members is recorded under this receiver, with the time of each
+    // handler recorded next to them.
+    Profiler::Scope receiverScope(this, typeid(*this));
+
     notifyMembers(event);
 
+    // Frames have two handlers, which we time separately.
+    if (event.getType() == bw::EventType::MatchFrame) {
+        {
+            Profiler::Scope handlerScope("onFrame");
+            onFrame();
+        }
+        Profiler::Scope handlerScope("onDraw");
+        onDraw();
+        return;
+    }
+
+    Profiler::Scope handlerScope(getHandlerName(event.getType()));
+
     switch (event.getType()) {
     case bw::EventType::MatchStart:
         onStart();
         break;
-    case bw::EventType::MatchFrame:
-        onFrame();
-        onDraw();
-        break;
     case bw::EventType::MatchEnd:
         onEnd(event.isWinner());
         break;
@@ -4,6 +4,8 @@
 
 #include <string>
 
+class TaskPool;
+
 // We don't want to have to type obscenely long names like BWAPI::Broodwar all the time,
 // so we make some convenience using's and global variables.
 namespace bw {
@@ -33,6 +35,10 @@ public:
 	// appropriate virtual event handler on this class.
     void notifyReceiver(const bw::Event& event);
 
+	// Runs the analysis of the current frame on this event receiver via onAnalyze(). This
+	// is called by the owner of the event receiver before passing it the frame event.
+	void analyzeReceiver(TaskPool& pool);
+
 protected:
 	// If this event receiver has subordinate classes that need to be notified about new
 	// events, this method can be overridden to call the notifyReceiver() method of each
@@ -47,6 +53,13 @@ protected:
 	// Called for every frame of the game. Much of the main bot logic occurs here.
 	virtual void onFrame() {}
 
+	// Called every frame before onFrame(), possibly on another thread and at the same time
+	// as the analysis of other event receivers. This is meant for expensive work that only
+	// reads the game and shadow units, so it must only modify the members of this class,
+	// and must not issue commands or reserve units, which belong in onFrame(). The work
+	// can be split up further by running it on the given pool.
+	virtual void onAnalyze(TaskPool& pool) {}
+
 	// Like onFrame(), this is called for every frame of the game. However, drawing code
 	// should be placed here rather than in onFrame().
 	virtual void onDraw() {}
@@ -0,0 +1,98 @@
+#include "TypeIndex.h"
+
+void TypeIndex::reset() {
+    m_entries.clear();
+    m_stamps.clear();
+}
+
+void TypeIndex::updateUnit(bw::Unit unit) {
+    if (unit->getPlayer() == nullptr || unit->getPlayer()->getID() < 0) {
+        removeUnit(unit);
+        return;
+    }
+
+    bw::UnitType morphType = bw::UnitTypes::None;
+    if (unit->isMorphing() && unit->getBuildType() != unit->getType()) {
+        morphType = unit->getBuildType();
+    }
+
+    Stamp stamp = { unit->getPlayer()->getID(), unit->getType(), unit->isCompleted(), morphType };
+
+    auto it = m_stamps.find(unit);
+    if (it != m_stamps.end()) {
+        // Most of the time nothing has changed, so there's nothing to do.
+        if (it->second == stamp) {
+            return;
+        }
+        addStamp(unit, it->second, -1);
+        it->second = stamp;
+    } else {
+        m_stamps.emplace(unit, stamp);
+    }
+    addStamp(unit, stamp, 1);
+}
+
+void TypeIndex::removeUnit(bw::Unit unit) {
+    auto it = m_stamps.find(unit);
+    if (it != m_stamps.end()) {
+        addStamp(unit, it->second, -1);
+        m_stamps.erase(it);
+    }
+}
+
+const bw::Unitset& TypeIndex::getUnits(bw::Player player, bw::UnitType type) const {
+    const Entry* entry = findEntry(player, type);
+    return entry != nullptr ? entry->units : bw::Unitset::none;
+}
+
+int TypeIndex::count(bw::Player player, bw::UnitType type) const {
+    const Entry* entry = findEntry(player, type);
+    return entry != nullptr ? (int)entry->units.size() : 0;
+}
+
+int TypeIndex::completedCount(bw::Player player, bw::UnitType type) const {
+    const Entry* entry = findEntry(player, type);
+    return entry != nullptr ? entry->completed : 0;
+}
+
+int TypeIndex::morphingCount(bw::Player player, bw::UnitType type) const {
+    const Entry* entry = findEntry(player, type);
+    return entry != nullptr ? entry->morphing : 0;
+}
+
+const TypeIndex::Entry* TypeIndex::findEntry(bw::Player player, bw::UnitType type) const {
+    if (player == nullptr || player->getID() < 0 || player->getID() >= (int)m_entries.size()) {
+        return nullptr;
+    }
+
+    const std::vector<Entry>& entries = m_entries[player->getID()];
+    if (type.getID() < 0 || type.getID() >= (int)entries.size()) {
+        return nullptr;
+    }
+    return &entries[type.getID()];
+}
+
+void TypeIndex::addStamp(bw::Unit unit, const Stamp& stamp, int delta) {
+    if (stamp.player >= (int)m_entries.size()) {
+        m_entries.resize(stamp.player + 1);
+    }
+
+    std::vector<Entry>& entries = m_entries[stamp.player];
+    if (entries.empty()) {
+        entries.resize(bw::UnitTypes::Enum::MAX);
+    }
+
+    Entry& entry = entries[stamp.type.getID()];
+    if (delta > 0) {
+        entry.units.insert(unit);
+    } else {
+        entry.units.erase(unit);
+    }
+    if (stamp.isCompleted) {
+        entry.completed += delta;
+    }
+
+    if (stamp.morphType != bw::UnitTypes::None) {
+        entries[stamp.morphType.getID()].morphing += delta;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Tools.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Keeps track of the units of each type owned by each player, so that counting them is a
+// single lookup rather than a pass over every unit. Every unit is filed under its player
+// and type, and the index is updated whenever a unit appears, disappears, or changes
+// type, owner, or completion, rather than being recomputed each frame.
+//
+// Units that are morphing into a different type, such as Zerg eggs or a Hydralisk turning
+// into a Lurker, are also counted under the type they will become, since that is usually
+// what matters when deciding whether to make more of a type.
+class TypeIndex {
+private:
+    // The player, type, and state that each unit was last filed under.
+    struct Stamp {
+        int player;
+        bw::UnitType type;
+        bool isCompleted;
+
+        // The type the unit is morphing into, or None if it isn't morphing into another
+        // type. Zerg buildings under construction already have the type they're becoming.
+        bw::UnitType morphType;
+
+        bool operator==(const Stamp& other) const = default;
+    };
+
+    struct Entry {
+        bw::Unitset units;
+        int completed = 0;
+        int morphing = 0;
+    };
+
+    // The entries of each player by player ID and then by type ID, each allocated when
+    // the player's first unit is added.
+    std::vector<std::vector<Entry>> m_entries;
+
+    std::unordered_map<bw::Unit, Stamp> m_stamps;
+
+public:
+    // Removes all units in preparation for a new game.
+    void reset();
+
+    // Files a unit under its current player, type and state, or removes it from the index.
+    void updateUnit(bw::Unit unit);
+    void removeUnit(bw::Unit unit);
+
+    // Gets the units of a type owned by a player, and how many of them there are in
+    // total and how many are completed.
+    const bw::Unitset& getUnits(bw::Player player, bw::UnitType type) const;
+    int count(bw::Player player, bw::UnitType type) const;
+    int completedCount(bw::Player player, bw::UnitType type) const;
+
+    // Gets the number of units of a player that are morphing into a type from some other
+    // type. These aren't included in count().
+    int morphingCount(bw::Player player, bw::UnitType type) const;
+
+private:
+    const Entry* findEntry(bw::Player player, bw::UnitType type) const;
+    void addStamp(bw::Unit unit, const Stamp& stamp, int delta);
+};
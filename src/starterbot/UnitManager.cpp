@@ -1,5 +1,7 @@
 #include "UnitManager.h"
 
+#include <BWAPI/Client.h>
+
 ShadowUnit UnitManager::getShadow(bw::Unit unit) {
     // The shadow unit for a null unit is, shockingly, a null shadow unit.
     if (unit == nullptr) {
@@ -14,7 +16,7 @@ ShadowUnit UnitManager::getShadow(bw::Unit unit) {
 
     // Otherwise, create a new shadow unit object and insert it into the map and set. We
     // don't add it to the player sets because that automatically happens in onFrame().
-    ShadowUnit shadow = &m_shadowMap.emplace(unit->getID(), ShadowUnitImpl(unit)).first->second;
+    ShadowUnit shadow = &m_shadowMap.try_emplace(unit->getID(), m_store, unit).first->second;
     m_shadowUnits.insert(shadow);
 
     return shadow;
@@ -31,149 +33,79 @@ bool UnitManager::isAlive(bw::Unit unit) {
     return m_shadowUnits.contains(getShadow(unit));
 }
 
-bw::Unit UnitManager::matchUnit(const bw::Unitset& units, const bw::UnitFilter& pred) {
-    // Iterate through the set of units and return the first one that matches.
-    for (bw::Unit unit : units) {
-        if (!pred.isValid() || pred(unit)) {
-            return unit;
-        }
-    }
-
-    return nullptr;
+const ShadowStore& UnitManager::getStore() const {
+    return m_store;
 }
 
-bw::Unitset UnitManager::matchUnits(const bw::Unitset& units, const bw::UnitFilter& pred, int count) {
-    bw::Unitset matches;
-
-    for (bw::Unit unit : units) {
-        // If we've already hit the maximum number of units to be returned, exit the loop.
-        if (matches.size() >= count) {
-            break;
-        }
-
-        // Otherwise, add this unit to the matching set if it matches the predicate.
-        if (!pred.isValid() || pred(unit)) {
-            matches.insert(unit);
-        }
-    }
-
-    return matches;
+bool UnitManager::isInBase(bw::Player player, bw::Position pos) const {
+    return m_baseMap.isInBase(player, pos);
 }
 
-int UnitManager::matchCount(const bw::Unitset& units, const bw::UnitFilter& pred) {
-    int count = 0;
+bw::Unitset UnitManager::baseUnits(bw::Player player) {
+    // We keep sets of the units of both players we care about, so there's no need to go
+    // through every shadow unit for them.
+    const bw::Unitset* units = &m_shadowUnits;
+    if (player == g_self) {
+        units = &m_selfUnits;
+    } else if (player == g_game->enemy()) {
+        units = &m_enemyUnits;
+    }
 
-    // Iterate through the set of units and increment the count for each matching unit.
-    for (bw::Unit unit : units) {
-        if (!pred.isValid() || pred(unit)) {
-            count++;
+    bw::Unitset found;
+    for (bw::Unit unit : *units) {
+        if (unit->getPlayer() == player && m_baseMap.isInBase(player, unit->getPosition())) {
+            found.insert(unit);
         }
     }
 
-    return count;
-}
-
-bw::Unit UnitManager::shadowUnit(const bw::UnitFilter& pred) {
-    return matchUnit(m_shadowUnits, pred);
-}
-
-bw::Unitset UnitManager::shadowUnits(const bw::UnitFilter& pred, int count) {
-    return matchUnits(m_shadowUnits, pred, count);
-}
-
-int UnitManager::shadowCount(const bw::UnitFilter& pred) {
-    return matchCount(m_shadowUnits, pred);
-}
-
-bw::Unit UnitManager::selfUnit(const bw::UnitFilter& pred) {
-    return matchUnit(m_selfUnits, pred);
-}
-
-bw::Unitset UnitManager::selfUnits(const bw::UnitFilter& pred, int count) {
-    return matchUnits(m_selfUnits, pred, count);
-}
-
-int UnitManager::selfCount(const bw::UnitFilter& pred) {
-    return matchCount(m_selfUnits, pred);
-}
-
-bw::Unit UnitManager::enemyUnit(const bw::UnitFilter& pred) {
-    return matchUnit(m_enemyUnits, pred);
-}
-
-bw::Unitset UnitManager::enemyUnits(const bw::UnitFilter& pred, int count) {
-    return matchUnits(m_enemyUnits, pred, count);
-}
-
-int UnitManager::enemyCount(const bw::UnitFilter& pred) {
-    return matchCount(m_enemyUnits, pred);
+    return found;
 }
 
-bw::Unit UnitManager::borrowUnit(const bw::UnitFilter& pred) {
-    return matchUnit(m_freeUnits, pred);
+bool UnitManager::isFree(bw::Unit unit) const {
+    return m_freeUnits.contains(unit);
 }
 
-bw::Unitset UnitManager::borrowUnits(const bw::UnitFilter& pred, int count) {
-    return matchUnits(m_freeUnits, pred, count);
+const bw::Unitset& UnitManager::typeUnits(bw::Player player, bw::UnitType type) const {
+    return m_typeIndex.getUnits(player, type);
 }
 
-int UnitManager::borrowCount(const bw::UnitFilter& pred) {
-    return matchCount(m_freeUnits, pred);
+int UnitManager::typeCount(bw::Player player, bw::UnitType type) const {
+    return m_typeIndex.count(player, type);
 }
 
-bw::Unit UnitManager::reserveUnit(const bw::UnitFilter& pred) {
-    // Try to find a free unit that matches the predicate.
-    bw::Unit unit = matchUnit(m_freeUnits, pred);
-
-    // If we found a suitable match, remove it from the set of free units.
-    if (unit != nullptr) {
-        m_freeUnits.erase(unit);
-    }
-
-    return unit;
-}
-
-bw::Unitset UnitManager::reserveUnits(const bw::UnitFilter& pred, int count) {
-    // Find all free units that match the predicate up to the maximum.
-    bw::Unitset units = matchUnits(m_freeUnits, pred, count);
-
-    // Remove each matched unit from the set of free units.
-    for (bw::Unit unit : units) {
-        m_freeUnits.erase(unit);
-    }
-
-    return units;
+int UnitManager::completedCount(bw::Player player, bw::UnitType type) const {
+    return m_typeIndex.completedCount(player, type);
 }
 
-void UnitManager::releaseUnit(bw::Unit& unit, const bw::UnitFilter& pred) {
-    // If the unit to be potentially released matches the predicate, add it back to the
-    // set of free units and set the reference to the released unit to nullptr.
-    if (!pred.isValid() || pred(unit)) {
-        m_freeUnits.insert(unit);
-        unit = nullptr;
-    }
+int UnitManager::morphingCount(bw::Player player, bw::UnitType type) const {
+    return m_typeIndex.morphingCount(player, type);
 }
 
-void UnitManager::releaseUnits(bw::Unitset& units, const bw::UnitFilter& pred) {
-    // Iterate through the set of units to be potentially released.
-    for (auto it = units.begin(); it != units.end();) {
-        bw::Unit unit = *it;
+void UnitManager::updateUnit(bw::Unit unit) {
+    ShadowUnit shadow = getShadow(unit);
+    shadow->updateFields();
+    m_baseMap.updateUnit(shadow);
+    m_typeIndex.updateUnit(shadow);
 
-        // If the unit matches the predicate, add it back to the set of free units and
-        // remove the now-released unit from the set. We have to update the iterator here
-        // since iterators to erased elements are invalidated.
-        if (!pred.isValid() || pred(unit)) {
-            m_freeUnits.insert(unit);
-            it = units.erase(it);
-        } else {
-            ++it;
-        }
+    // Units may change players in the middle of the game, including to and from the
+    // neutral player, such as when a refinery is placed on a vespene gas geyser.
+    if (shadow->getPlayer() == g_self) {
+        m_selfUnits.insert(shadow);
+        m_enemyUnits.erase(shadow);
+    } else if (shadow->getPlayer() == g_game->enemy()) {
+        m_selfUnits.erase(shadow);
+        m_enemyUnits.insert(shadow);
+    } else {
+        m_selfUnits.erase(shadow);
+        m_enemyUnits.erase(shadow);
     }
 }
 
 void UnitManager::onStart() {
-    // Now that a new game has started, we need to clear out all the old units.
+    // Now that a new game has started, we need to clear out all the old units. The
+    // shadow units release their rows, so they must be cleared before the store.
     m_shadowMap.clear();
+    m_store.clear();
 
     m_shadowUnits.clear();
     m_selfUnits.clear();
@@ -181,36 +113,53 @@ void UnitManager::onStart() {
 
     m_freeUnits.clear();
 
+    m_baseMap.reset(g_game->mapWidth(), g_game->mapHeight());
+    m_typeIndex.reset();
+
     // When the game starts, create shadow units for every unit that is initially known to
     // exist in the game.
     for (bw::Unit unit : g_game->getStaticNeutralUnits()) {
         getShadow(unit);
     }
+
+    // In incremental mode, the player sets are only touched by unit events, so sort the
+    // units we can already see in case their discover events were sent before ours.
+    if (INCREMENTAL_UPDATE) {
+        for (bw::Unit unit : g_game->getAllUnits()) {
+            updateUnit(unit);
+        }
+    }
 }
 
 void UnitManager::onFrame() {
-    // Every frame, create a shadow unit for any units that don't currently have one.
-    for (bw::Unit unit : g_game->getAllUnits()) {
-        bw::Unit shadow = getShadow(unit);
-
-        // Units may change players in the middle of the game, including to and from the
-        // neutral player, such as when a refinery is placed on a vespene gas geyser. So,
-        // we update the player sets every frame for each known unit.
-        if (shadow->getPlayer() == g_self) {
-            m_selfUnits.insert(shadow);
-            m_enemyUnits.erase(shadow);
-        } else if (shadow->getPlayer() == g_game->enemy()) {
-            m_selfUnits.erase(shadow);
-            m_enemyUnits.insert(shadow);
-        } else {
-            m_selfUnits.erase(shadow);
-            m_enemyUnits.erase(shadow);
+    if (INCREMENTAL_UPDATE) {
+        // BWAPI tells us which units changed since the last frame, so only those shadow
+        // units need their fields copied. Player sets are kept current by the events.
+        const bw::Unitset& changed =
+            static_cast<bw::GameImpl*>(bw::BroodwarPtr)->getChangedUnits();
+        for (bw::Unit unit : changed) {
+            // Units we have never been told about don't get a shadow unit here, since
+            // that would make them count as alive.
+            auto it = m_shadowMap.find(unit->getID());
+            if (it != m_shadowMap.end()) {
+                it->second.updateFields();
+
+                // Destroyed units stay out of the base map and the index even if their
+                // fields change.
+                if (m_shadowUnits.contains(&it->second)) {
+                    m_baseMap.updateUnit(&it->second);
+                    m_typeIndex.updateUnit(&it->second);
+                }
+            }
         }
+        return;
     }
 
-    // Update the fields for every shadow unit that is currently visible.
-    for (auto& entry : m_shadowMap) {
-        entry.second.updateFields();
+    // Otherwise, create a shadow unit for any units that don't currently have one and
+    // update the fields and player sets of every unit that is currently visible. Shadow
+    // units of invisible units keep their old fields, so they don't need to be visited.
+    for (bw::Unit unit : g_game->getAllUnits()) {
+        updateUnit(unit);
     }
 }
 
@@ -231,4 +180,28 @@ void UnitManager::onUnitDestroy(bw::Unit unit) {
     m_enemyUnits.erase(shadow);
 
     m_freeUnits.erase(unit);
+
+    m_baseMap.removeUnit(shadow);
+    m_typeIndex.removeUnit(shadow);
+}
+
+void UnitManager::onUnitMorph(bw::Unit unit) {
+    // Morphing a vespene geyser into a refinery changes its owner.
+    if (INCREMENTAL_UPDATE) {
+        updateUnit(unit);
+    }
+}
+
+void UnitManager::onUnitRenegade(bw::Unit unit) {
+    if (INCREMENTAL_UPDATE) {
+        updateUnit(unit);
+    }
+}
+
+void UnitManager::onUnitDiscover(bw::Unit unit) {
+    // Every unit becomes accessible through a discover event before we can see it, so
+    // this is where new shadow units are created and sorted into the player sets.
+    if (INCREMENTAL_UPDATE) {
+        updateUnit(unit);
+    }
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "BaseMap.h"
 #include "ShadowUnit.h"
 #include "Tools.h"
+#include "TypeIndex.h"
 
 #include <climits>
+#include <type_traits>
 #include <unordered_map>
 
 // Since BWAPI only does the bare minimum in making units available to the bot, this class
@@ -21,6 +24,15 @@
 // reserved by another manager.
 class UnitManager : public EventReceiver {
 private:
+    // When true, set membership is updated from unit events and onFrame() only refreshes
+    // the shadow units whose real unit changed this frame. When false, every known unit is
+    // rescanned every frame, which is slower but doesn't rely on BWAPI's change tracking.
+    static constexpr bool INCREMENTAL_UPDATE = true;
+
+    // The column store holding the saved fields of every shadow unit. This must be
+    // declared before m_shadowMap so that the shadow units are destroyed first.
+    ShadowStore m_store;
+
     // A map from unit IDs to the shadow unit objects maintained by UnitManager. Once a
     // unit is added to this map, it must not be removed until a new game is started in
     // order to ensure that ShadowUnit pointers stay valid.
@@ -35,6 +47,12 @@ private:
     // The set of all completed units that have not been reserved by any manager class.
     bw::Unitset m_freeUnits;
 
+    // The areas covered by each player's bases, kept up to date as shadow units change.
+    BaseMap m_baseMap;
+
+    // The shadow units of each player sorted by type, kept up to date in the same way.
+    TypeIndex m_typeIndex;
+
 public:
     // Gets the shadow unit corresponding to a normal unit. If (for some reason) no shadow
     // unit exists yet, it will create one. Calling getShadow() on a shadow unit returns
@@ -53,60 +71,287 @@ public:
     // method will still return true for such units.
     bool isAlive(bw::Unit unit);
 
+    // Gets the store holding the fields of every shadow unit, which can be scanned
+    // linearly by loops that look at many units.
+    const ShadowStore& getStore() const;
+
+    // Checks whether a position is within BaseMap::BASE_RADIUS of any known building of a
+    // player, and gets the shadow units of that player that are. These only look up the
+    // tile of each position rather than measuring the distance to every building.
+    bool isInBase(bw::Player player, bw::Position pos) const;
+    bw::Unitset baseUnits(bw::Player player);
+
+    // Gets the shadow units of a type owned by a player and counts them, optionally only
+    // the completed ones. These are looked up in an index rather than going through every
+    // unit, so they can be used freely every frame in place of a GetType filter.
+    const bw::Unitset& typeUnits(bw::Player player, bw::UnitType type) const;
+    int typeCount(bw::Player player, bw::UnitType type) const;
+    int completedCount(bw::Player player, bw::UnitType type) const;
+
+    // Counts the units of a player that are morphing into a type from another type, such
+    // as Zerg eggs, which typeCount() doesn't include. Adding the two gives the same count
+    // as the filter (GetType == type || (BuildType == type && IsMorphing)).
+    int morphingCount(bw::Player player, bw::UnitType type) const;
+
     // A static function for matching a single unit out of a set of units according to a
-    // predicate. If the predicate is nullptr, any unit will match. If multiple units
+    // predicate. The predicate may be a bw::UnitFilter or any filter expression built from
+    // the bw::Filter constants, which is evaluated inline rather than being wrapped in a
+    // bw::UnitFilter first. If the predicate is nullptr, any unit will match. If multiple units
     // match the criteria, it is unspecified which unit will be returned. If no units
     // match the critera, nullptr will be returned.
-    static bw::Unit matchUnit(const bw::Unitset& units, const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    static bw::Unit matchUnit(const bw::Unitset& units, const Pred& pred = nullptr);
 
     // Similar to matchUnit(), but returns a set containing all units that match the
     // predicate up to a maximum count of units. The default maximum is unlimited.
+    template <typename Pred = bw::UnitFilter>
     static bw::Unitset matchUnits(const bw::Unitset& units,
-        const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
+        const Pred& pred = nullptr, int count = INT_MAX);
 
     // A complement to matchUnits() that just counts how many units match the specified
     // predicate without building up a set of units.
-    static int matchCount(const bw::Unitset& units, const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    static int matchCount(const bw::Unitset& units, const Pred& pred = nullptr);
 
     // These functions query any shadow unit that matches the given predicate.
-    bw::Unit shadowUnit(const bw::UnitFilter& pred = nullptr);
-    bw::Unitset shadowUnits(const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
-    int shadowCount(const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unit shadowUnit(const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unitset shadowUnits(const Pred& pred = nullptr, int count = INT_MAX);
+    template <typename Pred = bw::UnitFilter>
+    int shadowCount(const Pred& pred = nullptr);
 
     // These functions query shadow units that are owned by the current (g_self) player.
-    bw::Unit selfUnit(const bw::UnitFilter& pred = nullptr);
-    bw::Unitset selfUnits(const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
-    int selfCount(const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unit selfUnit(const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unitset selfUnits(const Pred& pred = nullptr, int count = INT_MAX);
+    template <typename Pred = bw::UnitFilter>
+    int selfCount(const Pred& pred = nullptr);
 
     // These functions query shadow units that are owned by the enemy player.
-    bw::Unit enemyUnit(const bw::UnitFilter& pred = nullptr);
-    bw::Unitset enemyUnits(const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
-    int enemyCount(const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unit enemyUnit(const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unitset enemyUnits(const Pred& pred = nullptr, int count = INT_MAX);
+    template <typename Pred = bw::UnitFilter>
+    int enemyCount(const Pred& pred = nullptr);
+
+    // Checks whether a unit is completed, owned by the player, and not currently reserved
+    // by any manager, meaning it would be matched by borrowUnits().
+    bool isFree(bw::Unit unit) const;
 
     // These functions match units that are not currently reserved by any manager. This is
     // useful for giving units a temporary command to perform, such as mining minerals.
     // Unlike reserved units, borrowed units may be reserved or borrowed at any time by
     // another manager and given a new task.
-    bw::Unit borrowUnit(const bw::UnitFilter& pred = nullptr);
-    bw::Unitset borrowUnits(const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
-    int borrowCount(const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unit borrowUnit(const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unitset borrowUnits(const Pred& pred = nullptr, int count = INT_MAX);
+    template <typename Pred = bw::UnitFilter>
+    int borrowCount(const Pred& pred = nullptr);
 
     // These functions reserve units that are not currently reserved by any manager by
     // removing them from the set of free units. The reserving manager is free to give
     // these units any command without fear of another manager messing with them. Reserved
     // units remain reserved until releaseUnits() is called on them. Future calls to
     // borrowUnits() and reserveUnits() will not return any currently reserved units.
-    bw::Unit reserveUnit(const bw::UnitFilter& pred = nullptr);
-    bw::Unitset reserveUnits(const bw::UnitFilter& pred = nullptr, int count = INT_MAX);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unit reserveUnit(const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    bw::Unitset reserveUnits(const Pred& pred = nullptr, int count = INT_MAX);
 
     // Releases currently reserved units. It is up to each manager to keep track of its
     // own reserved units and decide if and when to release them.
-    void releaseUnit(bw::Unit& unit, const bw::UnitFilter& pred = nullptr);
-    void releaseUnits(bw::Unitset& units, const bw::UnitFilter& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    void releaseUnit(bw::Unit& unit, const Pred& pred = nullptr);
+    template <typename Pred = bw::UnitFilter>
+    void releaseUnits(bw::Unitset& units, const Pred& pred = nullptr);
 
 protected:
     virtual void onStart() override;
     virtual void onFrame() override;
     virtual void onUnitComplete(bw::Unit unit) override;
     virtual void onUnitDestroy(bw::Unit unit) override;
-};
\ No newline at end of file
+    virtual void onUnitMorph(bw::Unit unit) override;
+    virtual void onUnitRenegade(bw::Unit unit) override;
+    virtual void onUnitDiscover(bw::Unit unit) override;
+
+private:
+    // Checks whether a unit matches a predicate, where an empty predicate or a literal
+    // nullptr matches any unit.
+    template <typename Pred>
+    static bool isMatch(const Pred& pred, bw::Unit unit) {
+        if constexpr (std::is_null_pointer_v<Pred>) {
+            return true;
+        } else if constexpr (requires { pred.isValid(); }) {
+            return !pred.isValid() || pred(unit);
+        } else {
+            return pred(unit);
+        }
+    }
+
+    // Refreshes the fields of a unit's shadow and moves it into the player set matching
+    // its current owner.
+    void updateUnit(bw::Unit unit);
+};
+
+template <typename Pred>
+bw::Unit UnitManager::matchUnit(const bw::Unitset& units, const Pred& pred) {
+    // Iterate through the set of units and return the first one that matches.
+    for (bw::Unit unit : units) {
+        if (isMatch(pred, unit)) {
+            return unit;
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::matchUnits(const bw::Unitset& units, const Pred& pred, int count) {
+    bw::Unitset matches;
+
+    for (bw::Unit unit : units) {
+        // If we've already hit the maximum number of units to be returned, exit the loop.
+        if ((int)matches.size() >= count) {
+            break;
+        }
+
+        // Otherwise, add this unit to the matching set if it matches the predicate.
+        if (isMatch(pred, unit)) {
+            matches.insert(unit);
+        }
+    }
+
+    return matches;
+}
+
+template <typename Pred>
+int UnitManager::matchCount(const bw::Unitset& units, const Pred& pred) {
+    int count = 0;
+
+    // Iterate through the set of units and increment the count for each matching unit.
+    for (bw::Unit unit : units) {
+        if (isMatch(pred, unit)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+template <typename Pred>
+bw::Unit UnitManager::shadowUnit(const Pred& pred) {
+    return matchUnit(m_shadowUnits, pred);
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::shadowUnits(const Pred& pred, int count) {
+    return matchUnits(m_shadowUnits, pred, count);
+}
+
+template <typename Pred>
+int UnitManager::shadowCount(const Pred& pred) {
+    return matchCount(m_shadowUnits, pred);
+}
+
+template <typename Pred>
+bw::Unit UnitManager::selfUnit(const Pred& pred) {
+    return matchUnit(m_selfUnits, pred);
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::selfUnits(const Pred& pred, int count) {
+    return matchUnits(m_selfUnits, pred, count);
+}
+
+template <typename Pred>
+int UnitManager::selfCount(const Pred& pred) {
+    return matchCount(m_selfUnits, pred);
+}
+
+template <typename Pred>
+bw::Unit UnitManager::enemyUnit(const Pred& pred) {
+    return matchUnit(m_enemyUnits, pred);
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::enemyUnits(const Pred& pred, int count) {
+    return matchUnits(m_enemyUnits, pred, count);
+}
+
+template <typename Pred>
+int UnitManager::enemyCount(const Pred& pred) {
+    return matchCount(m_enemyUnits, pred);
+}
+
+template <typename Pred>
+bw::Unit UnitManager::borrowUnit(const Pred& pred) {
+    return matchUnit(m_freeUnits, pred);
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::borrowUnits(const Pred& pred, int count) {
+    return matchUnits(m_freeUnits, pred, count);
+}
+
+template <typename Pred>
+int UnitManager::borrowCount(const Pred& pred) {
+    return matchCount(m_freeUnits, pred);
+}
+
+template <typename Pred>
+bw::Unit UnitManager::reserveUnit(const Pred& pred) {
+    // Try to find a free unit that matches the predicate.
+    bw::Unit unit = matchUnit(m_freeUnits, pred);
+
+    // If we found a suitable match, remove it from the set of free units.
+    if (unit != nullptr) {
+        m_freeUnits.erase(unit);
+    }
+
+    return unit;
+}
+
+template <typename Pred>
+bw::Unitset UnitManager::reserveUnits(const Pred& pred, int count) {
+    // Find all free units that match the predicate up to the maximum.
+    bw::Unitset units = matchUnits(m_freeUnits, pred, count);
+
+    // Remove each matched unit from the set of free units.
+    for (bw::Unit unit : units) {
+        m_freeUnits.erase(unit);
+    }
+
+    return units;
+}
+
+template <typename Pred>
+void UnitManager::releaseUnit(bw::Unit& unit, const Pred& pred) {
+    // If the unit to be potentially released matches the predicate, add it back to the
+    // set of free units and set the reference to the released unit to nullptr.
+    if (isMatch(pred, unit)) {
+        m_freeUnits.insert(unit);
+        unit = nullptr;
+    }
+}
+
+template <typename Pred>
+void UnitManager::releaseUnits(bw::Unitset& units, const Pred& pred) {
+    // Iterate through the set of units to be potentially released.
+    for (auto it = units.begin(); it != units.end();) {
+        bw::Unit unit = *it;
+
+        // If the unit matches the predicate, add it back to the set of free units and
+        // remove the now-released unit from the set. We have to update the iterator here
+        // since iterators to erased elements are invalidated.
+        if (isMatch(pred, unit)) {
+            m_freeUnits.insert(unit);
+            it = units.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
\ No newline at end of file
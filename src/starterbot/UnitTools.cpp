@@ -74,103 +74,318 @@ bw::Unit getClosestUnit(const bw::Unitset& units, bw::Position pos) {
     return minUnit;
 }
 
-struct ClusterDistance {
-    Cluster* cluster;
-    int distance;
-};
-
-static ClusterDistance getClosestCentroid(
-        std::vector<Cluster>& clusters, bw::Unit unit, int maxSize, int maxIndex) {
-    // Initially set the minimum distance to the maximal integer value, which any centroid
-    // will match as closer than.
-    Cluster* minCluster = nullptr;
+bw::Unit getClosestUnitByGround(const bw::Unitset& units, bw::Position pos) {
+    bw::Unit minUnit = nullptr;
     int minDistance = INT_MAX;
 
-    for (int index = 0; index < maxIndex; index++) {
-        Cluster& cluster = clusters[index];
+    for (bw::Unit unit : units) {
+        int distance = g_game->getGroundDistance(pos, unit->getPosition());
+
+        if (distance >= 0 && distance < minDistance) {
+            minUnit = unit;
+            minDistance = distance;
+        }
+    }
+
+    return minUnit;
+}
+
+UnitClusterer::UnitClusterer(int desiredSize, int maxSize) :
+    m_desiredSize(desiredSize),
+    m_maxSize(maxSize) {
+}
+
+void UnitClusterer::clear() {
+    m_units.clear();
+    m_positions.clear();
+    m_assignment.clear();
+    m_index.clear();
+
+    m_clusters.clear();
+    m_sizes.clear();
+    m_changed.clear();
+}
+
+void UnitClusterer::remove(bw::Unit unit) {
+    auto it = m_index.find(unit);
+    if (it == m_index.end()) {
+        return;
+    }
+
+    int member = it->second;
+    if (m_assignment[member] >= 0) {
+        m_clusters[m_assignment[member]].units.erase(unit);
+    }
+
+    removeMember(member);
+}
+
+const std::vector<Cluster>& UnitClusterer::update(const bw::Unitset& units) {
+    updateMembers(units);
+
+    // Get the position of every unit once, since they're needed many times over.
+    m_current.resize(m_units.size());
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        m_current[i] = m_units[i]->getPosition();
+    }
+
+    // If clusters were added or removed, any unit may now be closest to a different one,
+    // so they all need to be reassigned. Otherwise, only units that aren't assigned yet
+    // or moved far enough to possibly be closer to another centroid are.
+    bool reassignAll = updateClusterCount();
+
+    m_reassign.clear();
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        if (reassignAll || m_assignment[i] < 0 ||
+                !isInRadius(m_current[i], m_positions[i], MOVE_THRESHOLD)) {
+            m_reassign.push_back(i);
+        }
+    }
+
+    // Now, we refine the clusters like the regular k-means algorithm, except that only
+    // the units of clusters whose centroids moved are reassigned in the next iteration.
+    // Since we start from the previous clustering, this usually settles down in just one
+    // or two iterations.
+    for (int iter = 0; iter < MAX_ITER; iter++) {
+        if (!m_reassign.empty()) {
+            reassignUnits();
+        }
+
+        std::vector<int> moved = computeCentroids();
+        if (moved.empty()) {
+            break;
+        }
+
+        std::vector<bool> isMoved(m_clusters.size(), false);
+        for (int cluster : moved) {
+            isMoved[cluster] = true;
+        }
+
+        m_reassign.clear();
+        for (int i = 0; i < (int)m_units.size(); i++) {
+            if (m_assignment[i] >= 0 && isMoved[m_assignment[i]]) {
+                m_reassign.push_back(i);
+            }
+        }
+    }
 
-        // If this cluster is already full, we can't assign any units to it, so move on.
-        if (cluster.units.size() >= maxSize) {
+    buildClusterSets();
+    return m_clusters;
+}
+
+void UnitClusterer::updateMembers(const bw::Unitset& units) {
+    // Add any units we haven't seen before, and mark which of our existing units are
+    // still in the set.
+    m_seen.assign(m_units.size(), false);
+
+    for (bw::Unit unit : units) {
+        auto it = m_index.find(unit);
+        if (it != m_index.end()) {
+            m_seen[it->second] = true;
             continue;
         }
 
-        // Get the distance between this unit and the centroid of the cluster we're
-        // looking at. If it's smaller than any distance we've found before, select this
-        // as the closest cluster so far.
-        int distance = getSquaredDistance(cluster.centroid, unit->getPosition());
+        m_index.emplace(unit, (int)m_units.size());
+        m_units.push_back(unit);
+        m_positions.push_back(unit->getPosition());
+        m_assignment.push_back(-1);
+        m_seen.push_back(true);
+    }
 
-        if (distance < minDistance) {
-            minCluster = &cluster;
-            minDistance = distance;
+    // Remove the units that are no longer in the set, moving the last unit's mark along
+    // with it.
+    for (int i = 0; i < (int)m_units.size();) {
+        if (m_seen[i]) {
+            i++;
+            continue;
         }
+
+        m_seen[i] = m_seen.back();
+        m_seen.pop_back();
+        removeMember(i);
+    }
+}
+
+void UnitClusterer::removeMember(int member) {
+    unassign(member);
+    m_index.erase(m_units[member]);
+
+    int last = (int)m_units.size() - 1;
+    if (member != last) {
+        m_units[member] = m_units[last];
+        m_positions[member] = m_positions[last];
+        m_assignment[member] = m_assignment[last];
+        m_index[m_units[member]] = member;
     }
 
-    return { minCluster, minDistance };
+    m_units.pop_back();
+    m_positions.pop_back();
+    m_assignment.pop_back();
 }
 
-static ClusterDistance getClosestCentroid(
-        std::vector<Cluster>& clusters, bw::Unit unit, int maxSize) {
-    // Usually, we want the closest distance to any cluster, not a subset of the clusters.
-    return getClosestCentroid(clusters, unit, maxSize, (int)clusters.size());
+bool UnitClusterer::updateClusterCount() {
+    // Choose an appropriate amount of clusters given the desired average cluster size.
+    int count = ((int)m_units.size() / m_desiredSize) + 1;
+    int current = (int)m_clusters.size();
+
+    if (count == current) {
+        return false;
+    } else if (count > current) {
+        addCentroids(count - current);
+        return true;
+    }
+
+    // We have too many clusters, so drop the ones with the fewest units, leaving their
+    // units to be reassigned. The rest keep their order.
+    std::vector<int> order(current);
+    for (int c = 0; c < current; c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int left, int right) {
+        return m_sizes[left] < m_sizes[right];
+    });
+
+    std::vector<bool> dropped(current, false);
+    for (int i = 0; i < current - count; i++) {
+        dropped[order[i]] = true;
+    }
+
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        if (m_assignment[i] >= 0 && dropped[m_assignment[i]]) {
+            unassign(i);
+        }
+    }
+
+    std::vector<int> remap(current, -1);
+    int next = 0;
+    for (int c = 0; c < current; c++) {
+        if (dropped[c]) {
+            continue;
+        }
+
+        remap[c] = next;
+        m_clusters[next] = std::move(m_clusters[c]);
+        m_sizes[next] = m_sizes[c];
+        m_changed[next] = m_changed[c];
+        next++;
+    }
+
+    m_clusters.resize(count);
+    m_sizes.resize(count);
+    m_changed.resize(count);
+
+    for (int& cluster : m_assignment) {
+        if (cluster >= 0) {
+            cluster = remap[cluster];
+        }
+    }
+
+    return true;
 }
 
-static void chooseInitialCentroids(
-        std::vector<Cluster>& clusters, const bw::Unitset& units, int maxSize) {
+void UnitClusterer::addCentroids(int count) {
     // We use a somewhat modified version of the k-means++ choice of initial centroids:
     // instead of randomly choosing a position with probability proportional to the
     // squared distance to the nearest centroid, we deterministically choose the position
     // with the largest such distance. This keeps our clusterings stable across frames.
-    for (int index = 0; index < clusters.size(); index++) {
+    // The distance from each unit to its nearest centroid is kept as centroids are added,
+    // so each new centroid only needs to be compared against once.
+    // Units without a valid position, such as loaded ones, can't be centroids.
+    std::vector<int> closest(m_units.size(), INT_MAX);
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        if (!m_current[i].isValid()) {
+            continue;
+        }
+
+        for (const Cluster& cluster : m_clusters) {
+            closest[i] = std::min(closest[i], getSquaredDistance(cluster.centroid, m_current[i]));
+        }
+    }
+
+    for (int added = 0; added < count; added++) {
         // Set the maximal distance to the minimal integer value, which every distance
         // will be greater than.
         bw::Position maxPosition = bw::Positions::Origin;
         int maxDistance = INT_MIN;
 
-        for (bw::Unit unit : units) {
-            // Find the distance from this unit to the nearest centroid. If we don't have
-            // any centroids yet, choose the unit that is farthest away from the origin.
-            int distance;
-            if (index == 0) {
-                distance = getSquaredDistance(unit->getPosition(), bw::Positions::Origin);
-            } else {
-                distance = getClosestCentroid(clusters, unit, maxSize, index).distance;
+        for (int i = 0; i < (int)m_units.size(); i++) {
+            if (!m_current[i].isValid()) {
+                continue;
             }
 
-            // If this distance is larger than any one we've seen before, choose it as our
-            // best initial guess for a centroid so far.
+            // If we don't have any centroids yet, choose the unit that is farthest away
+            // from the origin.
+            int distance = m_clusters.empty() ?
+                getSquaredDistance(m_current[i], bw::Positions::Origin) : closest[i];
+
             if (distance > maxDistance) {
-                maxPosition = unit->getPosition();
+                maxPosition = m_current[i];
                 maxDistance = distance;
             }
         }
 
-        clusters[index].centroid = maxPosition;
+        m_clusters.push_back({ bw::Unitset(), maxPosition });
+        m_sizes.push_back(0);
+        m_changed.push_back(true);
+
+        for (int i = 0; i < (int)m_units.size(); i++) {
+            if (m_current[i].isValid()) {
+                closest[i] = std::min(closest[i], getSquaredDistance(maxPosition, m_current[i]));
+            }
+        }
+    }
+}
+
+void UnitClusterer::unassign(int member) {
+    int cluster = m_assignment[member];
+    if (cluster >= 0) {
+        m_sizes[cluster]--;
+        m_changed[cluster] = true;
+        m_assignment[member] = -1;
     }
 }
 
+void UnitClusterer::assign(int member, int cluster) {
+    m_assignment[member] = cluster;
+    m_sizes[cluster]++;
+    m_changed[cluster] = true;
+}
+
 struct UnitDistance {
-    bw::Unit unit;
-    ClusterDistance closest;
+    int member;
+    int cluster;
+    int distance;
 };
 
 static bool compareDistances(const UnitDistance& left, const UnitDistance& right) {
     // Compare the distances directly. Strangely, the STL uses a less than comparison to
     // implement a max heap, so we have to use a greater than comparison for a min heap.
-    return left.closest.distance > right.closest.distance;
+    return left.distance > right.distance;
 }
 
-static void repopulateClusters(
-        std::vector<Cluster>& clusters, const bw::Unitset& units, int maxSize) {
-    // First, we clear out our old clusters so we can regenerate them.
-    for (Cluster& cluster : clusters) {
-        cluster.units.clear();
+void UnitClusterer::reassignUnits() {
+    // First, we take the units out of their old clusters so that they don't count towards
+    // the cluster sizes.
+    for (int member : m_reassign) {
+        unassign(member);
+        m_positions[member] = m_current[member];
     }
 
+    buildGrid();
+
     // Compute the distance between each unit and its closest centroid and insert these
-    // into a vector that will be made into a priority queue.
+    // into a vector that will be made into a priority queue. Units without a valid
+    // position stay unassigned, since the grid would clamp them to an edge cell where the
+    // ring search can't bound their distance.
     std::vector<UnitDistance> queue;
-    for (bw::Unit unit : units) {
-        queue.push_back({ unit, getClosestCentroid(clusters, unit, maxSize) });
+    for (int member : m_reassign) {
+        if (!m_current[member].isValid()) {
+            continue;
+        }
+
+        UnitDistance dist = { member, -1, 0 };
+        dist.cluster = findClosestCluster(m_current[member], dist.distance);
+        queue.push_back(dist);
     }
 
     std::make_heap(queue.begin(), queue.end(), &compareDistances);
@@ -184,15 +399,18 @@ static void repopulateClusters(
         UnitDistance dist = queue.back();
         queue.pop_back();
 
-        if (dist.closest.cluster->units.size() < maxSize) {
+        if (dist.cluster < 0) {
+            // Every cluster is full, which can't happen with a sane maximum size.
+            continue;
+        } else if (m_sizes[dist.cluster] < m_maxSize) {
             // If the cluster this unit has been assigned to has not been filled yet, add
             // the unit to the cluster.
-            dist.closest.cluster->units.insert(dist.unit);
+            assign(dist.member, dist.cluster);
         } else {
             // Otherwise, we need to recompute which cluster this unit should be assigned
             // to. After doing so, push the unit back into the priority queue so that
             // units with a closer distance have a chance to be added to a cluster first.
-            dist.closest = getClosestCentroid(clusters, dist.unit, maxSize);
+            dist.cluster = findClosestCluster(m_current[dist.member], dist.distance);
 
             queue.push_back(dist);
             std::push_heap(queue.begin(), queue.end(), &compareDistances);
@@ -200,35 +418,139 @@ static void repopulateClusters(
     }
 }
 
-static void computeNewCentroids(std::vector<Cluster>& clusters) {
-    // All the clusters have been populated, so we need to recompute the centroids of
-    // these clusters. We do so by averaging the positions of all the units.
-    for (Cluster& cluster : clusters) {
-        cluster.centroid = cluster.units.getPosition();
+std::vector<int> UnitClusterer::computeCentroids() {
+    // The centroid of each cluster is the average position of its units. Empty clusters
+    // keep their centroid so that they can pick up units again.
+    std::vector<bw::Position> sums(m_clusters.size(), bw::Position(0, 0));
+    std::vector<int> counts(m_clusters.size(), 0);
+
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        int cluster = m_assignment[i];
+        if (cluster >= 0 && m_current[i].isValid()) {
+            sums[cluster] += m_current[i];
+            counts[cluster]++;
+        }
     }
+
+    std::vector<int> moved;
+    for (int c = 0; c < (int)m_clusters.size(); c++) {
+        if (counts[c] == 0) {
+            continue;
+        }
+
+        bw::Position centroid = sums[c] / counts[c];
+        if (!isInRadius(centroid, m_clusters[c].centroid, MOVE_THRESHOLD)) {
+            moved.push_back(c);
+        }
+        m_clusters[c].centroid = centroid;
+    }
+
+    return moved;
 }
 
-std::vector<Cluster> findUnitClusters(const bw::Unitset& units, int desiredSize, int maxSize) {
-    // We could iterate the k-means++ algorithm until we converge to a set of clusters,
-    // but that's really unnecessary for our purposes. Instead, iterate a fixed number of
-    // times, which gives us a good enough clustering.
-    constexpr int MAX_ITER = 5;
+static int toCell(int coord, int cells, int cellSize) {
+    return std::clamp(coord / cellSize, 0, cells - 1);
+}
 
-    std::vector<Cluster> clusters;
+void UnitClusterer::buildGrid() {
+    m_gridWidth = std::max((g_game->mapWidth() * 32 + CELL_SIZE - 1) / CELL_SIZE, 1);
+    m_gridHeight = std::max((g_game->mapHeight() * 32 + CELL_SIZE - 1) / CELL_SIZE, 1);
 
-    // Choose an appropriate amount of clusters given the desired average cluster size.
-    clusters.resize((units.size() / desiredSize) + 1);
+    // Sort the centroids by cell with a counting sort, so each cell's centroids are in
+    // one contiguous range of m_cellCentroids.
+    m_cellStart.assign(m_gridWidth * m_gridHeight + 1, 0);
+    std::vector<int> cells(m_clusters.size());
 
-    // We choose a set of initial centroid for our algorithm to work with. Having a smart
-    // initial guess is critical to finding a good clustering.
-    chooseInitialCentroids(clusters, units, maxSize);
+    for (int c = 0; c < (int)m_clusters.size(); c++) {
+        bw::Position pos = m_clusters[c].centroid;
+        cells[c] = toCell(pos.y, m_gridHeight, CELL_SIZE) * m_gridWidth +
+            toCell(pos.x, m_gridWidth, CELL_SIZE);
+        m_cellStart[cells[c] + 1]++;
+    }
+    for (int cell = 0; cell < m_gridWidth * m_gridHeight; cell++) {
+        m_cellStart[cell + 1] += m_cellStart[cell];
+    }
 
-    // Now, we iterate the algorithm for our fixed number of steps, repopulating the
-    // cluster sets each iteration and choosing new centroids based on those clusters.
-    for (int iter = 0; iter < MAX_ITER; iter++) {
-        repopulateClusters(clusters, units, maxSize);
-        computeNewCentroids(clusters);
+    std::vector<int> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    m_cellCentroids.resize(m_clusters.size());
+    for (int c = 0; c < (int)m_clusters.size(); c++) {
+        m_cellCentroids[next[cells[c]]++] = c;
+    }
+}
+
+int UnitClusterer::findClosestCluster(bw::Position pos, int& distance) const {
+    int cellX = toCell(pos.x, m_gridWidth, CELL_SIZE);
+    int cellY = toCell(pos.y, m_gridHeight, CELL_SIZE);
+
+    int minCluster = -1;
+    distance = INT_MAX;
+
+    // Search rings of cells around the position's cell, going outwards. Every centroid
+    // beyond a ring is farther than the ring's inner radius, so we can stop once we've
+    // found one that is closer than that.
+    int maxRing = std::max(m_gridWidth, m_gridHeight);
+    for (int ring = 0; ring <= maxRing; ring++) {
+        for (int y = cellY - ring; y <= cellY + ring; y++) {
+            if (y < 0 || y >= m_gridHeight) {
+                continue;
+            }
+
+            // Only the top and bottom rows of the ring are full. The other rows just have
+            // a cell on either side.
+            bool isEdge = y == cellY - ring || y == cellY + ring;
+            int step = isEdge ? 1 : std::max(ring * 2, 1);
+
+            for (int x = cellX - ring; x <= cellX + ring; x += step) {
+                if (x < 0 || x >= m_gridWidth) {
+                    continue;
+                }
+
+                int cell = y * m_gridWidth + x;
+                for (int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+                    int cluster = m_cellCentroids[i];
+
+                    // If this cluster is already full, we can't assign any units to it.
+                    if (m_sizes[cluster] >= m_maxSize) {
+                        continue;
+                    }
+
+                    int dist = getSquaredDistance(m_clusters[cluster].centroid, pos);
+                    if (dist < distance || (dist == distance && cluster < minCluster)) {
+                        minCluster = cluster;
+                        distance = dist;
+                    }
+                }
+            }
+        }
+
+        int radius = ring * CELL_SIZE;
+        if (minCluster >= 0 && distance <= radius * radius) {
+            break;
+        }
+    }
+
+    return minCluster;
+}
+
+void UnitClusterer::buildClusterSets() {
+    // Only the sets of clusters whose units changed need to be rebuilt.
+    for (int c = 0; c < (int)m_clusters.size(); c++) {
+        if (m_changed[c]) {
+            m_clusters[c].units.clear();
+        }
+    }
+
+    for (int i = 0; i < (int)m_units.size(); i++) {
+        int cluster = m_assignment[i];
+        if (cluster >= 0 && m_changed[cluster]) {
+            m_clusters[cluster].units.insert(m_units[i]);
+        }
     }
 
-    return clusters;
-}
\ No newline at end of file
+    std::fill(m_changed.begin(), m_changed.end(), false);
+}
+
+std::vector<Cluster> findUnitClusters(const bw::Unitset& units, int desiredSize, int maxSize) {
+    UnitClusterer clusterer(desiredSize, maxSize);
+    return clusterer.update(units);
+}
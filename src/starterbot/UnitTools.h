@@ -3,6 +3,9 @@
 #include "Tools.h"
 
 #include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 // Gets the squared distance between two positions, which avoids the use of a potentially
@@ -26,13 +29,105 @@ bool hasUnitInRectangle(const bw::Unitset& units, bw::Position topLeft, bw::Posi
 
 bw::Unit getClosestUnit(const bw::Unitset& units, bw::Position pos);
 
+// Like getClosestUnit(), but measures the distance a ground unit would have to walk using
+// bw::Game::getGroundDistance(). Units that can't be reached by ground are ignored.
+bw::Unit getClosestUnitByGround(const bw::Unitset& units, bw::Position pos);
+
 struct Cluster {
     bw::Unitset units;
     bw::Position centroid;
 };
 
-// Takes a set of units and groups them into clusters of units that are close together,
-// using a modified non-stochastic version of the k-means++ algorithm that allows
-// specifying an optional maximum size for unit clusters.
+// Groups a set of units into clusters of units that are close together, using a modified
+// non-stochastic version of the k-means++ algorithm that allows specifying an optional
+// maximum size for unit clusters. Units without a valid position, such as ones inside a
+// transport, aren't part of any cluster.
+//
+// The clustering is kept between calls to update(), so that each call starts from the
+// previous centroids and only reassigns units that are new, moved more than a tile since
+// they were last assigned, or belong to a cluster whose centroid moved that far. The
+// members are kept in flat arrays indexed alongside each other, and the nearest centroid
+// to a unit is looked up in a coarse grid of centroids rather than by checking them all.
+class UnitClusterer {
+private:
+    // How far a unit or centroid has to move for its units to be reassigned.
+    static constexpr int MOVE_THRESHOLD = 32;
+    // The maximum number of times the centroids are refined per update.
+    static constexpr int MAX_ITER = 5;
+    // The side length of a cell of the centroid grid in pixels.
+    static constexpr int CELL_SIZE = 256;
+
+    int m_desiredSize;
+    int m_maxSize;
+
+    // The units being clustered and, for each, its position as of its last assignment and
+    // the index of its cluster, or -1 if it hasn't been assigned yet.
+    std::vector<bw::Unit> m_units;
+    std::vector<bw::Position> m_positions;
+    std::vector<int> m_assignment;
+    std::unordered_map<bw::Unit, int> m_index;
+
+    // The clusters, with the number of units in each and whether its unit set needs to be
+    // rebuilt from the assignments.
+    std::vector<Cluster> m_clusters;
+    std::vector<int> m_sizes;
+    std::vector<bool> m_changed;
+
+    // The centroid grid, with the indices of the centroids in each cell stored contiguously
+    // starting at m_cellStart of the cell.
+    int m_gridWidth = 0;
+    int m_gridHeight = 0;
+    std::vector<int> m_cellStart;
+    std::vector<int> m_cellCentroids;
+
+    // Scratch arrays reused between updates.
+    std::vector<bw::Position> m_current;
+    std::vector<uint8_t> m_seen;
+    std::vector<int> m_reassign;
+
+public:
+    UnitClusterer(int desiredSize, int maxSize = INT_MAX);
+
+    // Brings the clustering up to date with a new set of units and their positions.
+    const std::vector<Cluster>& update(const bw::Unitset& units);
+
+    const std::vector<Cluster>& getClusters() const {
+        return m_clusters;
+    }
+
+    // Takes a unit out of the clustering and out of its cluster's unit set right away,
+    // leaving the centroids to the next update.
+    void remove(bw::Unit unit);
+
+    // Forgets all the units and clusters, so the next update starts from scratch.
+    void clear();
+
+private:
+    // Removes the units that aren't in the set and adds the new ones, unassigned.
+    void updateMembers(const bw::Unitset& units);
+    // Unassigns a unit and moves the last unit into its place, keeping the arrays
+    // contiguous.
+    void removeMember(int member);
+    // Adds or removes clusters to match the number of units, returning whether any were.
+    bool updateClusterCount();
+    void addCentroids(int count);
+
+    void unassign(int member);
+    void assign(int member, int cluster);
+
+    // Assigns each unit in m_reassign to the closest cluster that isn't full, with the
+    // units closest to their clusters going first.
+    void reassignUnits();
+    // Moves each centroid to the average position of its units, returning the indices of
+    // the clusters whose centroid moved by more than MOVE_THRESHOLD.
+    std::vector<int> computeCentroids();
+
+    void buildGrid();
+    int findClosestCluster(bw::Position pos, int& distance) const;
+
+    void buildClusterSets();
+};
+
+// Takes a set of units and clusters them once, without keeping the clustering around.
 std::vector<Cluster> findUnitClusters(
     const bw::Unitset& units, int desiredSize, int maxSize = INT_MAX);
\ No newline at end of file